@@ -2,83 +2,104 @@
 #ifndef communication_H
 #define communication_H
 #include <sst/core/event.h>
+#include <sst/core/output.h>
+#include <vector>
+#include "WireFormat.h"
+#include "CommunicationTypes.h"
 
-/**
- * @brief Enum for the type of messages in the simulation. 
- * 
- */
-enum MessageTypes {
-	MESSAGE,	/**< Type for messages which are stored in a node's queue or consumed. */
-};
+constexpr int LOG_FIELDS = 8; //!< Number of Log members that are serialized.
 
 /**
- * @brief Enum for the status type of a status message that a node sends out. 
- * 
+ * @brief Write the members of a Log record as zigzag varints (see WireFormat.h). The
+ * idle and blocked start times go out as their distance to the record's time, -1 for
+ * NOT_BLOCKED, so they stay small.
+ *
+ * @param buf Room for LOG_FIELDS * wire::MAX_VARINT_BYTES bytes.
+ * @return Number of bytes written.
  */
-enum StatusTypes {
-	SENDING,	/**< Type for nodes that are able to send messages. */
-	WAITING,	/**< Type for nodes that are unable to send messages. */
-};
+inline uint8_t packLog(const Log &log, uint8_t *buf) {
+	int64_t blocked = log.blocked_since == NOT_BLOCKED ? -1 : (int64_t)log.time - log.blocked_since;
+	int64_t fields[LOG_FIELDS] = { (int64_t)log.time - log.idle_since, log.node_status, blocked, log.node_id, log.stuck, log.delivered, log.queue_size, (int64_t)log.time };
+	return wire::packFields(buf, fields, LOG_FIELDS);
+}
 
 /**
- * @brief Message structure. Contains information regarding message source/destination, status of sending node, and type of message.
- * 
+ * @brief Read back a Log record written by packLog.
+ *
+ * @param log Set to the record. Left as it was if the buffer is cut short.
+ * @return false if the buffer ends before the last field.
  */
-struct Message {
-	int source_id;	/**< ID for node that the message originates from. */
-	int dest_id;	/**< ID for node that the message is destined to. */
-	StatusTypes status;		/**< Status of node that passes the message along. Only used when the message type is STATUS.*/
-	MessageTypes type;		/**< Type of message. */
-};
+inline bool unpackLog(const uint8_t *buf, int len, Log &log) {
+	int64_t fields[LOG_FIELDS] = {};
+	if (!wire::unpackFields(buf, len, fields, LOG_FIELDS)) {
+		return false;
+	}
+	log = { fields[7] - fields[0], (int)fields[1], fields[2] < 0 ? NOT_BLOCKED : fields[7] - fields[2], (int)fields[3], (int)fields[4], (int)fields[5], (int)fields[6], (uint64_t)fields[7] };
+	return true;
+}
 
 /**
- * @brief CreditProbe structure. Contains information containing how much space is left in a node's queue.
+ * @brief Base of the events sent over the ring links. In a bidirectional ring a port
+ * receives both messages and credits, and the kind set by the constructor tells them
+ * apart without RTTI. The kind is not serialized, deserialization constructs the right
+ * class.
  * 
  */
-struct CreditProbe {
-	int credits;	/**< Amount of free space in the node's queue. */
-};
+class RingEvent : public SST::Event {
 
-/**
- * @brief Log Structure. Contains logging information that is sent to central logging node. 
- * 
- */
-struct Log {
-	int idle_time; /**< Amount of cycle the node has been idle. */
-	int node_status; /**< Status of node (Idle/Executing). */
-	int num_requests; /**< Number of requests for queue resource a node has made since it last sent a message. */
-	int node_id; /**< ID of node that sent the log data */
+public:
+	/**
+	 * @brief Which event class the event is.
+	 */
+	enum Kinds { MESSAGE_EVENT, CREDIT_EVENT };
+
+	Kinds kind; //!< Kinds value.
+
+protected:
+	RingEvent(Kinds kind) :
+		Event(),
+		kind(kind)
+	{}
 };
 
 /**
  * @brief Custom event type that handles Message structures. 
  * 
  */
-class MessageEvent : public SST::Event {
+class MessageEvent : public RingEvent {
 
 public:
 		
 	/**
 	 * @brief Serialize members of the Message struct. 
+	 * All members are packed into one 64-bit word (see WireFormat.h), followed by the
+	 * generation time if there is one.
 	 * 
 	 * @param ser Wrapper class for objects to declare the order in which their members are serialized/deserialized.
 	 */
 	void serialize_order(SST::Core::Serialization::serializer &ser) override {
 		Event::serialize_order(ser);
-		ser & msg.source_id;  
-		ser & msg.dest_id;
-		ser & msg.status;
-		ser & msg.type;
+		uint64_t word = 0;
+		if (ser.mode() != SST::Core::Serialization::serializer::UNPACK) {
+			word = packHeader(msg);
+		}
+		ser & word;
+		if (ser.mode() == SST::Core::Serialization::serializer::UNPACK) {
+			msg = unpackHeader(word);
+		}
+		if (wire::flagsOf(word) & wire::TIME_FLAG) {
+			ser & msg.born;
+		}
 	}
 
 	
 	MessageEvent(Message msg) :
-		Event(),
+		RingEvent(MESSAGE_EVENT),
 		msg(msg)
 	{}
 
 	
-	MessageEvent() {} // For serialization
+	MessageEvent() : RingEvent(MESSAGE_EVENT) {} // For serialization
 
 	Message msg; // Data type handled by event.
 
@@ -89,26 +110,35 @@ public:
  * @brief Custom event type that handles CreditProbe structures. 
  * 
  */
-class CreditEvent : public SST::Event {
+class CreditEvent : public RingEvent {
 
 public:
 	
 	/**
 	 * @brief Serialize members of the Credit Probe struct. 
+	 * Packed into one int, the direction in the low bit.
 	 * 
 	 * @param ser Wrapper class for objects to declare the order in which their members are serialized/deserialized.
 	 */
 	void serialize_order(SST::Core::Serialization::serializer &ser) override {
 		Event::serialize_order(ser);
-		ser & probe.credits;
+		int packed = 0;
+		if (ser.mode() != SST::Core::Serialization::serializer::UNPACK) {
+			packed = probe.credits << 1 | probe.direction;
+		}
+		ser & packed;
+		if (ser.mode() == SST::Core::Serialization::serializer::UNPACK) {
+			probe.credits = packed >> 1;
+			probe.direction = (Directions)(packed & 1);
+		}
 	}
 
 	CreditEvent(CreditProbe probe) :
-		Event(),
+		RingEvent(CREDIT_EVENT),
 		probe(probe)
 	{}
 
-	CreditEvent() {} // For serialization
+	CreditEvent() : RingEvent(CREDIT_EVENT) {} // For serialization
 
 	CreditProbe probe; // Data type handled by event.
 
@@ -116,6 +146,85 @@ public:
 
 };
 
+/**
+ * @brief Event a component sends to itself over a self link to be woken up at a set time.
+ * 
+ */
+class TimerEvent : public SST::Event {
+
+public:
+	TimerEvent() : Event() {}
+
+	ImplementSerializable(TimerEvent); // For serialization.
+};
+
+/**
+ * @brief Custom event type the logger sends to the victim node of a deadlock.
+ * 
+ */
+class RecoveryEvent : public SST::Event {
+
+public:
+
+	/**
+	 * @brief Serialize members of the Recovery struct.
+	 * 
+	 * @param ser Wrapper class for objects to declare the order in which their members are serialized/deserialized.
+	 */
+	void serialize_order(SST::Core::Serialization::serializer &ser) override {
+		Event::serialize_order(ser);
+		int policy = recovery.policy;
+		ser & policy;
+		ser & recovery.messages;
+		ser & recovery.node_id;
+		recovery.policy = (RecoveryPolicies)policy;
+	}
+
+	RecoveryEvent(Recovery recovery) :
+		Event(),
+		recovery(recovery)
+	{}
+
+	RecoveryEvent() {} // For serialization
+
+	Recovery recovery; // Data type handled by event.
+
+	ImplementSerializable(RecoveryEvent); // For serialization.
+};
+
+/**
+ * @brief Custom event type the loggers exchange over the summary tree. Up the tree it
+ * carries a subtree's Summary whenever it changes, down the tree the ring-wide Summary
+ * the root declared deadlock on.
+ * 
+ */
+class SummaryEvent : public SST::Event {
+
+public:
+
+	/**
+	 * @brief Serialize members of the Summary struct.
+	 * 
+	 * @param ser Wrapper class for objects to declare the order in which their members are serialized/deserialized.
+	 */
+	void serialize_order(SST::Core::Serialization::serializer &ser) override {
+		Event::serialize_order(ser);
+		ser & summary.idle_since;
+		ser & summary.blocked_since;
+	}
+
+	SummaryEvent(Summary summary) :
+		Event(),
+		summary(summary)
+	{}
+
+	SummaryEvent() {} // For serialization
+
+	Summary summary; // Data type handled by event.
+
+	ImplementSerializable(SummaryEvent); // For serialization.
+};
+
 // Custom event type that handles logging info meant for the log node.
 class LogEvent : public SST::Event {
 
@@ -123,14 +232,22 @@ public:
 
 	/**
 	 * @brief Serialize members of the Log struct. 
+	 * Members are written as a length byte followed by zigzag varints (see WireFormat.h).
 	 * 
 	 * @param ser Wrapper class for objects to declare the order in which their members are serialized/deserialized.
 	 */
 	void serialize_order(SST::Core::Serialization::serializer &ser) override {
 		Event::serialize_order(ser);
-		ser & log.idle_time;
-		ser & log.node_status;
-		ser & log.num_requests;
+		uint8_t buf[LOG_FIELDS * wire::MAX_VARINT_BYTES];
+		uint8_t len = 0;
+		if (ser.mode() != SST::Core::Serialization::serializer::UNPACK) {
+			len = packLog(log, buf);
+		}
+		ser & len;
+		ser.raw(buf, len);
+		if (ser.mode() == SST::Core::Serialization::serializer::UNPACK && !unpackLog(buf, len, log)) {
+			SST::Output::getDefaultObject().fatal(CALL_INFO, -1, "Truncated Log record of %d bytes\n", len);
+		}
 	}
 
 	LogEvent(Log log) :
@@ -145,4 +262,50 @@ public:
 	ImplementSerializable(LogEvent); // For serialization.
 };
 
+/**
+ * @brief Log records of several nodes taken on the same tick, sent by a segment
+ * component to its logger instead of one LogEvent per node.
+ * 
+ */
+class LogBatchEvent : public SST::Event {
+
+public:
+
+	/**
+	 * @brief Serialize the records. Each is written as in LogEvent, a length byte
+	 * followed by zigzag varints.
+	 * 
+	 * @param ser Wrapper class for objects to declare the order in which their members are serialized/deserialized.
+	 */
+	void serialize_order(SST::Core::Serialization::serializer &ser) override {
+		Event::serialize_order(ser);
+		std::vector<uint8_t> bytes;
+		if (ser.mode() != SST::Core::Serialization::serializer::UNPACK) {
+			uint8_t buf[LOG_FIELDS * wire::MAX_VARINT_BYTES];
+			for (const Log &log : logs) {
+				uint8_t len = packLog(log, buf);
+				bytes.push_back(len);
+				bytes.insert(bytes.end(), buf, buf + len);
+			}
+		}
+		ser & bytes;
+		if (ser.mode() == SST::Core::Serialization::serializer::UNPACK) {
+			logs.clear();
+			for (size_t n = 0; n < bytes.size(); n += 1 + bytes[n]) {
+				Log log;
+				if (n + 1 + bytes[n] > bytes.size() || !unpackLog(&bytes[n + 1], bytes[n], log)) {
+					SST::Output::getDefaultObject().fatal(CALL_INFO, -1, "Truncated Log record in a batch of %zu bytes\n", bytes.size());
+				}
+				logs.push_back(log);
+			}
+		}
+	}
+
+	LogBatchEvent() {} // Also for serialization
+
+	std::vector<Log> logs; // Data type handled by event.
+
+	ImplementSerializable(LogBatchEvent); // For serialization.
+};
+
 #endif
\ No newline at end of file
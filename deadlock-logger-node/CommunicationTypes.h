@@ -0,0 +1,134 @@
+/// \file
+#ifndef communicationtypes_H
+#define communicationtypes_H
+
+#include <cstdint>
+#include "WireFormat.h"
+
+/**
+ * @brief Enum for the type of messages in the simulation. 
+ * 
+ */
+enum MessageTypes {
+	MESSAGE,	/**< Type for messages which are stored in a node's queue or consumed. */
+	ESCAPE,		/**< Type for a message rerouted by deadlock recovery. Passed on outside the queues and credits until its destination consumes it. */
+};
+
+/**
+ * @brief Enum for the status type of a status message that a node sends out. 
+ * 
+ */
+enum StatusTypes {
+	SENDING,	/**< Type for nodes that are able to send messages. */
+	WAITING,	/**< Type for nodes that are unable to send messages. */
+};
+
+/**
+ * @brief Enum for the way a message travels around the ring.
+ * 
+ */
+enum Directions {
+	FORWARD,	/**< To the next node, (node_id + 1) % total_nodes. */
+	REVERSE,	/**< To the previous node. Only in a bidirectional ring. */
+};
+
+/**
+ * @brief Enum for how a bidirectional ring picks the direction of a new message.
+ * 
+ */
+enum RoutingModes {
+	ROUTE_FORWARD,	/**< Unidirectional ring, every message goes forward. */
+	ROUTE_SHORTEST,	/**< The direction with fewer hops, forward on a tie. */
+	ROUTE_ADAPTIVE,	/**< The direction with fewer hops, unless only the other one has credits. Ties go to the one with more credits. */
+};
+
+constexpr uint64_t UNTIMED = UINT64_MAX; //!< born of a message whose generation time is not measured.
+
+/**
+ * @brief Message structure. Contains information regarding message source/destination, status of sending node, and type of message.
+ * 
+ */
+struct Message {
+	int source_id;	/**< ID for node that the message originates from. */
+	int dest_id;	/**< ID for node that the message is destined to. */
+	StatusTypes status;		/**< Status of node that passes the message along. Only used when the message type is STATUS.*/
+	MessageTypes type;		/**< Type of message. */
+	Directions direction;	/**< Way the message travels, picked once by its source. */
+	uint64_t born;	/**< Time the message was generated at in ps, UNTIMED if not measured. For its latency. */
+};
+
+/**
+ * @brief Pack the header of a Message into one word (see WireFormat.h). The generation
+ * time does not fit and is only flagged, so untimed messages stay one word.
+ */
+inline uint64_t packHeader(const Message &msg) {
+	uint32_t flags = (msg.direction == REVERSE ? wire::REVERSE_FLAG : 0) | (msg.born != UNTIMED ? wire::TIME_FLAG : 0);
+	return wire::packMessage(msg.source_id, msg.dest_id, msg.status, msg.type, flags);
+}
+
+/**
+ * @brief Unpack a Message header written by packHeader. The generation time is UNTIMED.
+ */
+inline Message unpackHeader(uint64_t word) {
+	Message msg = { (int)wire::sourceOf(word), (int)wire::destOf(word), (StatusTypes)wire::statusOf(word), (MessageTypes)wire::typeOf(word) };
+	msg.direction = wire::flagsOf(word) & wire::REVERSE_FLAG ? REVERSE : FORWARD;
+	msg.born = UNTIMED;
+	return msg;
+}
+
+/**
+ * @brief CreditProbe structure. Contains information containing how much space is left in a node's queue.
+ * 
+ */
+struct CreditProbe {
+	int credits;	/**< Amount of free space in the node's queue. */
+	Directions direction;	/**< Queue the credits are for. REVERSE credits go to the next node. */
+};
+
+/**
+ * @brief Enum for what a node does with its queue when the logger picks it to resolve a deadlock.
+ * 
+ */
+enum RecoveryPolicies {
+	RECOVER_DROP,		/**< Drop the message at the top of the queue. */
+	RECOVER_REROUTE,	/**< Send the message at the top of the queue on to its destination as an ESCAPE message. */
+	RECOVER_DRAIN,		/**< Move messages to a recovery buffer that is sent out before anything else. */
+};
+
+/**
+ * @brief Recovery structure. Sent by the logger to the victim of a deadlock.
+ * 
+ */
+struct Recovery {
+	RecoveryPolicies policy; /**< What the victim does with its queue. */
+	int messages; /**< Number of messages to drain, 0 for the whole queue. Only used with RECOVER_DRAIN. */
+	int node_id; /**< ID of the victim. Picks the node within a segment component. */
+};
+
+constexpr int64_t NOT_BLOCKED = INT64_MAX; //!< blocked_since of a node that had credits on every tick since it last sent.
+
+/**
+ * @brief Log Structure. Contains logging information that is sent to central logging node. 
+ * 
+ */
+struct Log {
+	int64_t idle_since; /**< Simulated time in ps the node's current idle run started at. Only meaningful while node_status is Idle. */
+	int node_status; /**< Status of node (Idle/Executing). */
+	int64_t blocked_since; /**< Simulated time in ps of the first tick without credits since the node last sent, NOT_BLOCKED if there was none. */
+	int node_id; /**< ID of node that sent the log data */
+	int stuck; /**< 1 if the node can not send on its next tick: it has no credits and the top of its queue is not for the next node. */
+	int delivered; /**< Number of messages the node has consumed as their destination. */
+	int queue_size; /**< Number of messages in the node's queue. */
+	uint64_t time; /**< Simulated time the record was taken at in ps. Lets the logger line up records that arrive with different delays. */
+};
+
+/**
+ * @brief Summary structure. What a logger tells its parent about a set of partitions for the ring-wide deadlock check (see Reduction.h).
+ * 
+ */
+struct Summary {
+	int64_t idle_since; /**< Latest time in ps one of the nodes went idle at, NOT_BLOCKED if one of them is executing. */
+	int64_t blocked_since; /**< Latest blocked_since of the nodes in ps, NOT_BLOCKED if one of them is not blocked. */
+};
+
+#endif
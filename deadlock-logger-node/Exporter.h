@@ -0,0 +1,285 @@
+/// \file
+#ifndef exporter_H
+#define exporter_H
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Fifo.h"
+
+/**
+ * @brief Aggregates of one logger at one of its ticks, as published to the exporter's readers.
+ */
+struct ExportSample {
+	static constexpr int IDLE_BUCKETS = 12; //!< Idle histogram buckets: 0, 1, 2-3, 4-7, ... and 1024 or more.
+
+	/**
+	 * @brief State of the deadlock predictor.
+	 */
+	enum PredictorStates { PREDICTOR_OFF, PREDICTOR_CLEAR, PREDICTOR_ALARM, PREDICTOR_UNAVOIDABLE };
+
+	uint64_t time;		/**< Simulated time in ps. */
+	uint64_t cycle;		/**< Logger cycle, continued from a restored snapshot. */
+	int first_node;		/**< ID of the first monitored node. Tells the loggers of a partitioned ring apart. */
+	int nodes;			/**< Number of monitored nodes. */
+	int blocked;		/**< Idle nodes that requested to send, as in the blocked_nodes statistic. */
+	int stuck;			/**< Nodes that can not send on their next tick. */
+	int over_threshold;	/**< Idle nodes past both deadlock thresholds. */
+	int64_t queued;		/**< Messages in the monitored nodes' queues. */
+	int idle_max;		/**< Longest idle run in cycles. */
+	double idle_mean;	/**< Mean idle run in cycles. */
+	int idle[IDLE_BUCKETS];	/**< Number of nodes per idle bucket. */
+	int predictor;		/**< PredictorStates value. */
+	int stalled_run;	/**< Consecutive logger cycles without progress, as the predictor counts them. */
+	bool deadlocked;	/**< Whether the logger detected deadlock. */
+	uint64_t recoveries;	/**< Recovery requests sent. */
+
+	/**
+	 * @brief Bucket of an idle run: 0 for 0 cycles, else 1 + floor(log2(idle)), capped.
+	 */
+	static int bucket(int idle) {
+		int b = 0;
+		while (idle > 0 && b < IDLE_BUCKETS - 1) {
+			idle >>= 1;
+			b++;
+		}
+		return b;
+	}
+};
+
+/**
+ * @brief Publishes logger aggregates as JSON lines on a local UNIX-domain socket while the
+ * simulation runs.
+ *
+ * Loggers hand samples to publish(), which copies them into a bounded queue and returns;
+ * when the queue is full the oldest sample is dropped. A background thread formats the
+ * samples and writes them to every connected reader with non-blocking sends. Each reader
+ * has a bounded output buffer, and lines that do not fit are dropped for that reader, so a
+ * slow or stalled reader costs the simulation nothing. Readers that disconnect are
+ * forgotten. The loggers of one process share the socket; samples carry first_node. SST-free.
+ */
+class TelemetryExporter {
+
+public:
+	static constexpr size_t CLIENT_BUFFER = 1 << 16; //!< Bytes buffered per reader before lines are dropped for it.
+
+	static TelemetryExporter& instance() {
+		static TelemetryExporter exporter;
+		return exporter;
+	}
+
+	~TelemetryExporter() { stop(); }
+
+	/**
+	 * @brief Announce a publisher. The first one opens the socket and starts the thread.
+	 *
+	 * @param path Path of the socket. An existing socket file is replaced.
+	 * @param capacity Samples the queue holds before the oldest is dropped.
+	 * @return false if the socket could not be opened.
+	 */
+	bool acquire(const std::string &path, size_t capacity) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (users++ > 0) {
+			return true;
+		}
+		sockaddr_un addr = {};
+		addr.sun_family = AF_UNIX;
+		if (path.size() >= sizeof(addr.sun_path)) {
+			users--;
+			return false;
+		}
+		strcpy(addr.sun_path, path.c_str());
+		unlink(path.c_str());
+		listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listener < 0 || bind(listener, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 8) != 0) {
+			if (listener >= 0) {
+				close(listener);
+			}
+			listener = -1;
+			users--;
+			return false;
+		}
+		fcntl(listener, F_SETFL, O_NONBLOCK);
+		socketPath = path;
+		this->capacity = capacity;
+		running = true;
+		worker = std::thread(&TelemetryExporter::run, this);
+		return true;
+	}
+
+	/**
+	 * @brief Give up a publisher. The last one sends out the queued samples and closes the socket.
+	 */
+	void release() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (users == 0 || --users > 0) {
+				return;
+			}
+		}
+		stop();
+	}
+
+	/**
+	 * @brief Queue a sample for the readers. Never waits for them.
+	 */
+	void publish(const ExportSample &sample) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (queue.size() >= capacity && !queue.empty()) {
+				queue.pop();
+				dropped++;
+			}
+			queue.push(sample);
+		}
+		wake.notify_one();
+	}
+
+	/**
+	 * @brief Samples dropped because the queue was full.
+	 */
+	uint64_t getDropped() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return dropped;
+	}
+
+private:
+	/**
+	 * @brief Connection of one reader.
+	 */
+	struct Client {
+		int fd;				/**< Socket of the reader. */
+		std::string out;	/**< Lines not yet sent. */
+	};
+
+	TelemetryExporter() {}
+
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			running = false;
+		}
+		wake.notify_one();
+		if (worker.joinable()) {
+			worker.join();
+		}
+		if (listener >= 0) {
+			close(listener);
+			unlink(socketPath.c_str());
+			listener = -1;
+		}
+	}
+
+	/**
+	 * @brief Background thread. Accepts readers and sends them the queued samples.
+	 */
+	void run() {
+		std::vector<ExportSample> batch;
+		bool more = true;
+		while (more) {
+			uint64_t droppedSoFar;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait_for(lock, std::chrono::milliseconds(100), [this] { return !queue.empty() || !running; });
+				while (!queue.empty()) {
+					batch.push_back(queue.front());
+					queue.pop();
+				}
+				more = running;
+				droppedSoFar = dropped;
+			}
+			accept();
+			for (const ExportSample &s : batch) {
+				std::string line = format(s, droppedSoFar);
+				for (Client &c : clients) {
+					if (c.out.size() + line.size() <= CLIENT_BUFFER) {
+						c.out += line;
+					}
+				}
+			}
+			batch.clear();
+			flush();
+		}
+		for (Client &c : clients) {
+			close(c.fd);
+		}
+		clients.clear();
+	}
+
+	/**
+	 * @brief Take every pending connection.
+	 */
+	void accept() {
+		int fd;
+		while ((fd = ::accept(listener, NULL, NULL)) >= 0) {
+			fcntl(fd, F_SETFL, O_NONBLOCK);
+			clients.push_back({ fd, std::string() });
+		}
+	}
+
+	/**
+	 * @brief Send what each reader will take without blocking, and forget closed readers.
+	 */
+	void flush() {
+		for (size_t i = 0; i < clients.size();) {
+			Client &c = clients[i];
+			ssize_t sent = c.out.empty() ? 0 : send(c.fd, c.out.data(), c.out.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+			if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+				close(c.fd);
+				clients.erase(clients.begin() + i);
+				continue;
+			}
+			if (sent > 0) {
+				c.out.erase(0, sent);
+			}
+			++i;
+		}
+	}
+
+	/**
+	 * @brief One JSON line of a sample.
+	 *
+	 * @param s Sample to format.
+	 * @param dropped Samples dropped from the queue so far.
+	 */
+	static std::string format(const ExportSample &s, uint64_t dropped) {
+		static const char *predictorNames[] = { "off", "clear", "alarm", "unavoidable" };
+		char buf[1024];
+		int n = snprintf(buf, sizeof(buf),
+			"{\"time_ps\": %llu, \"cycle\": %llu, \"first_node\": %d, \"nodes\": %d, \"blocked\": %d, \"stuck\": %d, \"over_threshold\": %d, \"queued\": %lld, "
+			"\"idle\": {\"mean\": %.2f, \"max\": %d, \"buckets\": [",
+			(unsigned long long)s.time, (unsigned long long)s.cycle, s.first_node, s.nodes, s.blocked, s.stuck, s.over_threshold, (long long)s.queued, s.idle_mean, s.idle_max);
+		for (int b = 0; b < ExportSample::IDLE_BUCKETS; ++b) {
+			n += snprintf(buf + n, sizeof(buf) - n, b ? ", %d" : "%d", s.idle[b]);
+		}
+		snprintf(buf + n, sizeof(buf) - n, "]}, \"predictor\": \"%s\", \"stalled_run\": %d, \"deadlocked\": %s, \"recoveries\": %llu, \"dropped\": %llu}\n",
+			predictorNames[s.predictor], s.stalled_run, s.deadlocked ? "true" : "false", (unsigned long long)s.recoveries, (unsigned long long)dropped);
+		return buf;
+	}
+
+	std::mutex mutex; //!< Guards users, queue, running and dropped. Held only to copy samples in or out.
+	std::condition_variable wake; //!< Signals the thread that samples are queued or that it should stop.
+	Fifo<ExportSample> queue; //!< Samples not yet formatted, at most capacity.
+	size_t capacity = 0; //!< Bound of the queue.
+	uint64_t dropped = 0; //!< Samples dropped because the queue was full.
+	int users = 0; //!< Publishers that acquired the exporter.
+	bool running = false; //!< Cleared to stop the thread.
+
+	std::thread worker; //!< Background thread.
+	int listener = -1; //!< Listening socket, -1 when closed.
+	std::string socketPath; //!< Path of the listening socket.
+	std::vector<Client> clients; //!< Connected readers. Only used by the thread.
+};
+
+#endif
@@ -0,0 +1,73 @@
+/// \file
+#ifndef fifo_H
+#define fifo_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief First-in first-out queue over a ring buffer.
+ *
+ * Same interface as the parts of std::queue the model uses. Unlike std::deque, which
+ * allocates a map and a block when it is constructed, an empty Fifo allocates nothing,
+ * so idle nodes of a large ring cost only the object itself. The buffer doubles when
+ * full and never shrinks, so a queue that reached its maximum size does not allocate
+ * again. SST-free.
+ *
+ * @tparam T Element type. Copyable and default constructible.
+ */
+template <class T>
+class Fifo {
+
+public:
+	bool empty() const { return count == 0; }
+	size_t size() const { return count; }
+
+	T &front() { return buf[head]; }
+	const T &front() const { return buf[head]; }
+
+	/**
+	 * @brief Append an element at the back.
+	 */
+	void push(const T &value) {
+		if (count == buf.size()) {
+			grow();
+		}
+		buf[(head + count) & (buf.size() - 1)] = value;
+		count++;
+	}
+
+	/**
+	 * @brief Remove the element at the front. The queue must not be empty.
+	 */
+	void pop() {
+		head = (head + 1) & (buf.size() - 1);
+		count--;
+	}
+
+	/**
+	 * @brief Element i from the front, 0 being the front.
+	 */
+	const T &operator[](size_t i) const { return buf[(head + i) & (buf.size() - 1)]; }
+
+private:
+	static constexpr size_t MIN_CAPACITY = 4; //!< Capacity of the first allocation.
+
+	/**
+	 * @brief Double the capacity, moving the elements to the start of the new buffer.
+	 */
+	void grow() {
+		std::vector<T> bigger(buf.empty() ? MIN_CAPACITY : buf.size() * 2);
+		for (size_t i = 0; i < count; ++i) {
+			bigger[i] = (*this)[i];
+		}
+		buf.swap(bigger);
+		head = 0;
+	}
+
+	std::vector<T> buf; //!< Elements, the capacity is zero or a power of two.
+	size_t head = 0; //!< Index of the front element.
+	size_t count = 0; //!< Number of elements.
+};
+
+#endif
@@ -0,0 +1,161 @@
+/// \file
+#ifndef predictor_H
+#define predictor_H
+
+#include <algorithm>
+#include <vector>
+
+/**
+ * @brief Early warning of deadlock from the trend of the logger's records.
+ *
+ * Fed the logger's arrays of the nodes' latest records once per logger tick. Tracks the
+ * fraction of nodes that are stuck (no credits and nothing the next node would consume),
+ * a smoothed derivative of that fraction, and the run length of ticks in which no node
+ * made progress. An alarm is raised when most nodes are stuck, the fraction is not
+ * falling and nothing has moved for a while. Deadlock is unavoidable once every node is
+ * stuck and nothing has moved for longer than a credit takes to arrive, since a node
+ * only gets credits back when the next node sends. SST-free.
+ */
+class DeadlockPredictor {
+
+public:
+	/**
+	 * @brief What the latest tick tells about the monitored nodes.
+	 */
+	enum Verdict {
+		CLEAR,			/**< No sign of deadlock. */
+		ALARM,			/**< Deadlock is likely. */
+		UNAVOIDABLE,	/**< Every node is stuck for good. */
+	};
+
+	/**
+	 * @brief Set up the predictor. Must be called before update.
+	 *
+	 * @param nodes Number of monitored nodes.
+	 * @param alarmFraction Fraction of stuck nodes that raises the alarm.
+	 * @param alarmRun Ticks without progress that raise the alarm.
+	 * @param confirmRun Ticks without progress, with every node stuck, after which deadlock
+	 * is unavoidable. Must cover the link latency and the longest node tick period.
+	 */
+	void configure(int nodes, double alarmFraction, int alarmRun, int confirmRun) {
+		this->alarmFraction = alarmFraction;
+		this->alarmRun = alarmRun;
+		this->confirmRun = confirmRun;
+		this->nodes = nodes;
+		lastIdle.assign(nodes, 0);
+		firstStep.assign(nodes, -1);
+		firstStepIdle.assign(nodes, 0);
+		lastStep.assign(nodes, -1);
+	}
+
+	/**
+	 * @brief Add one logger tick. Every array holds one value per monitored node.
+	 *
+	 * @param state Node state (Idle/Executing) of the latest records.
+	 * @param idle Consecutive cycles idle.
+	 * @param stuck Whether the node can not send on its next tick.
+	 * @return Verdict of this tick.
+	 */
+	Verdict update(const int *state, const int *idle, const int *stuck) {
+		int stuckNodes = 0;
+		bool progress = false;
+		for (int i = 0; i < nodes; ++i) {
+			stuckNodes += stuck[i] ? 1 : 0;
+			// A node made progress if it sent since its last record or its idle count restarted.
+			if (state[i] != 0 || idle[i] < lastIdle[i]) {
+				progress = true;
+			}
+		}
+		double fraction = nodes ? (double)stuckNodes / nodes : 0;
+		trend += TREND_WEIGHT * ((fraction - stuckFraction) - trend);
+		stuckFraction = fraction;
+
+		if (progress) {
+			stalledRun = 0;
+			std::fill(firstStep.begin(), firstStep.end(), -1);
+			std::fill(lastStep.begin(), lastStep.end(), -1);
+		} else {
+			stalledRun++;
+			// Ticks at which the idle counts stepped, to measure each node's tick period.
+			for (int i = 0; i < nodes; ++i) {
+				if (idle[i] > lastIdle[i]) {
+					if (firstStep[i] < 0) {
+						firstStep[i] = stalledRun;
+						firstStepIdle[i] = idle[i];
+					}
+					lastStep[i] = stalledRun;
+				}
+			}
+		}
+		std::copy(idle, idle + nodes, lastIdle.begin());
+
+		if (stuckNodes == nodes && stalledRun >= confirmRun) {
+			return UNAVOIDABLE;
+		}
+		if (fraction >= alarmFraction && trend >= 0 && stalledRun >= alarmRun) {
+			return ALARM;
+		}
+		return CLEAR;
+	}
+
+	/**
+	 * @brief Estimate the logger ticks until the thresholds of log::tick are met. A stuck
+	 * node's counts grow by one every node tick, so its period is measured between the
+	 * steps of its idle count since progress stopped.
+	 *
+	 * @return Ticks until every node exceeds both thresholds, or -1 if a node that still
+	 * has to reach them has not stepped twice yet.
+	 */
+	int ticksToThresholds(const int *idle, const int *requests, int idleThreshold, int requestThreshold) const {
+		int ticks = 0;
+		for (int i = 0; i < nodes; ++i) {
+			int needed = std::max({ idleThreshold + 1 - idle[i], requestThreshold + 1 - requests[i], 0 });
+			if (needed == 0) {
+				continue;
+			}
+			int steps = idle[i] - firstStepIdle[i];
+			if (firstStep[i] < 0 || steps <= 0) {
+				return -1;
+			}
+			int span = lastStep[i] - firstStep[i];
+			ticks = std::max(ticks, (needed * span + steps - 1) / steps - (stalledRun - lastStep[i]));
+		}
+		return ticks;
+	}
+
+	double getStuckFraction() const { return stuckFraction; }
+	double getTrend() const { return trend; }
+	int getStalledRun() const { return stalledRun; }
+
+	/**
+	 * @brief Applies `ser & member` to the predictor's state, for snapshots.
+	 */
+	template <class Serializer>
+	void serialize(Serializer &ser) {
+		ser & stuckFraction;
+		ser & trend;
+		ser & stalledRun;
+		ser & lastIdle;
+		ser & firstStep;
+		ser & firstStepIdle;
+		ser & lastStep;
+	}
+
+private:
+	static constexpr double TREND_WEIGHT = 0.25; //!< Weight of the newest difference in the smoothed derivative.
+
+	double alarmFraction = 1; //!< Fraction of stuck nodes that raises the alarm.
+	int alarmRun = 0; //!< Ticks without progress that raise the alarm.
+	int confirmRun = 0; //!< Ticks without progress, with every node stuck, that make deadlock unavoidable.
+	int nodes = 0; //!< Number of monitored nodes.
+
+	double stuckFraction = 0; //!< Fraction of nodes stuck on the last tick.
+	double trend = 0; //!< Smoothed change of stuckFraction per tick.
+	int stalledRun = 0; //!< Consecutive ticks without progress.
+	std::vector<int> lastIdle; //!< Idle count of every node on the last tick.
+	std::vector<int> firstStep; //!< Stalled tick of each node's first idle count step, -1 before it.
+	std::vector<int> firstStepIdle; //!< Idle count at the first step.
+	std::vector<int> lastStep; //!< Stalled tick of each node's latest idle count step.
+};
+
+#endif
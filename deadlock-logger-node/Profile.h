@@ -0,0 +1,258 @@
+/// \file
+#ifndef profile_H
+#define profile_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief Read the time stamp counter. Falls back to the steady clock in ns on other architectures.
+ */
+inline uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * @brief Per-handler call counts and wall-clock time, and per-port event counts of one component.
+ *
+ * Disabled profilers cost one branch per handler call. Times are measured in TSC cycles
+ * and converted to ns with a rate calibrated against the steady clock over the run.
+ */
+class Profiler {
+
+public:
+	/**
+	 * @brief Call count and time spent in one handler. Times include nested handlers.
+	 */
+	struct Handler {
+		std::string name;	/**< Handler name. */
+		uint64_t calls;		/**< Number of calls. */
+		uint64_t cycles;	/**< Cumulative time in TSC cycles. */
+		uint64_t max;		/**< Longest single call in TSC cycles. */
+	};
+
+	/**
+	 * @brief Start profiling and the calibration of the cycle rate. The counters are only
+	 * allocated here, so components that do not profile carry no more than the object.
+	 *
+	 * @param handlers Names of the handlers, indexed by the ids passed to ProfileScope.
+	 * @param ports Names of the ports, indexed by the ids passed to countSend.
+	 */
+	void enable(const std::vector<std::string> &handlers, const std::vector<std::string> &ports) {
+		for (const std::string &name : handlers) {
+			this->handlers.push_back({ name, 0, 0, 0 });
+		}
+		this->ports = ports;
+		sends.assign(ports.size(), 0);
+		enabled = true;
+		startCycles = readCycles();
+		startTime = std::chrono::steady_clock::now();
+	}
+
+	bool isEnabled() const { return enabled; }
+
+	/**
+	 * @brief Add one call of a handler.
+	 */
+	void add(int handler, uint64_t cycles) {
+		Handler &h = handlers[handler];
+		h.calls++;
+		h.cycles += cycles;
+		if (cycles > h.max) {
+			h.max = cycles;
+		}
+	}
+
+	/**
+	 * @brief Count one event sent on a port.
+	 */
+	void countSend(int port) {
+		if (enabled) {
+			sends[port]++;
+		}
+	}
+
+	/**
+	 * @brief Nanoseconds per cycle, calibrated from enable() until now.
+	 */
+	double nsPerCycle() const {
+		uint64_t cycles = readCycles() - startCycles;
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+		return cycles > 0 ? ns / cycles : 1.0;
+	}
+
+	const std::vector<Handler> &getHandlers() const { return handlers; }
+
+	/**
+	 * @brief JSON object with the profile of one component.
+	 *
+	 * @param component Name of the component.
+	 * @param type Component type, used to merge profiles of the same type.
+	 */
+	std::string toJson(const std::string &component, const std::string &type) const {
+		double scale = nsPerCycle();
+		std::string json = "{\"component\": \"" + escape(component) + "\", \"type\": \"" + type + "\", \"handlers\": {";
+		for (size_t i = 0; i < handlers.size(); ++i) {
+			char buf[256];
+			snprintf(buf, sizeof(buf), "%s\"%s\": {\"calls\": %llu, \"total_ns\": %.0f, \"max_ns\": %.0f}", i ? ", " : "",
+				handlers[i].name.c_str(), (unsigned long long)handlers[i].calls, handlers[i].cycles * scale, handlers[i].max * scale);
+			json += buf;
+		}
+		json += "}, \"sends\": {";
+		for (size_t i = 0; i < ports.size(); ++i) {
+			json += (i ? ", \"" : "\"") + ports[i] + "\": " + std::to_string(sends[i]);
+		}
+		return json + "}}";
+	}
+
+	/**
+	 * @brief Escape a string for use inside a JSON string.
+	 */
+	static std::string escape(const std::string &s) {
+		std::string out;
+		for (char c : s) {
+			if (c == '"' || c == '\\') {
+				out += '\\';
+			}
+			out += c;
+		}
+		return out;
+	}
+
+private:
+	bool enabled = false; //!< Whether handler calls are recorded.
+	std::vector<Handler> handlers; //!< Per-handler counters.
+	std::vector<std::string> ports; //!< Port names.
+	std::vector<uint64_t> sends; //!< Events sent per port.
+	uint64_t startCycles = 0; //!< TSC at enable().
+	std::chrono::steady_clock::time_point startTime; //!< Steady clock at enable().
+};
+
+/**
+ * @brief Times one handler call for as long as it is in scope.
+ */
+class ProfileScope {
+
+public:
+	ProfileScope(Profiler &profiler, int handler) :
+		profiler(profiler.isEnabled() ? &profiler : nullptr),
+		handler(handler),
+		start(this->profiler ? readCycles() : 0)
+	{}
+
+	~ProfileScope() {
+		if (profiler) {
+			profiler->add(handler, readCycles() - start);
+		}
+	}
+
+private:
+	Profiler *profiler; //!< Profiler to report to. NULL when profiling is disabled.
+	int handler; //!< Handler being timed.
+	uint64_t start; //!< TSC when the scope was entered.
+};
+
+/**
+ * @brief Merges the profiles of every component in this process into one JSON file.
+ *
+ * Components register while they are constructed and submit their profile in finish().
+ * The file is written when the last registered component has submitted.
+ */
+class ProfileCollector {
+
+public:
+	static ProfileCollector& instance() {
+		static ProfileCollector collector;
+		return collector;
+	}
+
+	/**
+	 * @brief Announce a component that will submit a profile.
+	 */
+	void expect() {
+		std::lock_guard<std::mutex> lock(mutex);
+		expected++;
+	}
+
+	/**
+	 * @brief Add a component's profile. Writes the merged file once every component has submitted.
+	 *
+	 * @param component Name of the component.
+	 * @param type Component type.
+	 * @param profiler The component's profiler.
+	 * @param path File to write the merged profile to.
+	 * @return false if writing the merged file failed.
+	 */
+	bool submit(const std::string &component, const std::string &type, const Profiler &profiler, const std::string &path) {
+		std::lock_guard<std::mutex> lock(mutex);
+		components.push_back(profiler.toJson(component, type));
+		double scale = profiler.nsPerCycle();
+		for (const Profiler::Handler &h : profiler.getHandlers()) {
+			Total &t = totals[type + "." + h.name];
+			t.calls += h.calls;
+			t.ns += h.cycles * scale;
+			if (h.max * scale > t.max_ns) {
+				t.max_ns = h.max * scale;
+			}
+		}
+		if (++submitted < expected) {
+			return true;
+		}
+		return write(path);
+	}
+
+private:
+	/**
+	 * @brief Totals of one handler over every component of a type.
+	 */
+	struct Total {
+		uint64_t calls = 0;
+		double ns = 0;
+		double max_ns = 0;
+	};
+
+	ProfileCollector() {}
+
+	bool write(const std::string &path) const {
+		mkdir("output", 0755);
+		FILE *f = fopen(path.c_str(), "w");
+		if (!f) {
+			return false;
+		}
+		fprintf(f, "{\n\"totals\": {");
+		const char *sep = "\n";
+		for (const auto &t : totals) {
+			fprintf(f, "%s  \"%s\": {\"calls\": %llu, \"total_ns\": %.0f, \"max_ns\": %.0f}", sep, t.first.c_str(), (unsigned long long)t.second.calls, t.second.ns, t.second.max_ns);
+			sep = ",\n";
+		}
+		fprintf(f, "\n},\n\"components\": [");
+		sep = "\n";
+		for (const std::string &c : components) {
+			fprintf(f, "%s  %s", sep, c.c_str());
+			sep = ",\n";
+		}
+		fprintf(f, "\n]\n}\n");
+		return fclose(f) == 0;
+	}
+
+	std::mutex mutex; //!< Guards everything below. Components on different threads finish concurrently.
+	int expected = 0; //!< Components that registered.
+	int submitted = 0; //!< Components that submitted.
+	std::vector<std::string> components; //!< JSON object of every submitted component.
+	std::map<std::string, Total> totals; //!< Totals keyed by "type.handler".
+};
+
+#endif
@@ -0,0 +1,351 @@
+/// \file
+#ifndef record_H
+#define record_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "CommunicationTypes.h"
+
+/**
+ * @brief Kinds of recorded deliveries. The numbering is part of the file format read by
+ * standalone/replay and tools/recorddecode.py.
+ */
+enum RecordKinds : uint8_t {
+	RECORD_MESSAGE,		/**< MessageEvent. payload: packHeader word, extra: generation time. */
+	RECORD_CREDIT,		/**< CreditEvent. payload: credits << 1 | direction. */
+	RECORD_RECOVERY,	/**< RecoveryEvent from the logger. payload: policy, extra: messages. */
+	RECORD_END,			/**< Last record of a stream. time: end of the run. */
+};
+
+/**
+ * @brief Port a recorded event arrived on.
+ */
+enum RecordPorts : uint8_t {
+	RECORD_PREV,	/**< prevPort, from the previous node. */
+	RECORD_NEXT,	/**< nextPort, from the next node. */
+	RECORD_LOG,		/**< logPort, from the logger. */
+};
+
+/**
+ * @brief One event delivered to a node.
+ */
+struct DeliveryRecord {
+	uint64_t time;		/**< Delivery time in ps. */
+	int node;			/**< ID of the receiving node. */
+	uint8_t kind;		/**< RecordKinds value. */
+	uint8_t port;		/**< RecordPorts value. */
+	uint64_t payload;	/**< Event contents, see RecordKinds. */
+	uint64_t extra;		/**< Second word of the contents, 0 if unused. */
+
+	bool operator==(const DeliveryRecord &o) const {
+		return time == o.time && node == o.node && kind == o.kind && port == o.port && payload == o.payload && extra == o.extra;
+	}
+	bool operator!=(const DeliveryRecord &o) const { return !(*this == o); }
+};
+
+/**
+ * @brief Record of a Message arriving at a node. Forward messages come in on prevPort,
+ * REVERSE ones on nextPort.
+ */
+inline DeliveryRecord messageRecord(uint64_t time, int node, const Message &msg) {
+	return { time, node, RECORD_MESSAGE, msg.direction == REVERSE ? RECORD_NEXT : RECORD_PREV, packHeader(msg), msg.born != UNTIMED ? msg.born : 0 };
+}
+
+/**
+ * @brief Record of credits arriving at a node. Forward credits come in on nextPort,
+ * REVERSE ones on prevPort.
+ */
+inline DeliveryRecord creditRecord(uint64_t time, int node, int credits, Directions direction) {
+	return { time, node, RECORD_CREDIT, direction == REVERSE ? RECORD_PREV : RECORD_NEXT, (uint64_t)credits << 1 | direction, 0 };
+}
+
+/**
+ * @brief Record of a recovery request arriving at a node.
+ */
+inline DeliveryRecord recoveryRecord(uint64_t time, int node, const Recovery &recovery) {
+	return { time, node, RECORD_RECOVERY, RECORD_LOG, (uint64_t)recovery.policy, (uint64_t)recovery.messages };
+}
+
+/**
+ * @brief Message of a RECORD_MESSAGE record.
+ */
+inline Message recordedMessage(const DeliveryRecord &r) {
+	Message msg = unpackHeader(r.payload);
+	if (wire::flagsOf(r.payload) & wire::TIME_FLAG) {
+		msg.born = r.extra;
+	}
+	return msg;
+}
+
+/**
+ * @brief Append-only binary stream of delivery records.
+ *
+ * The file starts with the magic "DLRC", a uint32 format version, and the uint32 rank
+ * and thread the stream was written by. Every record follows as varints (see
+ * WireFormat.h): the time since the previous record, the node ID as a zigzag difference
+ * to the previous record's, kind | port << 2, the payload, and the extra word for
+ * messages with a generation time and for recoveries. Consecutive deliveries on one
+ * partition are close in time and node ID, so most records take 5 to 10 bytes. Records
+ * are buffered and written in blocks of whole records; a stream cut short by a crash
+ * reads up to its last complete record. close() ends the stream with a RECORD_END
+ * record. SST-free.
+ */
+class RecordWriter {
+
+public:
+	static constexpr uint32_t VERSION = 1; //!< Format version in the file header.
+	static constexpr size_t BLOCK = 1 << 16; //!< Bytes buffered before they are written out.
+
+	~RecordWriter() { close(0); }
+
+	/**
+	 * @brief Create dir/rank-<rank>-thread-<thread>.bin and write the header.
+	 *
+	 * @return false if the file could not be created.
+	 */
+	bool open(const std::string &dir, uint32_t rank, uint32_t thread) {
+		for (size_t pos = dir.find('/'); pos != std::string::npos; pos = dir.find('/', pos + 1)) {
+			mkdir(dir.substr(0, pos).c_str(), 0755);
+		}
+		mkdir(dir.c_str(), 0755);
+		file = fopen((dir + "/rank-" + std::to_string(rank) + "-thread-" + std::to_string(thread) + ".bin").c_str(), "wb");
+		if (!file) {
+			return false;
+		}
+		uint32_t header[3] = { VERSION, rank, thread };
+		fwrite("DLRC", 1, 4, file);
+		fwrite(header, sizeof(header), 1, file);
+		buf.reserve(BLOCK + MAX_RECORD_BYTES);
+		return true;
+	}
+
+	/**
+	 * @brief Append a record. Times must not decrease, as on one SST partition.
+	 */
+	void write(const DeliveryRecord &r) {
+		uint8_t *p = grow();
+		int n = wire::putVarint(p, r.time - lastTime);
+		n += wire::putVarint(p + n, wire::zigzag((int64_t)r.node - lastNode));
+		p[n++] = r.kind | r.port << 2;
+		n += wire::putVarint(p + n, r.payload);
+		if (hasExtra(r.kind, r.payload)) {
+			n += wire::putVarint(p + n, r.extra);
+		}
+		buf.resize(buf.size() - MAX_RECORD_BYTES + n);
+		lastTime = r.time;
+		lastNode = r.node;
+		records++;
+		if (buf.size() >= BLOCK) {
+			flush();
+		}
+	}
+
+	/**
+	 * @brief Write the RECORD_END record and close the file. Does nothing if it is not open.
+	 *
+	 * @param end Simulated time the run ended at in ps.
+	 * @return false if writing failed.
+	 */
+	bool close(uint64_t end) {
+		if (!file) {
+			return true;
+		}
+		write({ end < lastTime ? lastTime : end, (int)lastNode, RECORD_END, RECORD_PREV, 0, 0 });
+		flush();
+		bool ok = !ferror(file);
+		ok = fclose(file) == 0 && ok;
+		file = NULL;
+		return ok;
+	}
+
+	uint64_t getRecords() const { return records; }
+
+	/**
+	 * @brief Whether a record of this kind carries the extra word.
+	 */
+	static bool hasExtra(uint8_t kind, uint64_t payload) {
+		return kind == RECORD_RECOVERY || (kind == RECORD_MESSAGE && (wire::flagsOf(payload) & wire::TIME_FLAG));
+	}
+
+private:
+	static constexpr int MAX_RECORD_BYTES = 4 * wire::MAX_VARINT_BYTES + 1; //!< Longest encoded record.
+
+	/**
+	 * @brief Make room for one record at the end of the buffer.
+	 */
+	uint8_t *grow() {
+		size_t n = buf.size();
+		buf.resize(n + MAX_RECORD_BYTES);
+		return buf.data() + n;
+	}
+
+	void flush() {
+		fwrite(buf.data(), 1, buf.size(), file);
+		buf.clear();
+	}
+
+	FILE *file = NULL; //!< Open stream, NULL when closed.
+	std::vector<uint8_t> buf; //!< Encoded records not yet written.
+	uint64_t lastTime = 0; //!< Time of the previous record.
+	int64_t lastNode = 0; //!< Node of the previous record.
+	uint64_t records = 0; //!< Records written, including RECORD_END.
+};
+
+/**
+ * @brief Reads a stream written by RecordWriter.
+ */
+class RecordReader {
+
+public:
+	/**
+	 * @brief Read the whole file into memory and check its header.
+	 *
+	 * @return false if the file could not be read or is not a record stream.
+	 */
+	bool open(const std::string &path) {
+		FILE *f = fopen(path.c_str(), "rb");
+		if (!f) {
+			return false;
+		}
+		data.clear();
+		uint8_t chunk[1 << 16];
+		size_t n;
+		while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+			data.insert(data.end(), chunk, chunk + n);
+		}
+		fclose(f);
+		if (data.size() < HEADER_BYTES || std::string(data.begin(), data.begin() + 4) != "DLRC") {
+			return false;
+		}
+		uint32_t header[3];
+		memcpy(header, data.data() + 4, sizeof(header));
+		version = header[0];
+		rank = header[1];
+		thread = header[2];
+		pos = HEADER_BYTES;
+		lastTime = 0;
+		lastNode = 0;
+		return version == RecordWriter::VERSION;
+	}
+
+	/**
+	 * @brief Decode the next record.
+	 *
+	 * @return false at the end of the stream, or at a record cut short.
+	 */
+	bool next(DeliveryRecord &r) {
+		const uint8_t *p = data.data() + pos;
+		int left = data.size() - pos;
+		uint64_t dt, node;
+		int n = 0, read;
+		if ((read = wire::getVarint(p, left, dt)) == 0) {
+			return false;
+		}
+		n += read;
+		if ((read = wire::getVarint(p + n, left - n, node)) == 0 || n + read >= left) {
+			return false;
+		}
+		n += read;
+		r.time = lastTime + dt;
+		r.node = lastNode + wire::unzigzag(node);
+		r.kind = p[n] & 3;
+		r.port = p[n++] >> 2;
+		if ((read = wire::getVarint(p + n, left - n, r.payload)) == 0) {
+			return false;
+		}
+		n += read;
+		r.extra = 0;
+		if (RecordWriter::hasExtra(r.kind, r.payload)) {
+			if ((read = wire::getVarint(p + n, left - n, r.extra)) == 0) {
+				return false;
+			}
+			n += read;
+		}
+		pos += n;
+		lastTime = r.time;
+		lastNode = r.node;
+		return true;
+	}
+
+	uint32_t rank = 0; //!< Rank that wrote the stream.
+	uint32_t thread = 0; //!< Thread that wrote the stream.
+
+private:
+	static constexpr size_t HEADER_BYTES = 16; //!< Magic, version, rank and thread.
+
+	std::vector<uint8_t> data; //!< Contents of the file.
+	size_t pos = 0; //!< Offset of the next record.
+	uint32_t version = 0; //!< Format version of the file.
+	uint64_t lastTime = 0; //!< Time of the previous record.
+	int64_t lastNode = 0; //!< Node of the previous record.
+};
+
+/**
+ * @brief One RecordWriter per partition (rank and thread) of this process, shared by
+ * every component of the partition.
+ *
+ * Components open their partition's stream while they are constructed and release it in
+ * finish(); the stream is closed by the last release. Only components of the same thread
+ * write to a stream, so writing takes no lock.
+ */
+class RecordStreams {
+
+public:
+	static RecordStreams& instance() {
+		static RecordStreams streams;
+		return streams;
+	}
+
+	/**
+	 * @brief Stream of a partition, opened on first use.
+	 *
+	 * @return NULL if the file could not be created.
+	 */
+	RecordWriter *acquire(const std::string &dir, uint32_t rank, uint32_t thread) {
+		std::lock_guard<std::mutex> lock(mutex);
+		Stream &s = streams[thread];
+		if (s.users == 0 && !s.writer.open(dir, rank, thread)) {
+			return NULL;
+		}
+		s.users++;
+		return &s.writer;
+	}
+
+	/**
+	 * @brief Give up a stream. The last user closes it.
+	 *
+	 * @param end Simulated time the run ended at in ps.
+	 * @return false if closing the stream failed.
+	 */
+	bool release(RecordWriter *writer, uint64_t end) {
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto &s : streams) {
+			if (&s.second.writer == writer && --s.second.users == 0) {
+				return s.second.writer.close(end);
+			}
+		}
+		return true;
+	}
+
+private:
+	/**
+	 * @brief Stream of one thread and its number of users.
+	 */
+	struct Stream {
+		RecordWriter writer;
+		int users = 0;
+	};
+
+	RecordStreams() {}
+
+	std::mutex mutex; //!< Guards streams. Components on different threads start and finish concurrently.
+	std::map<uint32_t, Stream> streams; //!< Stream of every thread, keyed by thread number.
+};
+
+#endif
@@ -0,0 +1,123 @@
+/// \file
+#ifndef reduction_H
+#define reduction_H
+
+#include <algorithm>
+#include <vector>
+#include "CommunicationTypes.h"
+
+/**
+ * @brief A logger's place in the tree that combines the partitions' deadlock summaries.
+ *
+ * Every partition's logger reduces its segment to a Summary: the latest time one of its
+ * nodes went idle at and the latest time one of them was first blocked at, so the whole
+ * segment has been idle and blocked since then. A logger combines its own summary with
+ * those of its children by taking the later of each time, and passes the result on to
+ * its parent only when it changes. The root ends up with the summary of the whole ring
+ * and applies the thresholds to it. That is the logger's per-node condition over every
+ * node, since a node is over the thresholds from idle_since + idle_threshold and
+ * blocked_since + request_threshold on. A moving ring sends no summaries, and the root's
+ * cost grows with its children rather than with the nodes. SST-free.
+ */
+class SummaryTree {
+
+public:
+	/**
+	 * @brief Summary of nodes that are not all stuck.
+	 */
+	static Summary moving() { return { NOT_BLOCKED, NOT_BLOCKED }; }
+
+	/**
+	 * @brief Set up the tree node. Must be called before the other members.
+	 *
+	 * @param children Number of child loggers.
+	 */
+	void configure(int children) {
+		local = moving();
+		sent = moving();
+		this->children.assign(children, moving());
+	}
+
+	/**
+	 * @brief Summary of a segment from the logger's arrays.
+	 *
+	 * @param state Node state (Idle/Executing) of the latest records.
+	 * @param idleSince Start time of each node's idle run.
+	 * @param blockedSince First blocked time of each node, NOT_BLOCKED if it is not blocked.
+	 * @param nodes Number of nodes in the arrays.
+	 */
+	static Summary summarize(const int *state, const int64_t *idleSince, const int64_t *blockedSince, int nodes) {
+		Summary s = { INT64_MIN, INT64_MIN };
+		for (int i = 0; i < nodes; ++i) {
+			s.idle_since = std::max(s.idle_since, state[i] == 0 ? idleSince[i] : NOT_BLOCKED);
+			s.blocked_since = std::max(s.blocked_since, blockedSince[i]);
+		}
+		return s;
+	}
+
+	/**
+	 * @brief Summary of the nodes of both summaries.
+	 */
+	static Summary combine(const Summary &a, const Summary &b) {
+		return { std::max(a.idle_since, b.idle_since), std::max(a.blocked_since, b.blocked_since) };
+	}
+
+	/**
+	 * @brief Whether every summarized node was idle, and idle and blocked for longer than
+	 * the thresholds, at the given time.
+	 *
+	 * @param s Summary of the nodes.
+	 * @param asOf Time in ps the summary is known to hold until.
+	 * @param idleThreshold Idle time in ps.
+	 * @param requestThreshold Blocked time in ps.
+	 */
+	static bool over(const Summary &s, int64_t asOf, int64_t idleThreshold, int64_t requestThreshold) {
+		return s.idle_since != NOT_BLOCKED && asOf - s.idle_since > idleThreshold
+			&& s.blocked_since != NOT_BLOCKED && asOf - s.blocked_since > requestThreshold;
+	}
+
+	/**
+	 * @brief Take this logger's own segment summary.
+	 */
+	void setLocal(const Summary &s) { local = s; }
+
+	/**
+	 * @brief Take the latest summary of a child's subtree.
+	 *
+	 * @param child Index of the child.
+	 * @param s Summary the child sent.
+	 */
+	void setChild(int child, const Summary &s) { children[child] = s; }
+
+	/**
+	 * @brief Summary of this logger's segment and every child subtree.
+	 */
+	Summary subtree() const {
+		Summary s = local;
+		for (const Summary &c : children) {
+			s = combine(s, c);
+		}
+		return s;
+	}
+
+	/**
+	 * @brief Whether the subtree summary changed since it was last passed on.
+	 *
+	 * @param s Set to the subtree summary, to be sent to the parent, when it changed.
+	 */
+	bool takeUpdate(Summary &s) {
+		s = subtree();
+		if (s.idle_since == sent.idle_since && s.blocked_since == sent.blocked_since) {
+			return false;
+		}
+		sent = s;
+		return true;
+	}
+
+private:
+	Summary local; //!< Summary of this logger's segment.
+	Summary sent; //!< Subtree summary last passed on to the parent.
+	std::vector<Summary> children; //!< Latest subtree summary of every child.
+};
+
+#endif
@@ -0,0 +1,401 @@
+/// \file
+#ifndef ringnode_H
+#define ringnode_H
+
+#include <cstdint>
+#include <cstdlib>
+#include "Fifo.h"
+#include "CommunicationTypes.h"
+
+#define IDLE 0
+#define EXECUTING 1
+
+/**
+ * @brief Queue and credit logic of a ring node, independent of SST.
+ *
+ * Used by the SST node component and by the standalone driver in standalone/, so both
+ * run exactly the same model. The caller delivers ticks, messages and credits and the
+ * core answers through the Port policy.
+ *
+ * In a bidirectional ring the node also has a queue and credits for the reverse
+ * direction. Every message keeps the direction its source picked, so the two directions
+ * form two rings that share the nodes' ticks.
+ *
+ * @tparam Port Provides injectMessage(const Message&) for new messages,
+ * forwardMessage(const Message&) for queued and ESCAPE messages, both sent to the next node, or
+ * the previous one for REVERSE messages, sendCredits(int) to return credits to the
+ * previous node, sendReverseCredits(int) to return reverse credits to the next node,
+ * and now() for the current time in ps.
+ * @tparam Rng Provides nextUniform() and generateNextInt32() with the semantics of
+ * SST::RNG::MarsagliaRNG.
+ */
+template <class Port, class Rng>
+class RingNode {
+
+public:
+	/**
+	 * @brief What happened to a message delivered to the node.
+	 */
+	enum Outcome {
+		QUEUED,		/**< Added to the queue to be forwarded. */
+		CONSUMED,	/**< The node was its destination. */
+		DROPPED,	/**< The queue was full. */
+		ESCAPED,	/**< An ESCAPE message for another node, passed on. */
+	};
+
+	/**
+	 * @brief Set up the node. Must be called before any other member.
+	 *
+	 * @param port Policy the node sends through.
+	 * @param rng Random number generator used to inject messages.
+	 * @param id ID of the node.
+	 * @param nodes Number of nodes in the ring.
+	 * @param maxSize Maximum size of the node's queue.
+	 * @param gen Probability that a message is generated on a tick.
+	 */
+	void configure(Port *port, Rng *rng, int id, int nodes, int maxSize, float gen) {
+		this->port = port;
+		this->rng = rng;
+		node_id = id;
+		total_nodes = nodes;
+		queueMaxSize = maxSize;
+		message_gen = gen;
+	}
+
+	/**
+	 * @brief Pick how messages travel. Anything but ROUTE_FORWARD makes the ring
+	 * bidirectional. Must be called before the first tick, on every node alike.
+	 */
+	void setRouting(RoutingModes mode) {
+		routing = mode;
+	}
+
+	/**
+	 * @brief Stamp generated messages with their generation time, for the latency. A timed
+	 * message takes a second word on the wire.
+	 */
+	void setTiming(bool on) {
+		timed = on;
+	}
+
+	/**
+	 * @brief Whether the node sends in both directions.
+	 */
+	bool bidirectional() const { return routing != ROUTE_FORWARD; }
+
+	/**
+	 * @brief Credits to announce to the previous node for the current queue size.
+	 */
+	int freeCredits() const { return queueMaxSize - (int)msgqueue.size(); }
+
+	/**
+	 * @brief Credits to announce to the next node for the current reverse queue size.
+	 */
+	int freeReverseCredits() const { return queueMaxSize - (int)reverseQueue.size(); }
+
+	/**
+	 * @brief Messages queued in both directions.
+	 */
+	int queued() const { return (int)(msgqueue.size() + reverseQueue.size()); }
+
+	/**
+	 * @brief Whether the node can not send on its next tick: it has no credits and the
+	 * top of its recovery buffer, or else of its queue, is not for the next node. Only
+	 * credits from the next node can change this. In a bidirectional ring the same has to
+	 * hold for the reverse direction.
+	 */
+	bool stuck() const {
+		if (!recoveryBuffer.empty()) {
+			const Message &top = recoveryBuffer.front();
+			return top.direction == REVERSE ? reverseCredits <= 0 && top.dest_id != prevNode() : queueCredits <= 0 && top.dest_id != nextNode();
+		}
+		bool forwardStuck = queueCredits <= 0 && (msgqueue.empty() || msgqueue.front().dest_id != nextNode());
+		if (!bidirectional()) {
+			return forwardStuck;
+		}
+		return forwardStuck && reverseCredits <= 0 && (reverseQueue.empty() || reverseQueue.front().dest_id != prevNode());
+	}
+
+	/**
+	 * @brief Time in ps the node has been idle for at time now, 0 if its last tick executed.
+	 */
+	int64_t idleFor(uint64_t now) const { return node_state == IDLE ? (int64_t)now - idle_since : 0; }
+
+	/**
+	 * @brief Time in ps since the first tick without credits since the node last sent,
+	 * -1 if there was none.
+	 */
+	int64_t blockedFor(uint64_t now) const { return blocked_since == NOT_BLOCKED ? -1 : (int64_t)now - blocked_since; }
+
+	/**
+	 * @brief The node's behavior on every clock tick.
+	 */
+	void tick() {
+		// Idle and blocked runs are kept as the times they started at, so nothing is
+		// counted while they last.
+		if (node_state != IDLE) {
+			idle_since = port->now();
+			blocked_since = NOT_BLOCKED;
+		}
+
+		node_state = IDLE;
+
+		// Node is blocked from sending.
+		if (queueCredits <= 0 && (!bidirectional() || reverseCredits <= 0) && blocked_since == NOT_BLOCKED) {
+			blocked_since = port->now();
+		}
+		// Messages drained by a deadlock recovery go out first and hold back new messages.
+		if (!recoveryBuffer.empty()) {
+			const Message &top = recoveryBuffer.front();
+			bool reverse = top.direction == REVERSE;
+			if ((reverse ? reverseCredits : queueCredits) > 0 || top.dest_id == (reverse ? prevNode() : nextNode())) {
+				node_state = EXECUTING;
+				Message msg = top;
+				recoveryBuffer.pop();
+				forwarded++;
+				port->forwardMessage(msg);
+			}
+			generated = 0;
+			return;
+		}
+
+		// Rng and generate message to send out. A new message takes the tick's send in its direction.
+		bool reverseSent = false;
+		if (queueCredits > 0 || (bidirectional() && reverseCredits > 0)) {
+			reverseSent = addMessage();
+		}
+
+		// The reverse link sends one message per tick as well.
+		if (bidirectional() && !reverseSent && !reverseQueue.empty() && (reverseCredits > 0 || reverseQueue.front().dest_id == prevNode())) {
+			node_state = EXECUTING;
+			Message msg = reverseQueue.front();
+			reverseQueue.pop();
+			forwarded++;
+			port->forwardMessage(msg);
+			port->sendReverseCredits(freeReverseCredits());
+		}
+
+		// Send a message out every tick if the next nodes queue is not full,
+		// AND if the node has messages in its queue to send.
+		if ((generated != 1 && (queueCredits > 0 && msgqueue.size() > 0))) {
+			sendMessage();
+			port->sendCredits(freeCredits());
+		} else if (generated != 1 && !msgqueue.empty()) {
+			// Peek at the top message to see if it needs to be delivered to the next node.
+			const Message &top = msgqueue.front();
+			if (top.dest_id == nextNode()) {
+				sendMessage();
+				port->sendCredits(freeCredits());
+			}
+		}
+
+		generated = 0;
+	}
+
+	/**
+	 * @brief Handle a message from the previous node, or from the next node for REVERSE messages.
+	 * Determines if a message should be consumed or added to the node's queue.
+	 */
+	Outcome receiveMessage(const Message &msg) {
+		bool reverse = msg.direction == REVERSE;
+		Fifo<Message> &queue = reverse ? reverseQueue : msgqueue;
+		// A rerouted message bypasses the queues and credits on its way to the destination.
+		if (msg.type == ESCAPE && msg.dest_id != node_id) {
+			port->forwardMessage(msg);
+			return ESCAPED;
+		}
+		// Check if the message is meant for the node and that the node has correct space.
+		if (msg.dest_id != node_id && (int)queue.size() < queueMaxSize) {
+			queue.push(msg);
+			if (reverse) {
+				port->sendReverseCredits(freeReverseCredits());
+			} else {
+				port->sendCredits(freeCredits());
+			}
+			return QUEUED;
+		} else if (msg.dest_id == node_id) {
+			consumed++;
+			// A message to its own source goes all the way around.
+			int hops = reverse ? msg.source_id - node_id : node_id - msg.source_id;
+			hops = (hops + total_nodes - 1) % total_nodes + 1;
+			hopsConsumed += hops;
+			if (msg.born != UNTIMED) {
+				latencyConsumed += port->now() - msg.born;
+				timedConsumed++;
+			}
+			return CONSUMED;
+		}
+		dropped++;
+		return DROPPED;
+	}
+
+	/**
+	 * @brief Resolve a deadlock at this node by taking messages out of its fuller queue.
+	 * The freed space is announced to the node that fills that queue.
+	 *
+	 * @param recovery What to do with the queue.
+	 * @return Number of messages taken out of the queue.
+	 */
+	int recover(const Recovery &recovery) {
+		bool reverse = reverseQueue.size() > msgqueue.size();
+		Fifo<Message> &queue = reverse ? reverseQueue : msgqueue;
+		int taken = 0;
+		if (recovery.policy == RECOVER_DRAIN) {
+			int limit = recovery.messages > 0 ? recovery.messages : (int)queue.size();
+			while (taken < limit && !queue.empty()) {
+				recoveryBuffer.push(queue.front());
+				queue.pop();
+				taken++;
+			}
+			recoveryDrained += taken;
+		} else if (!queue.empty()) {
+			Message msg = queue.front();
+			queue.pop();
+			taken = 1;
+			if (recovery.policy == RECOVER_DROP) {
+				recoveryDropped++;
+			} else {
+				// Its destination consumes it once it arrives over the escape channel.
+				recoveryRerouted++;
+				msg.type = ESCAPE;
+				port->forwardMessage(msg);
+			}
+		}
+		if (taken > 0 && reverse) {
+			port->sendReverseCredits(freeReverseCredits());
+		} else if (taken > 0) {
+			port->sendCredits(freeCredits());
+		}
+		return taken;
+	}
+
+	/**
+	 * @brief Handle credits from the next node.
+	 */
+	void receiveCredits(int credits) {
+		queueCredits = credits;
+	}
+
+	/**
+	 * @brief Handle reverse credits from the previous node.
+	 */
+	void receiveReverseCredits(int credits) {
+		reverseCredits = credits;
+	}
+
+	Fifo<Message> msgqueue; //!< Queue that stores Message structures.
+	Fifo<Message> recoveryBuffer; //!< Messages drained from the queue by a deadlock recovery, outside the queue's capacity.
+	int queueMaxSize = 0; //!< Maximum size of node's queue.
+	int queueCredits = 0; //!< Amount of space left in the connected node's queue.
+	Fifo<Message> reverseQueue; //!< Queue of REVERSE messages, also queueMaxSize long.
+	int reverseCredits = 0; //!< Amount of space left in the previous node's reverse queue.
+	RoutingModes routing = ROUTE_FORWARD; //!< How new messages pick their direction.
+	bool timed = false; //!< Whether generated messages carry their generation time.
+	int generated = 0; //!< Lock so that if a node generates a message it will not also send out a message from its queue as well in one tick.
+
+	int node_id = 0; //!< User's ID for each node.
+	int total_nodes = 1; //!< Total number of nodes in simulation.
+
+	bool node_state = IDLE; //!< Stores what state the node is in.
+	int64_t idle_since = 0; //!< Time in ps of the first tick of the node's current idle run.
+	int64_t blocked_since = NOT_BLOCKED; //!< Time in ps of the first tick without credits since the node last sent, NOT_BLOCKED if there was none.
+
+	float message_gen = 0; //!< Probability that a message is generated by a node.
+	uint64_t rngDraws = 0; //!< Numbers drawn from rng. Replaying as many draws restores the RNG state.
+
+	uint64_t injected = 0; //!< Messages generated by the node.
+	uint64_t forwarded = 0; //!< Messages sent out of the queue.
+	uint64_t consumed = 0; //!< Messages that reached the node as their destination.
+	uint64_t dropped = 0; //!< Messages lost to a full queue.
+	uint64_t injectedReverse = 0; //!< Generated messages sent in the reverse direction.
+	uint64_t hopsConsumed = 0; //!< Sum of the hops of the consumed messages.
+	uint64_t latencyConsumed = 0; //!< Sum of the latencies of the consumed messages that carried their generation time, in ps.
+	uint64_t timedConsumed = 0; //!< Consumed messages that carried their generation time.
+	uint64_t recoveryDropped = 0; //!< Messages dropped to resolve a deadlock.
+	uint64_t recoveryRerouted = 0; //!< Messages sent on to their destination over the escape channel to resolve a deadlock.
+	uint64_t recoveryDrained = 0; //!< Messages moved to the recovery buffer to resolve a deadlock.
+
+private:
+	/**
+	 * @brief Sends a single message from the queue to the next node.
+	 */
+	void sendMessage() {
+		node_state = EXECUTING;
+		Message msg = msgqueue.front();
+		msgqueue.pop();
+		forwarded++;
+		port->forwardMessage(msg);
+	}
+
+	int nextNode() const { return (node_id + 1) % total_nodes; }
+	int prevNode() const { return (node_id + total_nodes - 1) % total_nodes; }
+
+	/**
+	 * @brief Direction of a new message to dest, or -1 if that direction has no credits.
+	 */
+	int route(int dest) const {
+		if (!bidirectional()) {
+			return FORWARD;
+		}
+		// A message to its own source goes all the way around either way.
+		int ahead = (dest - node_id + total_nodes - 1) % total_nodes + 1;
+		int behind = total_nodes - ahead;
+		if (behind == 0) {
+			behind = total_nodes;
+		}
+		Directions shorter = behind < ahead ? REVERSE : FORWARD;
+		if (routing == ROUTE_ADAPTIVE) {
+			if (ahead == behind) {
+				shorter = reverseCredits > queueCredits ? REVERSE : FORWARD;
+			}
+			Directions other = shorter == FORWARD ? REVERSE : FORWARD;
+			if (creditsOf(shorter) <= 0 && creditsOf(other) > 0) {
+				shorter = other;
+			}
+		}
+		return creditsOf(shorter) > 0 ? shorter : -1;
+	}
+
+	int creditsOf(Directions direction) const { return direction == REVERSE ? reverseCredits : queueCredits; }
+
+	/**
+	 * @brief Utilize RNG to generate a message and send it out from the node.
+	 *
+	 * @return true if the message went out in the reverse direction.
+	 */
+	bool addMessage() {
+		node_state = EXECUTING;
+		double rndNumber = rng->nextUniform();
+		rngDraws++;
+
+		if (rndNumber <= message_gen) {
+			// Generate a random destination node that exist in the simulation.
+			int rndNode = (int)(rng->generateNextInt32());
+			rngDraws++;
+			rndNode = abs((int)(rndNode % total_nodes)); // Generate a integer 0-(Total Nodes - 1)
+
+			// The shorter direction may be out of credits, then nothing is generated.
+			int direction = route(rndNode);
+			if (direction < 0) {
+				return false;
+			}
+
+			// Construct and send a message
+			Message newMsg = { node_id, rndNode, SENDING, MESSAGE, (Directions)direction, timed ? port->now() : UNTIMED };
+			injected++;
+			if (direction == REVERSE) {
+				injectedReverse++;
+				port->injectMessage(newMsg);
+				return true;
+			}
+			generated = 1;
+			port->injectMessage(newMsg);
+		}
+		return false;
+	}
+
+	Port *port = nullptr; //!< Policy messages and credits are sent through.
+	Rng *rng = nullptr; //!< Random number generator for message injection.
+};
+
+#endif
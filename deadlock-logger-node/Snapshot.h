@@ -0,0 +1,106 @@
+/// \file
+#ifndef snapshot_H
+#define snapshot_H
+
+#include <sst/core/serialization/serializer.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+/**
+ * @brief Snapshot files of component state.
+ *
+ * SST 11 has no checkpointing of its own, so components serialize their state with SST's
+ * serializer into one file per component and read it back in setup() of a later run.
+ * The serialize function is called once for sizing, once for packing and once for
+ * unpacking, in the same way as Event::serialize_order.
+ */
+namespace snapshot {
+
+/**
+ * @brief Create a directory and its parents. Existing directories are fine.
+ */
+inline void makeDirs(const std::string &dir) {
+	for (size_t pos = dir.find('/'); pos != std::string::npos; pos = dir.find('/', pos + 1)) {
+		mkdir(dir.substr(0, pos).c_str(), 0755);
+	}
+	mkdir(dir.c_str(), 0755);
+}
+
+/**
+ * @brief Serialize state into a buffer, for state taken before the file can be written.
+ *
+ * @param serialize Callable taking a serializer, applies `ser & member` to every member.
+ * @return The packed state. Buffers packed one after another unpack in a single pass.
+ */
+template <class F>
+std::vector<char> pack(F serialize) {
+	SST::Core::Serialization::serializer ser;
+	ser.start_sizing();
+	serialize(ser);
+	std::vector<char> buf(ser.size());
+	ser.start_packing(buf.data(), buf.size());
+	serialize(ser);
+	return buf;
+}
+
+/**
+ * @brief Write packed state into a snapshot file.
+ *
+ * @param dir Directory of the snapshot. Created if missing.
+ * @param name File name of the component's snapshot.
+ * @param buf State packed by pack().
+ * @return false if the file could not be written.
+ */
+inline bool writeFile(const std::string &dir, const std::string &name, const std::vector<char> &buf) {
+	makeDirs(dir);
+	FILE *f = fopen((dir + "/" + name).c_str(), "wb");
+	if (!f) {
+		return false;
+	}
+	bool ok = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+	return fclose(f) == 0 && ok;
+}
+
+/**
+ * @brief Serialize state into a snapshot file.
+ *
+ * @param dir Directory of the snapshot. Created if missing.
+ * @param name File name of the component's snapshot.
+ * @param serialize Callable taking a serializer, applies `ser & member` to every member.
+ * @return false if the file could not be written.
+ */
+template <class F>
+bool write(const std::string &dir, const std::string &name, F serialize) {
+	return writeFile(dir, name, pack(serialize));
+}
+
+/**
+ * @brief Restore state from a snapshot file written by write() or writeFile().
+ *
+ * @return false if the file could not be read.
+ */
+template <class F>
+bool read(const std::string &dir, const std::string &name, F serialize) {
+	FILE *f = fopen((dir + "/" + name).c_str(), "rb");
+	if (!f) {
+		return false;
+	}
+	std::vector<char> buf;
+	char chunk[4096];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+		buf.insert(buf.end(), chunk, chunk + n);
+	}
+	fclose(f);
+
+	SST::Core::Serialization::serializer ser;
+	ser.start_unpacking(buf.data(), buf.size());
+	serialize(ser);
+	return true;
+}
+
+} // namespace snapshot
+
+#endif
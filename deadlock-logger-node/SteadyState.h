@@ -0,0 +1,174 @@
+/// \file
+#ifndef steadystate_H
+#define steadystate_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/**
+ * @brief Detects when a run has settled into a steady state, by batch means.
+ *
+ * Every tick adds one sample of each metric. Samples are averaged over batches of a
+ * fixed number of ticks and the last few batch means form a sliding window. A metric
+ * has converged when the confidence interval of its mean over the window, and the
+ * difference between the means of the older and the newer half of the window, are both
+ * within the tolerance. The second test keeps metrics that still drift, such as queues
+ * filling up towards deadlock, from passing on a narrow interval. Metrics can also be
+ * required to have a positive mean, so a stalled run whose throughput sits at 0 does
+ * not pass as a steady state. SST-free.
+ */
+class SteadyState {
+
+public:
+	/**
+	 * @brief Mean of a metric over the window and the half width of its 95% confidence interval.
+	 */
+	struct Estimate {
+		double mean;	/**< Mean of the batch means. */
+		double half;	/**< Half width of the confidence interval. */
+		double drift;	/**< Newer half of the window minus the older half. */
+	};
+
+	/**
+	 * @brief Set up the monitor. Must be called before add.
+	 *
+	 * @param floors Per metric. A metric converges when the half width and the drift are at
+	 * most tolerance * max(|mean|, floor), so a floor of 0 makes the tolerance relative and
+	 * a floor above the mean makes it absolute.
+	 * @param positive Per metric. Whether the metric's mean over the window must be above 0
+	 * to converge, for throughputs.
+	 * @param batchTicks Ticks averaged into one batch.
+	 * @param batches Batches in the sliding window. At least 4.
+	 * @param tolerance Relative tolerance of the half width and the drift.
+	 */
+	void configure(const std::vector<double> &floors, const std::vector<bool> &positive, int batchTicks, int batches, double tolerance) {
+		this->floors = floors;
+		this->positive = positive;
+		this->positive.resize(floors.size(), false);
+		this->batchTicks = std::max(batchTicks, 1);
+		this->batches = std::max(batches, 4);
+		this->tolerance = tolerance;
+		sums.assign(floors.size(), 0);
+		means.assign(floors.size() * this->batches, 0);
+		ticks = 0;
+		completed = 0;
+	}
+
+	/**
+	 * @brief Add one tick.
+	 *
+	 * @param samples One sample per metric.
+	 * @return true if this tick completed a batch and every metric has converged.
+	 */
+	bool add(const double *samples) {
+		for (size_t m = 0; m < sums.size(); ++m) {
+			sums[m] += samples[m];
+		}
+		if (++ticks < batchTicks) {
+			return false;
+		}
+		int slot = completed % batches;
+		for (size_t m = 0; m < sums.size(); ++m) {
+			means[m * batches + slot] = sums[m] / batchTicks;
+			sums[m] = 0;
+		}
+		ticks = 0;
+		completed++;
+		return converged();
+	}
+
+	/**
+	 * @brief Whether the window is full, every metric is within the tolerance and the
+	 * metrics that must be positive are.
+	 */
+	bool converged() const {
+		if (completed < batches) {
+			return false;
+		}
+		for (size_t m = 0; m < floors.size(); ++m) {
+			Estimate e = estimate(m);
+			if (positive[m] && e.mean <= 0) {
+				return false;
+			}
+			double limit = tolerance * std::max(std::fabs(e.mean), floors[m]);
+			if (e.half > limit || std::fabs(e.drift) > limit) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Estimate of a metric over the current window.
+	 */
+	Estimate estimate(int metric) const {
+		int n = std::min(completed, batches);
+		Estimate e = { 0, 0, 0 };
+		if (n == 0) {
+			return e;
+		}
+		// Batch means from the oldest to the newest.
+		const double *window = &means[metric * batches];
+		int oldest = completed > batches ? completed % batches : 0;
+		double older = 0, newer = 0;
+		for (int k = 0; k < n; ++k) {
+			double v = window[(oldest + k) % batches];
+			e.mean += v;
+			(k < n / 2 ? older : newer) += v;
+		}
+		e.mean /= n;
+		if (n < 2) {
+			e.half = INFINITY;
+			return e;
+		}
+		e.drift = newer / (n - n / 2) - older / (n / 2);
+		double var = 0;
+		for (int k = 0; k < n; ++k) {
+			var += (window[k] - e.mean) * (window[k] - e.mean);
+		}
+		var /= n - 1;
+		e.half = tQuantile(n - 1) * std::sqrt(var / n);
+		return e;
+	}
+
+	/**
+	 * @brief Number of batches completed since configure.
+	 */
+	int getBatches() const { return completed; }
+
+	/**
+	 * @brief Applies `ser & member` to the monitor's state, for snapshots.
+	 */
+	template <class Serializer>
+	void serialize(Serializer &ser) {
+		ser & sums;
+		ser & means;
+		ser & ticks;
+		ser & completed;
+	}
+
+private:
+	/**
+	 * @brief Two sided 95% quantile of Student's t with df degrees of freedom.
+	 * First order Cornish-Fisher expansion around the normal quantile. Within 0.05 of the
+	 * exact value from 9 degrees of freedom on, somewhat narrow below that.
+	 */
+	static double tQuantile(int df) {
+		const double z = 1.959964;
+		return z + (z * z * z + z) / (4.0 * df);
+	}
+
+	std::vector<double> floors; //!< Scale floor of every metric's tolerance.
+	std::vector<bool> positive; //!< Whether every metric's mean must be above 0.
+	int batchTicks = 1; //!< Ticks per batch.
+	int batches = 4; //!< Batches in the window.
+	double tolerance = 0; //!< Relative tolerance.
+
+	std::vector<double> sums; //!< Sum of every metric over the current batch.
+	std::vector<double> means; //!< Ring of batch means, batches per metric.
+	int ticks = 0; //!< Ticks in the current batch.
+	int completed = 0; //!< Batches completed.
+};
+
+#endif
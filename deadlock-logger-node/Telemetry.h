@@ -0,0 +1,123 @@
+/// \file
+#ifndef telemetry_H
+#define telemetry_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include "CommunicationEvents.h"
+
+/**
+ * @brief Process-wide table holding the latest Log record of every node.
+ *
+ * Used instead of LogEvents when every node and logger share one process. Each node
+ * owns one cache-line sized slot and is its only writer, so nodes on different SST
+ * threads never share a line. A slot is guarded by a sequence counter: the writer
+ * bumps it to odd, stores the fields and publishes with a release store of the next
+ * even value. Readers load the counter with acquire and retry if it was odd or changed
+ * while they copied the fields.
+ */
+class TelemetryTable {
+
+public:
+	/**
+	 * @brief The table shared by all components in this process.
+	 */
+	static TelemetryTable& instance() {
+		static TelemetryTable table;
+		return table;
+	}
+
+	/**
+	 * @brief Make sure the table has a slot for every node. Safe to call from components
+	 * constructed on different threads. Must not be called once the simulation runs.
+	 *
+	 * @param total_nodes Number of nodes in the ring.
+	 * @return false if the table was already sized for a different ring.
+	 */
+	bool reserve(int total_nodes) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (slots == nullptr) {
+			// Over-allocate so the slots can start on a cache line boundary.
+			storage.reset(new char[(total_nodes + 1) * sizeof(Slot)]);
+			uintptr_t base = (reinterpret_cast<uintptr_t>(storage.get()) + CACHE_LINE - 1) & ~uintptr_t(CACHE_LINE - 1);
+			slots = reinterpret_cast<Slot*>(base);
+			for (int i = 0; i < total_nodes; ++i) {
+				new (&slots[i]) Slot();
+			}
+			size = total_nodes;
+		}
+		return size == total_nodes;
+	}
+
+	/**
+	 * @brief Publish a node's latest record. Only the node itself may call this for its slot.
+	 */
+	void publish(const Log &log) {
+		Slot &slot = slots[log.node_id];
+		uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+		slot.seq.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.idle_since.store(log.idle_since, std::memory_order_relaxed);
+		slot.node_status.store(log.node_status, std::memory_order_relaxed);
+		slot.blocked_since.store(log.blocked_since, std::memory_order_relaxed);
+		slot.stuck.store(log.stuck, std::memory_order_relaxed);
+		slot.delivered.store(log.delivered, std::memory_order_relaxed);
+		slot.queue_size.store(log.queue_size, std::memory_order_relaxed);
+		slot.time.store(log.time, std::memory_order_relaxed);
+		slot.seq.store(seq + 2, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Copy a node's latest record.
+	 *
+	 * @return false if the node has not published a record yet.
+	 */
+	bool read(int node_id, Log &log) const {
+		const Slot &slot = slots[node_id];
+		uint32_t before, after;
+		do {
+			before = slot.seq.load(std::memory_order_acquire);
+			log.idle_since = slot.idle_since.load(std::memory_order_relaxed);
+			log.node_status = slot.node_status.load(std::memory_order_relaxed);
+			log.blocked_since = slot.blocked_since.load(std::memory_order_relaxed);
+			log.stuck = slot.stuck.load(std::memory_order_relaxed);
+			log.delivered = slot.delivered.load(std::memory_order_relaxed);
+			log.queue_size = slot.queue_size.load(std::memory_order_relaxed);
+			log.time = slot.time.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = slot.seq.load(std::memory_order_relaxed);
+		} while ((before & 1) || before != after);
+		log.node_id = node_id;
+		return before != 0;
+	}
+
+private:
+	static constexpr size_t CACHE_LINE = 64; //!< Slot size and alignment.
+
+	/**
+	 * @brief One node's record, padded to a full cache line.
+	 */
+	struct alignas(CACHE_LINE) Slot {
+		std::atomic<uint32_t> seq{0}; //!< Odd while the owner is writing. 0 until the first publish.
+		std::atomic<int64_t> idle_since{0};
+		std::atomic<int> node_status{0};
+		std::atomic<int64_t> blocked_since{NOT_BLOCKED};
+		std::atomic<int> stuck{0};
+		std::atomic<int> delivered{0};
+		std::atomic<int> queue_size{0};
+		std::atomic<uint64_t> time{0};
+	};
+	static_assert(sizeof(Slot) == CACHE_LINE, "Telemetry slots must fill exactly one cache line.");
+
+	TelemetryTable() {}
+
+	std::mutex mutex; //!< Guards sizing of the table during construction.
+	std::unique_ptr<char[]> storage; //!< Backing memory for the slots.
+	Slot *slots = nullptr; //!< First cache line aligned slot in storage.
+	int size = 0; //!< Number of slots.
+};
+
+#endif
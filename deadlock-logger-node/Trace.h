@@ -0,0 +1,148 @@
+/// \file
+#ifndef trace_H
+#define trace_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <sys/stat.h>
+
+/**
+ * Highest trace level compiled in. 0 removes every trace point. Set with
+ * -DDEADLOCK_TRACE_LEVEL=n (see the release and trace targets in the Makefile).
+ */
+#ifndef DEADLOCK_TRACE_LEVEL
+#define DEADLOCK_TRACE_LEVEL 0
+#endif
+
+/**
+ * Number of records each component keeps. Older records are overwritten. Must be a power of two.
+ */
+#ifndef DEADLOCK_TRACE_CAPACITY
+#define DEADLOCK_TRACE_CAPACITY 4096
+#endif
+
+/**
+ * @brief Record a trace point if its level is compiled in.
+ *
+ * The level check is a constant expression, so a disabled trace point is dead code and
+ * none of its arguments are evaluated.
+ *
+ * @param buffer TraceBuffer to record into.
+ * @param level Level of the trace point. 1 is per tick, 2 is per message.
+ * @param ... Arguments of TraceBuffer::record.
+ */
+#define TRACE(buffer, level, ...) \
+	do { \
+		if (std::decay<decltype(buffer)>::type::enabled(level)) { \
+			(buffer).record(__VA_ARGS__); \
+		} \
+	} while (0)
+
+/**
+ * @brief Trace points. The numbering is part of the file format read by tools/tracedecode.py.
+ */
+enum TracePoint : uint16_t {
+	TRACE_TICK,			/**< Node ticked. a: queue size, b: credits, c: state. */
+	TRACE_COUNTERS,		/**< Node counters at the end of a tick. a: idle for, b: blocked for (-1 if not blocked), both in us. */
+	TRACE_MSG_RECEIVED,	/**< Message arrived. a: source, b: destination. */
+	TRACE_MSG_QUEUED,	/**< Message added to the queue. a: source, b: destination, c: queue size. */
+	TRACE_MSG_CONSUMED,	/**< Message reached its destination. a: source. */
+	TRACE_MSG_DROPPED,	/**< Message dropped by a full queue. a: source, b: destination. */
+	TRACE_MSG_GENERATED,/**< New message injected. a: destination. */
+	TRACE_MSG_SENT,		/**< Queued message forwarded. a: source, b: destination. */
+	TRACE_CREDITS_SENT,	/**< Credits returned to the previous node. a: credits. */
+	TRACE_LOG_SENT,		/**< Log record sent. a: idle for, b: state, c: blocked for (-1 if not blocked), both in us. */
+};
+
+/**
+ * @brief One trace record as stored in memory and in the trace file.
+ */
+struct TraceRecord {
+	uint64_t time;	/**< Simulated time in core cycles (ps). */
+	uint16_t point;	/**< TracePoint. */
+	uint16_t pad;	/**< Unused. */
+	int32_t a;		/**< First argument. */
+	int32_t b;		/**< Second argument. */
+	int32_t c;		/**< Third argument. */
+};
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord layout is part of the trace file format.");
+
+/**
+ * @brief Per-component binary ring buffer of trace records.
+ *
+ * @tparam MaxLevel Highest level that is recorded. Known at compile time so disabled
+ * trace points compile to nothing.
+ */
+template <int MaxLevel, uint32_t Capacity = DEADLOCK_TRACE_CAPACITY>
+class TraceBuffer {
+
+public:
+	static_assert((Capacity & (Capacity - 1)) == 0, "Trace capacity must be a power of two.");
+
+	/**
+	 * @brief Whether trace points of a level are compiled in.
+	 */
+	static constexpr bool enabled(int level) { return level <= MaxLevel; }
+
+	/**
+	 * @brief Append a record, overwriting the oldest one when full.
+	 */
+	void record(uint64_t time, TracePoint point, int32_t a = 0, int32_t b = 0, int32_t c = 0) {
+		TraceRecord &r = ring[head++ & (Capacity - 1)];
+		r.time = time;
+		r.point = point;
+		r.pad = 0;
+		r.a = a;
+		r.b = b;
+		r.c = c;
+	}
+
+	/**
+	 * @brief Write the buffered records, oldest first, to output/trace/<name>.bin.
+	 *
+	 * The file starts with the magic "DLTR", a uint32 id and a uint64 record count.
+	 *
+	 * @param name File name without directory and extension.
+	 * @param id ID of the component (node ID) stored in the header.
+	 * @return false if the file could not be written.
+	 */
+	bool dump(const std::string &name, uint32_t id) const {
+		mkdir("output", 0755);
+		mkdir("output/trace", 0755);
+		FILE *f = fopen(("output/trace/" + name + ".bin").c_str(), "wb");
+		if (!f) {
+			return false;
+		}
+		uint64_t count = head < Capacity ? head : Capacity;
+		fwrite("DLTR", 1, 4, f);
+		fwrite(&id, sizeof(id), 1, f);
+		fwrite(&count, sizeof(count), 1, f);
+		for (uint64_t i = head - count; i < head; ++i) {
+			fwrite(&ring[i & (Capacity - 1)], sizeof(TraceRecord), 1, f);
+		}
+		return fclose(f) == 0;
+	}
+
+private:
+	TraceRecord ring[Capacity]; //!< Record storage.
+	uint64_t head = 0; //!< Total number of records written.
+};
+
+/**
+ * @brief Tracing compiled out. Holds no storage.
+ */
+template <uint32_t Capacity>
+class TraceBuffer<0, Capacity> {
+
+public:
+	static constexpr bool enabled(int level) { return false; }
+	void record(uint64_t, TracePoint, int32_t = 0, int32_t = 0, int32_t = 0) {}
+	bool dump(const std::string &, uint32_t) const { return true; }
+};
+
+typedef TraceBuffer<DEADLOCK_TRACE_LEVEL> Tracer; //!< Trace buffer type used by the components.
+
+#endif
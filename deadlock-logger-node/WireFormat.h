@@ -0,0 +1,167 @@
+/// \file
+#ifndef wireformat_H
+#define wireformat_H
+
+#include <cstdint>
+
+/**
+ * @brief Packed encodings of the event payloads sent between ranks.
+ *
+ * A Message is packed into a single 64-bit word. Log records are written as a
+ * sequence of zigzag varints, so the small counters that make up most records take
+ * one byte each. Everything here is constexpr and SST-free; the static_asserts at the
+ * bottom of the file test the helpers on every build, and tests/wirecheck.py (run by
+ * make test) sends every event through its serialize_order with SST's serializer.
+ */
+namespace wire {
+
+constexpr int ID_BITS = 24;		/**< Bits for a node ID. */
+constexpr int STATUS_BITS = 1;	/**< Bits for a StatusTypes value. */
+constexpr int TYPE_BITS = 3;	/**< Bits for a MessageTypes value. */
+constexpr int FLAG_BITS = 12;	/**< Bits flagging optional words that follow the header. */
+
+constexpr int SOURCE_SHIFT = 0;
+constexpr int DEST_SHIFT = SOURCE_SHIFT + ID_BITS;
+constexpr int STATUS_SHIFT = DEST_SHIFT + ID_BITS;
+constexpr int TYPE_SHIFT = STATUS_SHIFT + STATUS_BITS;
+constexpr int FLAGS_SHIFT = TYPE_SHIFT + TYPE_BITS;
+
+static_assert(FLAGS_SHIFT + FLAG_BITS == 64, "Message header must fill exactly one 64-bit word.");
+
+constexpr int64_t MAX_NODES = int64_t(1) << ID_BITS; /**< Largest ring the Message header can address. */
+
+constexpr uint32_t REVERSE_FLAG = 1; /**< The message travels in the reverse direction. */
+constexpr uint32_t TIME_FLAG = 2; /**< A 64-bit generation time follows the header. */
+
+constexpr uint64_t mask(int bits) { return (uint64_t(1) << bits) - 1; }
+
+/**
+ * @brief Pack the fields of a Message into one word.
+ */
+constexpr uint64_t packMessage(uint32_t source_id, uint32_t dest_id, uint32_t status, uint32_t type, uint32_t flags = 0) {
+	return (uint64_t(source_id) & mask(ID_BITS)) << SOURCE_SHIFT
+		| (uint64_t(dest_id) & mask(ID_BITS)) << DEST_SHIFT
+		| (uint64_t(status) & mask(STATUS_BITS)) << STATUS_SHIFT
+		| (uint64_t(type) & mask(TYPE_BITS)) << TYPE_SHIFT
+		| (uint64_t(flags) & mask(FLAG_BITS)) << FLAGS_SHIFT;
+}
+
+constexpr uint32_t sourceOf(uint64_t word) { return uint32_t((word >> SOURCE_SHIFT) & mask(ID_BITS)); }
+constexpr uint32_t destOf(uint64_t word) { return uint32_t((word >> DEST_SHIFT) & mask(ID_BITS)); }
+constexpr uint32_t statusOf(uint64_t word) { return uint32_t((word >> STATUS_SHIFT) & mask(STATUS_BITS)); }
+constexpr uint32_t typeOf(uint64_t word) { return uint32_t((word >> TYPE_SHIFT) & mask(TYPE_BITS)); }
+constexpr uint32_t flagsOf(uint64_t word) { return uint32_t((word >> FLAGS_SHIFT) & mask(FLAG_BITS)); }
+
+constexpr int MAX_VARINT_BYTES = 10; /**< A 64-bit value takes at most 10 varint bytes. */
+
+/**
+ * @brief Map signed values onto unsigned ones so small magnitudes stay small.
+ */
+constexpr uint64_t zigzag(int64_t v) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+constexpr int64_t unzigzag(uint64_t v) { return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+/**
+ * @brief Number of bytes putVarint writes for a value.
+ */
+constexpr int varintSize(uint64_t v) {
+	int n = 1;
+	while (v >= 0x80) {
+		v >>= 7;
+		++n;
+	}
+	return n;
+}
+
+/**
+ * @brief Write a value as a LEB128 varint.
+ *
+ * @return Number of bytes written.
+ */
+constexpr int putVarint(uint8_t *buf, uint64_t v) {
+	int n = 0;
+	while (v >= 0x80) {
+		buf[n++] = uint8_t(v | 0x80);
+		v >>= 7;
+	}
+	buf[n++] = uint8_t(v);
+	return n;
+}
+
+/**
+ * @brief Read a LEB128 varint.
+ *
+ * @return Number of bytes read, or 0 if the varint runs past len bytes.
+ */
+constexpr int getVarint(const uint8_t *buf, int len, uint64_t &v) {
+	v = 0;
+	for (int n = 0; n < len && n < MAX_VARINT_BYTES; ++n) {
+		v |= uint64_t(buf[n] & 0x7f) << (7 * n);
+		if (!(buf[n] & 0x80)) {
+			return n + 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Write a list of signed fields as zigzag varints.
+ *
+ * @return Number of bytes written. At most count * MAX_VARINT_BYTES.
+ */
+constexpr int packFields(uint8_t *buf, const int64_t *fields, int count) {
+	int n = 0;
+	for (int i = 0; i < count; ++i) {
+		n += putVarint(buf + n, zigzag(fields[i]));
+	}
+	return n;
+}
+
+/**
+ * @brief Read back a list of fields written by packFields.
+ *
+ * @return true if exactly len bytes held count fields.
+ */
+constexpr bool unpackFields(const uint8_t *buf, int len, int64_t *fields, int count) {
+	int n = 0;
+	for (int i = 0; i < count; ++i) {
+		uint64_t v = 0;
+		int read = getVarint(buf + n, len - n, v);
+		if (read == 0) {
+			return false;
+		}
+		fields[i] = unzigzag(v);
+		n += read;
+	}
+	return n == len;
+}
+
+// Round-trip checks, evaluated at compile time.
+
+constexpr bool messageRoundTrips(uint32_t source_id, uint32_t dest_id, uint32_t status, uint32_t type, uint32_t flags) {
+	return sourceOf(packMessage(source_id, dest_id, status, type, flags)) == source_id
+		&& destOf(packMessage(source_id, dest_id, status, type, flags)) == dest_id
+		&& statusOf(packMessage(source_id, dest_id, status, type, flags)) == status
+		&& typeOf(packMessage(source_id, dest_id, status, type, flags)) == type
+		&& flagsOf(packMessage(source_id, dest_id, status, type, flags)) == flags;
+}
+
+constexpr bool fieldsRoundTrip(int64_t a, int64_t b, int64_t c, int64_t d) {
+	int64_t in[4] = { a, b, c, d };
+	int64_t out[4] = {};
+	uint8_t buf[4 * MAX_VARINT_BYTES] = {};
+	int len = packFields(buf, in, 4);
+	return unpackFields(buf, len, out, 4) && !unpackFields(buf, len - 1, out, 4)
+		&& out[0] == a && out[1] == b && out[2] == c && out[3] == d;
+}
+
+static_assert(messageRoundTrips(0, 0, 0, 0, 0), "Message round trip failed.");
+static_assert(messageRoundTrips(MAX_NODES - 1, MAX_NODES - 1, 1, mask(TYPE_BITS), mask(FLAG_BITS)), "Message round trip failed.");
+static_assert(messageRoundTrips(12345, 67, 1, 2, 5), "Message round trip failed.");
+static_assert(fieldsRoundTrip(0, 1, 0, 2), "Field round trip failed.");
+static_assert(fieldsRoundTrip(INT32_MAX, INT32_MIN, -1, 63), "Field round trip failed.");
+static_assert(fieldsRoundTrip(INT64_MAX, INT64_MIN, 64, -64), "Field round trip failed.");
+static_assert(varintSize(zigzag(63)) == 1 && varintSize(zigzag(64)) == 2, "Small fields must take one byte.");
+
+} // namespace wire
+
+#endif
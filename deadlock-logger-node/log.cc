@@ -1,24 +1,130 @@
 /// \file
 #include <sst/core/sst_config.h>
 #include <sst/core/simulation.h>
+#include <algorithm>
 #include "log.h"
 
-log::log( SST::ComponentId_t id, SST::Params& params ) : SST::Component(id) {
+log::log( SST::ComponentId_t id, SST::Params& params ) : SST::Component(id)
+{
     // Configure console output and data output to a csv file.
-    output.init("deadlocksim-" + getName() + "->", 1, 0, SST::Output::STDOUT);
-    csvout.init("CSVOUT", 1, 0, SST::Output::FILE, "output/log_data.csv");
-    csvout.output("Time,Node,Node State Changes,Idle Time,Resource Requests\n");
+    output.init("deadlocksim-" + getName() + "->", params.find<int64_t>("verbose", 1), 0, SST::Output::STDOUT);
 
     // Parameters
     clock = params.find<std::string>("tickFreq", "1s");
     num_ports = params.find<int64_t>("num_nodes", 1);
-    idle_threshold = params.find<int64_t>("idle_threshold", 50);
-    request_threshold = params.find<int64_t>("idle_threshold", 50);
+    first_node = params.find<int64_t>("first_node", 0);
+
+    std::string csv_file = params.find<std::string>("csv_file", "output/log_data.csv");
+    csv = !csv_file.empty();
+    if (csv) {
+        csvout.init("CSVOUT", 1, 0, SST::Output::FILE, csv_file);
+        csvout.output("Time,Node,Node State Changes,Idle Time,Resource Requests\n");
+    }
+
+    // Live export of the aggregates on a local socket.
+    std::string export_socket = params.find<std::string>("export_socket", "");
+    exporting = !export_socket.empty();
+    exportInterval = std::max<int64_t>(params.find<int64_t>("export_interval", 10), 1);
+    if (exporting) {
+        if (getNumRanks().rank > 1) {
+            export_socket += "-" + std::to_string(getRank().rank);
+        }
+        int64_t export_queue = params.find<int64_t>("export_queue", 64);
+        if (export_queue < 1) {
+            output.fatal(CALL_INFO, -1, "export_queue %" PRId64 " must be at least 1\n", export_queue);
+        }
+        if (!TelemetryExporter::instance().acquire(export_socket, export_queue)) {
+            output.fatal(CALL_INFO, -1, "Failed to open export socket %s\n", export_socket.c_str());
+        }
+    }
+
+    // Handler profiling.
+    if (params.find<bool>("profile", false)) {
+        profiler.enable({ "tick", "messageHandler" }, {});
+        ProfileCollector::instance().expect();
+    }
+
+    // Register statistics. Collection is enabled and routed to an output from the Python driver.
+    statBlockedNodes = registerStatistic<uint64_t>("blocked_nodes");
+    statIdleTime = registerStatistic<uint64_t>("idle_time");
+    statStateChanges = registerStatistic<uint64_t>("state_changes");
+    statStuckFraction = registerStatistic<uint64_t>("stuck_fraction");
+    statRecoveryTime = registerStatistic<uint64_t>("recovery_time");
     
     // Arrays
-    idleArray = (int*) malloc(num_ports * sizeof(int));
-    stateArray = (int*) malloc(num_ports * sizeof(int));
-    requestArray = (int*) malloc(num_ports * sizeof(int));
+    idleArray = (int*) calloc(num_ports, sizeof(int)); 
+    idleSince = (int64_t*) calloc(num_ports, sizeof(int64_t));
+    blockedSince = (int64_t*) malloc(num_ports * sizeof(int64_t));
+    std::fill(blockedSince, blockedSince + num_ports, NOT_BLOCKED);
+    stateArray = (int*) calloc(num_ports, sizeof(int)); 
+    stateChanges = (int*) calloc(num_ports, sizeof(int));
+    requestArray = (int*) calloc(num_ports, sizeof(int)); 
+    stuckArray = (int*) calloc(num_ports, sizeof(int));
+    deliveredArray = (int*) calloc(num_ports, sizeof(int));
+    queueArray = (int*) calloc(num_ports, sizeof(int));
+
+    // Early deadlock prediction.
+    std::string predictor_mode = params.find<std::string>("predictor", "off");
+    if (predictor_mode == "off") {
+        predictorMode = PREDICT_OFF;
+    } else if (predictor_mode == "alarm") {
+        predictorMode = PREDICT_ALARM;
+    } else if (predictor_mode == "end") {
+        predictorMode = PREDICT_END;
+    } else {
+        output.fatal(CALL_INFO, -1, "Unknown predictor '%s', expected 'off', 'alarm' or 'end'\n", predictor_mode.c_str());
+    }
+    predictor.configure(num_ports, params.find<double>("predict_alarm_fraction", 0.75), params.find<int64_t>("predict_alarm_run", 5), params.find<int64_t>("predict_confirm_run", 10));
+    alarmRaised = false;
+    alarms = 0;
+    falseAlarms = 0;
+    unavoidableCycle = -1;
+
+    // Steady state detection. Metrics are the messages delivered per cycle and the mean queue size.
+    std::string steady_mode = params.find<std::string>("steady_state", "off");
+    if (steady_mode == "off") {
+        steadyMode = STEADY_OFF;
+    } else if (steady_mode == "report") {
+        steadyMode = STEADY_REPORT;
+    } else if (steady_mode == "end") {
+        steadyMode = STEADY_END;
+    } else {
+        output.fatal(CALL_INFO, -1, "Unknown steady_state '%s', expected 'off', 'report' or 'end'\n", steady_mode.c_str());
+    }
+    steady.configure({ 0, params.find<double>("steady_queue_floor", 5) }, { true, false }, params.find<int64_t>("steady_batch", 1000), params.find<int64_t>("steady_batches", 20), params.find<double>("steady_tolerance", 0.1));
+    lastDelivered = 0;
+    steadyCycle = -1;
+
+    // Deadlock recovery instead of ending the simulation.
+    std::string recovery_mode = params.find<std::string>("recovery", "stop");
+    recoveryEnabled = recovery_mode != "stop";
+    if (recovery_mode == "drop") {
+        recovery.policy = RECOVER_DROP;
+    } else if (recovery_mode == "reroute") {
+        recovery.policy = RECOVER_REROUTE;
+    } else if (recovery_mode == "drain" || !recoveryEnabled) {
+        recovery.policy = RECOVER_DRAIN;
+    } else {
+        output.fatal(CALL_INFO, -1, "Unknown recovery '%s', expected 'stop', 'drop', 'reroute' or 'drain'\n", recovery_mode.c_str());
+    }
+    recovery.messages = params.find<int64_t>("recovery_drain", 0);
+    std::string victim = params.find<std::string>("recovery_victim", "fullest");
+    if (victim == "fullest") {
+        victimChoice = VICTIM_FULLEST;
+    } else if (victim == "rotate") {
+        victimChoice = VICTIM_ROTATE;
+    } else {
+        output.fatal(CALL_INFO, -1, "Unknown recovery_victim '%s', expected 'fullest' or 'rotate'\n", victim.c_str());
+    }
+    recoveryHoldoff = params.find<int64_t>("recovery_holdoff", 10);
+    holdoffUntil = 0;
+    lastVictim = -1;
+    recoveringSince = -1;
+    recoveries = 0;
+    deadlocks = 0;
+    recoveredMessages = 0;
+    recoveryCycles = 0;
+    lastCycle = 0;
 
     // Register the node as a primary component.
 	// Then declare that the simulation cannot end until this 
@@ -26,77 +132,567 @@ log::log( SST::ComponentId_t id, SST::Params& params ) : SST::Component(id) {
     registerAsPrimaryComponent();
     primaryComponentDoNotEndSim();
 
-    // Configure a variable number of ports.
-    port = new SST::Link*[num_ports];
-    for (int i = 0; i < num_ports; ++i) {
+    // Read records from the shared telemetry table when every component is in this process.
+    telemetry = NULL;
+    std::string log_mode = params.find<std::string>("log_mode", "events");
+    batched = log_mode == "batch";
+    if (log_mode == "shared" && getNumRanks().rank == 1) {
+        telemetry = &TelemetryTable::instance();
+        if (!telemetry->reserve(params.find<int64_t>("total_nodes", first_node + num_ports))) {
+            output.fatal(CALL_INFO, -1, "Telemetry table is sized for a different number of nodes\n");
+        }
+    }
+
+    // Configure a variable number of ports. A segment sends the records of all its nodes on port0.
+    port = new SST::Link*[num_ports]();
+    for (int i = 0; i < (batched ? 1 : num_ports); ++i) {
         std::string strport = "port" + std::to_string(i);
         port[i] = configureLink(strport, new SST::Event::Handler<log>(this, &log::messageHandler));
-        if (!port[i]) {
+        if (!port[i] && (!telemetry || recoveryEnabled)) {
             output.fatal(CALL_INFO, -1, "Failed to configure port 'port'\n");
         }
     }
 
-    registerClock(clock, new SST::Clock::Handler<log>(this, &log::tick));
+    // Summary tree of the partition loggers. With a parent or children only the root decides on deadlock.
+    parentPort = configureLink("parent", new SST::Event::Handler<log>(this, &log::verdictHandler));
+    int reduce_children = params.find<int64_t>("reduce_children", 0);
+    for (int i = 0; i < reduce_children; ++i) {
+        std::string strport = "child" + std::to_string(i);
+        childPorts.push_back(configureLink(strport, new SST::Event::Handler<log, int>(this, &log::summaryHandler, i)));
+        if (!childPorts.back()) {
+            output.fatal(CALL_INFO, -1, "Failed to configure port '%s'\n", strport.c_str());
+        }
+    }
+    reducing = parentPort || !childPorts.empty();
+    summaries.configure(reduce_children);
+    reduceDelay = params.find<int64_t>("reduce_depth", 0) * registerTimeBase(params.find<std::string>("reduce_latency", "1ms"), false)->getFactor();
+    summariesSent = 0;
+
+    clockTC = registerClock(clock, new SST::Clock::Handler<log>(this, &log::tick));
+
+    // Thresholds are simulated times, so nodes with different clocks are held to the same
+    // standard. Plain numbers are logger cycles.
+    idle_threshold = threshold(params, "idle_threshold");
+    request_threshold = threshold(params, "request_threshold");
+
+    // Snapshot and restore. The snapshot self link uses a 1ps time base so delays are in core time.
+    snapshotDir = params.find<std::string>("snapshot_dir", "output/snapshot");
+    restoreDir = params.find<std::string>("restore_from", "");
+    snapshotLink = NULL;
+    snapshotTime = 0;
+    logDelay = 0;
+    std::string log_delay = params.find<std::string>("log_delay", "");
+    if (!log_delay.empty() && !telemetry) {
+        logDelay = registerTimeBase(log_delay, false)->getFactor();
+        pending.resize(num_ports);
+    }
+    timeOffset = 0;
+    std::string snapshot_at = params.find<std::string>("snapshot_at", "");
+    if (!snapshot_at.empty()) {
+        snapshotTime = registerTimeBase(snapshot_at, false)->getFactor();
+        if (snapshotTime == 0) {
+            output.fatal(CALL_INFO, -1, "snapshot_at must be later than the start of the simulation\n");
+        }
+        snapshotLink = configureSelfLink("snapshotLink", "1ps", new SST::Event::Handler<log>(this, &log::snapshotHandler));
+    }
 }
 
 log::~log() {
     free(idleArray);
+    free(idleSince);
+    free(blockedSince);
     free(stateArray);
     free(stateChanges);
     free(requestArray);
+    free(stuckArray);
+    free(deliveredArray);
+    free(queueArray);
 }
 
 void log::setup() {
     deadlocked = false;
-    idleArray = (int*) calloc(num_ports, sizeof(int)); 
-    stateArray = (int*) calloc(num_ports, sizeof(int)); 
-    stateChanges = (int*) calloc(num_ports, sizeof(int));
-    requestArray = (int*) calloc(num_ports, sizeof(int)); 
+
+    if (snapshotLink) {
+        snapshotLink->send(snapshotTime - 1, new TimerEvent());
+    }
+
+    // Start from a saved state. Reported times continue from the time of the snapshot.
+    if (!restoreDir.empty()) {
+        if (!snapshot::read(restoreDir, "log-" + std::to_string(first_node) + ".snap", [this](SST::Core::Serialization::serializer &ser) { serializeSnapshot(ser); })) {
+            output.fatal(CALL_INFO, -1, "Failed to read snapshot from %s\n", restoreDir.c_str());
+        }
+        output.verbose(CALL_INFO, 1, 0, "Restored state at cycle %" PRIu64 "\n", timeOffset);
+        // The state was taken just before the tick at the snapshot time, which is cycle 0 here.
+        // Clocks start one period in, so that tick runs now.
+        tick(0);
+    }
+}
+
+void log::snapshotHandler( SST::Event *ev ) {
+    delete ev;
+    // Records in flight to the logger or held back are superseded by the nodes' next records, so only the arrays are saved.
+    // Summaries are not saved either, the restored loggers send theirs again from the arrays.
+    if (!snapshot::write(snapshotDir, "log-" + std::to_string(first_node) + ".snap", [this](SST::Core::Serialization::serializer &ser) { serializeSnapshot(ser); })) {
+        output.fatal(CALL_INFO, -1, "Failed to write snapshot to %s\n", snapshotDir.c_str());
+    }
+}
+
+void log::serializeSnapshot( SST::Core::Serialization::serializer &ser ) {
+    // Idle and blocked runs are saved relative to the snapshot time, which is time 0 of the restored run.
+    SST::SimTime_t taken = snapshotTime;
+    std::vector<int64_t> idle(num_ports);
+    std::vector<int64_t> blocked(num_ports);
+    for (int i = 0; i < num_ports; ++i) {
+        idle[i] = idleSince[i] - (int64_t)taken;
+        blocked[i] = blockedSince[i] == NOT_BLOCKED ? NOT_BLOCKED : blockedSince[i] - (int64_t)taken;
+    }
+    std::vector<int> state(stateArray, stateArray + num_ports);
+    std::vector<int> changes(stateChanges, stateChanges + num_ports);
+    std::vector<int> stuck(stuckArray, stuckArray + num_ports);
+    std::vector<int> delivered(deliveredArray, deliveredArray + num_ports);
+    std::vector<int> queued(queueArray, queueArray + num_ports);
+
+    ser & taken;
+    ser & idle;
+    ser & state;
+    ser & changes;
+    ser & blocked;
+    ser & stuck;
+    ser & deadlocked;
+    predictor.serialize(ser);
+    ser & alarmRaised;
+    ser & alarms;
+    ser & falseAlarms;
+    ser & unavoidableCycle;
+    ser & delivered;
+    ser & queued;
+    steady.serialize(ser);
+    ser & lastDelivered;
+    ser & steadyCycle;
+    ser & holdoffUntil;
+    ser & lastVictim;
+    ser & recoveringSince;
+    ser & recoveries;
+    ser & deadlocks;
+    ser & recoveredMessages;
+    ser & recoveryCycles;
+
+    if (ser.mode() == SST::Core::Serialization::serializer::UNPACK) {
+        timeOffset = taken / clockTC->getFactor();
+        if ((int)idle.size() != num_ports) {
+            output.fatal(CALL_INFO, -1, "Snapshot is of a logger with %ld nodes\n", idle.size());
+        }
+        std::copy(idle.begin(), idle.end(), idleSince);
+        std::copy(state.begin(), state.end(), stateArray);
+        std::copy(changes.begin(), changes.end(), stateChanges);
+        std::copy(blocked.begin(), blocked.end(), blockedSince);
+        std::copy(stuck.begin(), stuck.end(), stuckArray);
+        std::copy(delivered.begin(), delivered.end(), deliveredArray);
+        std::copy(queued.begin(), queued.end(), queueArray);
+    }
+}
+
+void log::finish() {
+    if (predictorMode != PREDICT_OFF) {
+        output.output(CALL_INFO, "Predictor alarms %d | false alarms %d\n", alarms, falseAlarms);
+    }
+    if (parentPort) {
+        output.output(CALL_INFO, "Summaries sent to the parent %" PRIu64 "\n", summariesSent);
+    }
+
+    // Long-run behavior of a ring that recovers.
+    if (recoveryEnabled) {
+        int64_t delivered = 0;
+        for (int i = 0; i < num_ports; ++i) {
+            delivered += deliveredArray[i];
+        }
+        double cycles = lastCycle > 0 ? (double)lastCycle : 1;
+        output.output(CALL_INFO, "Deadlocks %" PRIu64 " | recoveries %" PRIu64 " | messages recovered %" PRIu64 " | mean recovery time %.1f cycles | mean time between deadlocks %.1f cycles | delivered %.4f messages per cycle\n",
+            deadlocks, recoveries, recoveredMessages, deadlocks ? (double)recoveryCycles / deadlocks : 0.0, deadlocks ? cycles / deadlocks : cycles, delivered / cycles);
+    }
+
+    // Final state for the readers. The last logger closes the socket.
+    if (exporting) {
+        exportState(lastCycle);
+        TelemetryExporter::instance().release();
+    }
+
+    // Report handler profile and add it to the merged per-run profile.
+    if (profiler.isEnabled()) {
+        double scale = profiler.nsPerCycle();
+        for (const Profiler::Handler &h : profiler.getHandlers()) {
+            output.output(CALL_INFO, "Profile %s: %" PRIu64 " calls | %.3f ms total | %.0f ns max\n", h.name.c_str(), h.calls, h.cycles * scale / 1e6, h.max * scale);
+        }
+        std::string path = getNumRanks().rank > 1 ? "output/profile-" + std::to_string(getRank().rank) + ".json" : "output/profile.json";
+        if (!ProfileCollector::instance().submit(getName(), "log", profiler, path)) {
+            output.output(CALL_INFO, "Failed to write %s\n", path.c_str());
+        }
+    }
 }
 
 bool log::tick( SST::Cycle_t currentCycle ) { 
+    ProfileScope scope(profiler, PROFILE_TICK);
+
+    // Catch up on the records taken before the delayed view.
+    if (logDelay > 0) {
+        applyPending();
+    }
+
+    // Pull the latest record of every node in the segment.
+    if (telemetry) {
+        struct Log latest;
+        for (int i = 0; i < num_ports; ++i) {
+            if (telemetry->read(i + first_node, latest)) {
+                record(latest);
+            }
+        }
+    }
+
+    // The delayed view starts log_delay into the run, there is nothing to evaluate before.
+    int64_t view = (int64_t)getCurrentSimCycle() - (int64_t)logDelay;
+    if (view < 0) {
+        return (false);
+    }
+
+    // Idle and blocked times of the evaluated state, in logger cycles.
+    int64_t period = clockTC->getFactor();
+    // A record newer than the view can start its run after it. The node was not idle or
+    // blocked yet at the view, which counts as 0.
+    for (int i = 0; i < num_ports; ++i) {
+        idleArray[i] = stateArray[i] == 0 ? std::max<int64_t>(view - idleSince[i], 0) / period : 0;
+        requestArray[i] = blockedSince[i] == NOT_BLOCKED || blockedSince[i] > view ? 0 : (view - blockedSince[i]) / period + 1;
+    }
 
     // Console output.
+    uint64_t blocked = 0;
     for(int i = 0; i < num_ports; ++i) {
-        output.output(CALL_INFO, "Node %d: Current State: %d, Consecutive Cycles Idle: %d, Consecutive Queue Request: %d\n", i, stateArray[i], idleArray[i], requestArray[i]);
-        csvout.output("%ld,Node_%d,%d,%d,%d\n", getCurrentSimTime(), i, stateChanges[i], idleArray[i], requestArray[i]);
+        output.verbose(CALL_INFO, 1, 0, "Node %d: Current State: %d, Consecutive Cycles Idle: %d, Consecutive Queue Request: %d\n", i + first_node, stateArray[i], idleArray[i], requestArray[i]);
+        if (csv) {
+            csvout.output("%ld,Node_%d,%d,%d,%d\n", getCurrentSimTime() + timeOffset, i + first_node, stateChanges[i], idleArray[i], requestArray[i]);
+        }
+        statIdleTime->addData(idleArray[i]);
+        if (stateArray[i] == 0 && requestArray[i] > 0) {
+            blocked++;
+        }
+    }
+    statBlockedNodes->addData(blocked);
+    if (output.getVerboseLevel() >= 1) {
+        output.output("\n");
+    }
+
+    // Nothing left to check once the predictor ended the run.
+    if (predictorMode == PREDICT_END && unavoidableCycle >= 0 && !recoveryEnabled) {
+        return (false);
+    }
+
+    // The ring moves again after a recovery.
+    SST::Cycle_t cycle = currentCycle + timeOffset;
+    lastCycle = cycle;
+    if (recoveringSince >= 0 && std::any_of(stateArray, stateArray + num_ports, [](int state) { return state != 0; })) {
+        statRecoveryTime->addData(cycle - recoveringSince);
+        recoveryCycles += cycle - recoveringSince;
+        recoveringSince = -1;
     }
-    output.output("\n");
 
     // Check if all monitored nodes exceed the conditions to declare deadlock.
-    for(int i = 0; i < num_ports; ++i) {
-        if (stateArray[i] == 0 && idleArray[i] > idle_threshold && requestArray[i] > request_threshold) {
-            deadlocked = true;
-        } else {
-            deadlocked = false;
-            break;
+    bool wasDeadlocked = deadlocked;
+    if (reducing) {
+        reduce(view);
+    } else {
+        for(int i = 0; i < num_ports; ++i) {
+            if (overThresholds(i, view)) {
+                deadlocked = true;
+            } else {
+                deadlocked = false;
+                break;
+            }
         }
     }
 
-    // If deadlocked, end simulation.
-    if (deadlocked) {
+    // If deadlocked, end simulation or recover and continue.
+    if (deadlocked && recoveryEnabled) {
+        if ((int64_t)cycle >= holdoffUntil) {
+            output.output(CALL_INFO, "Detected Deadlock at cycle %" PRIu64 ". Recovering.\n", cycle);
+            if (unavoidableCycle >= 0) {
+                output.output(CALL_INFO, "Deadlock was predicted at cycle %" PRId64 ", %" PRId64 " cycles before the thresholds\n", unavoidableCycle, (int64_t)cycle - unavoidableCycle);
+            }
+            recover(cycle);
+        }
+    } else if (deadlocked) {
         output.output(CALL_INFO, "Detected Deadlock. Ending Simulation.\n");
+        if (!wasDeadlocked && reducing && !parentPort) {
+            Summary ring = summaries.subtree();
+            output.output(CALL_INFO, "Every node of the ring idle since %" PRId64 " ps and blocked since %" PRId64 " ps\n", ring.idle_since, ring.blocked_since);
+            for (SST::Link *child : childPorts) {
+                child->send(new SummaryEvent(ring));
+            }
+        }
+        if (!wasDeadlocked && unavoidableCycle >= 0) {
+            output.output(CALL_INFO, "Deadlock was predicted at cycle %" PRId64 ", %" PRId64 " cycles before the thresholds\n", unavoidableCycle, (int64_t)cycle - unavoidableCycle);
+        }
         primaryComponentOKToEndSim();
+    } else {
+        if (predictorMode != PREDICT_OFF) {
+            predict(cycle);
+        }
+        // For situations in which deadlock does not occur, end once the ring has settled.
+        if (steadyMode != STEADY_OFF && !deadlocked && steadyCycle < 0) {
+            checkSteadyState(cycle);
+        }
     }
 
-    // For situations in which deadlock does not, end early and collect data.
-    /**if (currentCycle == 1000) {
-        output.output(CALL_INFO, "Ending at %ld\n", currentCycle);
-        primaryComponentOKToEndSim();
-    }*/
-    
+    if (exporting && (cycle % exportInterval == 0 || (deadlocked && !wasDeadlocked))) {
+        exportState(cycle);
+    }
 
     return (false);
 }
 
 
 void log::messageHandler( SST::Event *ev ) { 
+    ProfileScope scope(profiler, PROFILE_MESSAGE);
     LogEvent *le = dynamic_cast<LogEvent*>(ev);
     if (le != NULL) {  
-        idleArray[le->log.node_id] = le->log.idle_time;
-        requestArray[le->log.node_id] = le->log.num_requests;
-        if(stateArray[le->log.node_id] != le->log.node_status) {
-            stateChanges[le->log.node_id] += 1;
+        receive(le->log);
+    } else if (LogBatchEvent *be = dynamic_cast<LogBatchEvent*>(ev)) {
+        for (const Log &log : be->logs) {
+            receive(log);
+        }
+    }
+    delete ev; // Clean up event to prevent memory leaks.
+}
+
+void log::summaryHandler( SST::Event *ev, int child ) {
+    SummaryEvent *se = dynamic_cast<SummaryEvent*>(ev);
+    if (se != NULL) {
+        summaries.setChild(child, se->summary);
+    }
+    delete ev;
+
+    // Changes are passed on right away, so a summary takes only the link latency per level to reach the root.
+    Summary subtree;
+    if (parentPort && summaries.takeUpdate(subtree)) {
+        parentPort->send(new SummaryEvent(subtree));
+        summariesSent++;
+    }
+}
+
+void log::verdictHandler( SST::Event *ev ) {
+    SummaryEvent *se = dynamic_cast<SummaryEvent*>(ev);
+    if (se != NULL) {
+        // The next tick ends the simulation, as if this logger had detected the deadlock.
+        deadlocked = true;
+        for (SST::Link *child : childPorts) {
+            child->send(new SummaryEvent(se->summary));
+        }
+    }
+    delete ev;
+}
+
+void log::reduce( int64_t view ) {
+    summaries.setLocal(SummaryTree::summarize(stateArray, idleSince, blockedSince, num_ports));
+
+    // Below the root the subtree summary goes to the parent, and deadlock is only declared by the root's verdict.
+    Summary subtree;
+    if (parentPort) {
+        if (summaries.takeUpdate(subtree)) {
+            parentPort->send(new SummaryEvent(subtree));
+            summariesSent++;
+        }
+        return;
+    }
+
+    // A change seen by a logger at its view reaches the root reduceDelay later, and the logger sees it up to a cycle late.
+    int64_t asOf = view - (int64_t)reduceDelay - (int64_t)clockTC->getFactor();
+    deadlocked = SummaryTree::over(summaries.subtree(), asOf, idle_threshold, request_threshold);
+}
+
+void log::receive( const Log &log ) {
+    if (logDelay == 0) {
+        record(log);
+        return;
+    }
+    // A record older than the view missed the ticks it belongs to.
+    if (log.time + logDelay < getCurrentSimCycle()) {
+        output.fatal(CALL_INFO, -1, "Record of node %d arrived %" PRIu64 "ps after it was taken, log_delay must cover the logger link latency\n", log.node_id, getCurrentSimCycle() - log.time);
+    }
+    pending[log.node_id - first_node].push(log);
+}
+
+void log::applyPending() {
+    // Records arriving at the tick's time are handled after it, so the view only takes records strictly older than log_delay.
+    SST::SimTime_t now = getCurrentSimCycle();
+    for (Fifo<Log> &records : pending) {
+        while (!records.empty() && records.front().time + logDelay < now) {
+            record(records.front());
+            records.pop();
+        }
+    }
+}
+
+void log::record( const Log &log ) {
+    // Node IDs are global to the ring, the arrays only cover this logger's segment.
+    int i = log.node_id - first_node;
+    idleSince[i] = log.idle_since;
+    blockedSince[i] = log.blocked_since;
+    stuckArray[i] = log.stuck;
+    deliveredArray[i] = log.delivered;
+    queueArray[i] = log.queue_size;
+    if(stateArray[i] != log.node_status) {
+        stateChanges[i] += 1;
+        statStateChanges->addData(1);
+    }
+    stateArray[i] = log.node_status;
+}
+
+int64_t log::threshold( SST::Params& params, const std::string &name ) {
+    std::string value = params.find<std::string>(name, "50");
+    if (!value.empty() && value.find_first_not_of("0123456789") == std::string::npos) {
+        return std::stoll(value) * clockTC->getFactor();
+    }
+    return registerTimeBase(value, false)->getFactor();
+}
+
+bool log::overThresholds( int i, int64_t view ) const {
+    return stateArray[i] == 0 && view - idleSince[i] > idle_threshold
+        && blockedSince[i] != NOT_BLOCKED && view - blockedSince[i] > request_threshold;
+}
+
+void log::checkSteadyState( SST::Cycle_t cycle ) {
+    int64_t delivered = 0;
+    int64_t queued = 0;
+    for (int i = 0; i < num_ports; ++i) {
+        delivered += deliveredArray[i];
+        queued += queueArray[i];
+    }
+    double samples[2] = { (double)(delivered - lastDelivered), (double)queued / num_ports };
+    lastDelivered = delivered;
+
+    // Not while the predictor warns of deadlock, the queues may only look settled.
+    if (!steady.add(samples) || alarmRaised) {
+        return;
+    }
+    steadyCycle = cycle;
+    SteadyState::Estimate throughput = steady.estimate(0);
+    SteadyState::Estimate queue = steady.estimate(1);
+    output.output(CALL_INFO, "Steady state at cycle %" PRIu64 ": delivered %.4f +- %.4f messages per cycle | queue size %.2f +- %.2f per node\n", cycle, throughput.mean, throughput.half, queue.mean, queue.half);
+    if (steadyMode == STEADY_END) {
+        output.output(CALL_INFO, "No deadlock. Ending Simulation.\n");
+        primaryComponentOKToEndSim();
+    }
+}
+
+void log::recover( SST::Cycle_t cycle ) {
+    // Pick the victim. Drop and reroute need a message at the top of the queue.
+    int victim = -1;
+    for (int k = 1; k <= num_ports; ++k) {
+        int i = victimChoice == VICTIM_ROTATE ? (lastVictim + k) % num_ports : k - 1;
+        if (victim < 0 || (victimChoice == VICTIM_FULLEST && queueArray[i] > queueArray[victim])) {
+            victim = i;
+        }
+        if (victimChoice == VICTIM_ROTATE && queueArray[i] > 0) {
+            victim = i;
+            break;
+        }
+    }
+    lastVictim = victim;
+
+    recovery.node_id = victim + first_node;
+    port[batched ? 0 : victim]->send(new RecoveryEvent(recovery));
+    output.output(CALL_INFO, "Recovery request to node %d with %d queued messages\n", victim + first_node, queueArray[victim]);
+
+    int queued = queueArray[victim];
+    recoveredMessages += recovery.policy == RECOVER_DRAIN ? (recovery.messages > 0 ? std::min(recovery.messages, queued) : queued) : std::min(queued, 1);
+    recoveries++;
+    if (recoveringSince < 0) {
+        recoveringSince = cycle;
+        deadlocks++;
+    }
+    holdoffUntil = cycle + recoveryHoldoff;
+
+    // The alarm was right, it is answered by the recovery.
+    alarmRaised = false;
+    unavoidableCycle = -1;
+}
+
+void log::exportState( SST::Cycle_t cycle ) {
+    ExportSample sample = {};
+    sample.time = getCurrentSimCycle();
+    sample.cycle = cycle;
+    sample.first_node = first_node;
+    sample.nodes = num_ports;
+    int64_t idleSum = 0;
+    int64_t view = (int64_t)getCurrentSimCycle() - (int64_t)logDelay;
+    for (int i = 0; i < num_ports; ++i) {
+        if (stateArray[i] == 0 && requestArray[i] > 0) {
+            sample.blocked++;
+        }
+        if (overThresholds(i, view)) {
+            sample.over_threshold++;
+        }
+        sample.stuck += stuckArray[i];
+        sample.queued += queueArray[i];
+        sample.idle[ExportSample::bucket(idleArray[i])]++;
+        sample.idle_max = std::max(sample.idle_max, idleArray[i]);
+        idleSum += idleArray[i];
+    }
+    sample.idle_mean = num_ports ? (double)idleSum / num_ports : 0;
+    if (predictorMode == PREDICT_OFF) {
+        sample.predictor = ExportSample::PREDICTOR_OFF;
+    } else if (unavoidableCycle >= 0) {
+        sample.predictor = ExportSample::PREDICTOR_UNAVOIDABLE;
+    } else if (alarmRaised) {
+        sample.predictor = ExportSample::PREDICTOR_ALARM;
+    } else {
+        sample.predictor = ExportSample::PREDICTOR_CLEAR;
+    }
+    sample.stalled_run = predictor.getStalledRun();
+    sample.deadlocked = deadlocked;
+    sample.recoveries = recoveries;
+    TelemetryExporter::instance().publish(sample);
+}
+
+void log::predict( SST::Cycle_t cycle ) {
+    DeadlockPredictor::Verdict verdict = predictor.update(stateArray, idleArray, stuckArray);
+    statStuckFraction->addData(predictor.getStuckFraction() * 100);
+
+    // Progress resumed, so the alarm or the prediction was wrong.
+    if (alarmRaised && predictor.getStalledRun() == 0) {
+        output.output(CALL_INFO, "Deadlock alarm cleared at cycle %" PRIu64 ", progress resumed\n", cycle);
+        alarmRaised = false;
+        falseAlarms++;
+        unavoidableCycle = -1;
+    }
+
+    if (verdict != DeadlockPredictor::CLEAR && !alarmRaised) {
+        output.output(CALL_INFO, "Deadlock alarm at cycle %" PRIu64 ": %.0f%% of nodes stuck, trend %+.3f per cycle, %d cycles without progress\n", cycle, predictor.getStuckFraction() * 100, predictor.getTrend(), predictor.getStalledRun());
+        alarmRaised = true;
+        alarms++;
+    }
+
+    if (verdict == DeadlockPredictor::UNAVOIDABLE && unavoidableCycle < 0) {
+        // Recover right away instead of ending the run.
+        if (predictorMode == PREDICT_END && recoveryEnabled) {
+            if ((int64_t)cycle >= holdoffUntil) {
+                output.output(CALL_INFO, "Detected Deadlock by prediction at cycle %" PRIu64 ". Recovering.\n", cycle);
+                recover(cycle);
+            }
+            return;
+        }
+        unavoidableCycle = cycle;
+        if (predictorMode == PREDICT_END) {
+            // Estimated from how fast the idle counts grew while stuck.
+            int64_t period = clockTC->getFactor();
+            int ahead = predictor.ticksToThresholds(idleArray, requestArray, idle_threshold / period, request_threshold / period);
+            if (ahead >= 0) {
+                output.output(CALL_INFO, "Detected Deadlock by prediction at cycle %" PRIu64 ", about %d cycles before the thresholds. Ending Simulation.\n", cycle, ahead);
+            } else {
+                output.output(CALL_INFO, "Detected Deadlock by prediction at cycle %" PRIu64 ". Ending Simulation.\n", cycle);
+            }
+            deadlocked = true;
+            primaryComponentOKToEndSim();
+        } else {
+            output.output(CALL_INFO, "Deadlock unavoidable at cycle %" PRIu64 "\n", cycle);
         }
     }
 }
\ No newline at end of file
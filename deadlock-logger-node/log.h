@@ -4,7 +4,15 @@
 
 #include <sst/core/component.h>
 #include <sst/core/link.h>
+#include "Fifo.h"
 #include "CommunicationEvents.h"
+#include "Telemetry.h"
+#include "Profile.h"
+#include "Snapshot.h"
+#include "Predictor.h"
+#include "SteadyState.h"
+#include "Exporter.h"
+#include "Reduction.h"
 
 /**
  * @brief Log Component Class. The log node collects information regarding all other nodes to determine 
@@ -34,6 +42,12 @@ public:
      */
     void setup(); 
 
+    /**
+     * @brief Finish phase. This member runs before the component is deconstructed.
+     * 
+     */
+    void finish();
+
     /**
      * @brief Contains logging node's behavior that is run every time it ticks. 
      * 
@@ -50,6 +64,29 @@ public:
      */
     void messageHandler(SST::Event *ev);
 
+    /**
+     * @brief Writes the logger's state to a snapshot file at snapshot_at.
+     * 
+     * @param ev TimerEvent sent over the snapshot self link.
+     */
+    void snapshotHandler(SST::Event *ev);
+
+    /**
+     * @brief Takes a child logger's subtree summary and passes the combined summary on
+     * when it changed.
+     * 
+     * @param ev SummaryEvent received from the child.
+     * @param child Index of the child port.
+     */
+    void summaryHandler(SST::Event *ev, int child);
+
+    /**
+     * @brief Takes the root's ring-wide deadlock verdict and passes it on to the children.
+     * 
+     * @param ev SummaryEvent received from the parent.
+     */
+    void verdictHandler(SST::Event *ev);
+
     /**
      * Currently ignoring SST_ELI Macros as they break doxygen. 
      * \cond
@@ -74,8 +111,37 @@ public:
     SST_ELI_DOCUMENT_PARAMS(
         {"tickFreq", "The frequency the component is called at.", "1s"},
         {"num_nodes", "The number of nodes that the logger is logging.", "1"},
-        {"idle_threshold", "The number of consecutive cycles idle that all monitored nodes must exceed for deadlock to be declared.", "50"},
-        {"request_threshold", "The number of consecutive request that all monitored nodes must exceed for deadlock to be declared.", "50"},
+        {"first_node", "ID of the first node in the contiguous ring segment the logger is logging. port0 connects to this node.", "0"},
+        {"profile", "Record call counts and wall-clock time of tick and messageHandler. Reported at finish and merged into output/profile.json.", "false"},
+        {"snapshot_at", "Simulated time to snapshot the logger's state at. Should match the nodes. Empty takes no snapshot.", ""},
+        {"snapshot_dir", "Directory the snapshot is written to.", "output/snapshot"},
+        {"restore_from", "Directory of a snapshot to start from. Empty starts normally.", ""},
+        {"log_delay", "Age of the ring state the logger evaluates. Records are held back until they are this old, so every node's state is taken at the same time even when the logger links are slow or differ in latency. Must be at least the latency of the logger links, which can then be as high as the node tick period. The logger starts evaluating log_delay into the run. Empty applies records as they arrive. Only used with LogEvents.", ""},
+        {"log_mode", "How log records arrive. 'events' receives LogEvents on the ports, 'shared' reads the in-process telemetry table every tick, 'batch' receives LogBatchEvents from a segment component on port0 and sends recovery requests back on it. Must match the nodes. 'shared' falls back to 'events' on more than one rank.", "events"},
+        {"total_nodes", "Number of nodes in the ring. Only used to size the telemetry table with log_mode 'shared'.", "first_node + num_nodes"},
+        {"csv_file", "File the per-tick log data is written to. Empty disables the CSV output, use the statistics instead.", "output/log_data.csv"},
+        {"verbose", "Verbosity of the console output. 1 prints every node's state every tick, 0 only prints detection.", "1"},
+        {"idle_threshold", "Time every monitored node must have been idle for, longer than this, for deadlock to be declared. A simulated time such as '250ms', or a plain number of logger cycles.", "50"},
+        {"request_threshold", "Time every monitored node must have been blocked by missing credits for since it last sent, longer than this, for deadlock to be declared. A simulated time such as '250ms', or a plain number of logger cycles.", "50"},
+        {"predictor", "Early deadlock prediction. 'off', 'alarm' warns when deadlock is likely and reports how much earlier it was unavoidable than the thresholds detected it, 'end' ends the run as soon as deadlock is unavoidable.", "off"},
+        {"predict_alarm_fraction", "Fraction of monitored nodes that must be stuck without credits to raise the alarm.", "0.75"},
+        {"predict_alarm_run", "Consecutive logger cycles without progress that raise the alarm.", "5"},
+        {"recovery", "What happens on deadlock. 'stop' ends the simulation, 'drop' drops the message at the top of the victim's queue, 'reroute' passes it on to its destination over an escape channel that bypasses the queues and credits, where it counts as consumed, 'drain' moves the victim's queue to a recovery buffer that is sent out first. The simulation continues after a recovery.", "stop"},
+        {"recovery_victim", "Node picked to resolve a deadlock. 'fullest' takes the node with the most queued messages, 'rotate' takes turns around the segment.", "fullest"},
+        {"recovery_drain", "Messages moved to the recovery buffer with 'drain'. 0 drains the whole queue.", "0"},
+        {"recovery_holdoff", "Logger cycles after a recovery before another one, so the victim's freed space can reach the records.", "10"},
+        {"steady_state", "Steady state detection from the delivered throughput and queue sizes. 'off', 'report' prints the steady state metrics once they converge, 'end' also ends the run.", "off"},
+        {"steady_batch", "Logger cycles averaged into one batch of the steady state monitor.", "1000"},
+        {"steady_batches", "Batches in the steady state monitor's sliding window.", "20"},
+        {"steady_tolerance", "Relative half width of the confidence intervals, and drift across the window, at which the metrics have converged.", "0.1"},
+        {"steady_queue_floor", "Queue size in messages below which the queue size tolerance is absolute, steady_tolerance times this.", "5"},
+        {"export_socket", "UNIX-domain socket the logger's aggregates are published on while the run goes, one JSON line per sample (see Exporter.h). The loggers of a process share it, ranks add -<rank> to the path. Empty disables the export.", ""},
+        {"export_interval", "Logger cycles between published samples. Deadlock detection is always published.", "10"},
+        {"export_queue", "Samples queued for the export thread before the oldest is dropped. At least 1.", "64"},
+        {"reduce_children", "Number of child loggers connected on the child ports. With a parent or children the loggers decide on deadlock together: each sends its parent the summary of its segment and subtree when it changes, and only the root of the tree, the logger without a parent, applies the thresholds to the whole ring.", "0"},
+        {"reduce_latency", "Latency of the summary links. Only used by the root.", "1ms"},
+        {"reduce_depth", "Summary links from the deepest logger to the root. Only used by the root, which judges the ring as it was reduce_depth times reduce_latency plus one logger cycle before its view, when every summary of that time has arrived.", "0"},
+        {"predict_confirm_run", "Consecutive logger cycles without progress, with every monitored node stuck, after which deadlock is unavoidable. Must exceed the ring link latency plus the longest node tick period.", "10"},
     )
 
     /**
@@ -83,27 +149,202 @@ public:
 	 * 
 	 */
     SST_ELI_DOCUMENT_PORTS(
-        {"port%d", "Receives logging info from connected nodes", { "LogEvent" }},
+        {"port%d", "Receives logging info from connected nodes and sends them deadlock recovery requests. Only port0 with log_mode 'batch'.", { "LogEvent", "LogBatchEvent", "RecoveryEvent" }},
+        {"parent", "Sends the subtree summary to the parent logger and receives the ring-wide deadlock verdict. Not connected at the root.", { "SummaryEvent" }},
+        {"child%d", "Receives the subtree summaries of the child loggers and sends them the ring-wide deadlock verdict.", { "SummaryEvent" }},
+    )
+
+    /**
+	 * @brief Macro for documenting a component's statistics for SST-Info. Layout is: name, description, units, enable level.
+	 * 
+	 */
+    SST_ELI_DOCUMENT_STATISTICS(
+        {"blocked_nodes", "Number of monitored nodes that are idle and blocked by missing credits, sampled every tick.", "nodes", 1},
+        {"idle_time", "Logger cycles every monitored node has been idle for, one sample per node every tick.", "cycles", 1},
+        {"state_changes", "Number of times a monitored node changed state, counted when the change is seen.", "changes", 1},
+        {"recovery_time", "Logger cycles from a deadlock recovery until a node is executing again.", "cycles", 1},
+        {"stuck_fraction", "Fraction of monitored nodes stuck without credits, in percent, sampled every tick.", "percent", 1},
     )
 
 private:
+    /**
+     * @brief Take in a record that arrived in an event, now or once it is log_delay old.
+     * 
+     * @param log Record received from a node.
+     */
+    void receive(const Log &log);
+
+    /**
+     * @brief Apply the held back records that are at least log_delay old.
+     */
+    void applyPending();
+
+    /**
+     * @brief Update the data arrays with a node's latest record.
+     * 
+     * @param log Record received from a node.
+     */
+    void record(const Log &log);
+
+    /**
+     * @brief Read a deadlock threshold parameter as a time in ps.
+     * 
+     * @param name Parameter holding a simulated time, or a plain number of logger cycles.
+     */
+    int64_t threshold(SST::Params& params, const std::string &name);
+
+    /**
+     * @brief Whether a node's latest record is idle, and it has been idle and blocked
+     * for longer than the thresholds at the given time. Evaluated from the records'
+     * start times, so it holds for nodes of every clock alike.
+     * 
+     * @param i Index of the node in the data arrays.
+     * @param view Time the state is evaluated at in ps.
+     */
+    bool overThresholds(int i, int64_t view) const;
+
+    /**
+     * @brief Pass this segment's summary up the summary tree, and at the root decide on
+     * deadlock from the summary of the whole ring.
+     * 
+     * @param view Time the state is evaluated at in ps.
+     */
+    void reduce(int64_t view);
+
+    /**
+     * @brief Feed the predictor this tick's records and act on its verdict.
+     * 
+     * @param cycle Current cycle, continued from a restored snapshot.
+     */
+    void predict(SST::Cycle_t cycle);
+
+    /**
+     * @brief Feed the steady state monitor this tick's throughput and queue sizes, and
+     * report the metrics once they converge.
+     * 
+     * @param cycle Current cycle, continued from a restored snapshot.
+     */
+    void checkSteadyState(SST::Cycle_t cycle);
+
+    /**
+     * @brief Publish the current aggregates to the telemetry exporter.
+     * 
+     * @param cycle Current cycle, continued from a restored snapshot.
+     */
+    void exportState(SST::Cycle_t cycle);
+
+    /**
+     * @brief Resolve a deadlock by sending a recovery request to a victim node.
+     * 
+     * @param cycle Current cycle, continued from a restored snapshot.
+     */
+    void recover(SST::Cycle_t cycle);
+
+    /**
+     * @brief Applies `ser & member` to every member that makes up the logger's state.
+     * 
+     * @param ser Serializer that is sizing, packing or unpacking a snapshot.
+     */
+    void serializeSnapshot(SST::Core::Serialization::serializer &ser);
+
+    /**
+     * @brief Handlers timed by the profiler.
+     */
+    enum ProfileHandlers { PROFILE_TICK, PROFILE_MESSAGE };
+
+    Profiler profiler; //!< Handler timings. Only records when the profile parameter is set.
+
     SST::Output output; //!< SST Output object for printing to the console.
     SST::Output csvout; //!< SST Output object for printing to a csv file.
 
     SST::Link **port; //!< Pointer to an array of port pointers. Allows for variable number of ports to be dynamically allocated.
+    TelemetryTable *telemetry; //!< Table the nodes write their records to. NULL when records arrive as LogEvents.
+    bool batched; //!< Whether records arrive as LogBatchEvents on port0, from a segment component.
+    SST::SimTime_t logDelay; //!< Age of the evaluated state in core time (ps). 0 applies records as they arrive.
+    std::vector<Fifo<Log>> pending; //!< Records of every node not yet log_delay old, oldest first.
 
     std::string clock; //!< Logger Node's clock which accepts unit math as a string. (i.e. "1ms").
     int num_ports; //!< Number of ports that the logger node has.
+    int first_node; //!< ID of the node connected to port0. Node IDs are offset by this to index the data arrays.
     
     int *stateArray; //!< Pointer to data for each node's current state.
     int *stateChanges; //!< Pointer to data for how many times each node has changed states.
-    int *idleArray; //!< Pointer to data for each node's time idle.
-    int *requestArray; //!< Pointer to data for each node's number of requests to send a message.
+    int64_t *idleSince; //!< Pointer to data for the time each node's current idle run started at in ps.
+    int64_t *blockedSince; //!< Pointer to data for the time of each node's first tick without credits since it last sent in ps, NOT_BLOCKED if there was none.
+    int *idleArray; //!< Pointer to data for each node's time idle in logger cycles, evaluated from idleSince every tick.
+    int *requestArray; //!< Pointer to data for each node's time blocked in logger cycles, counting the first blocked cycle, evaluated from blockedSince every tick. 0 if not blocked.
+    int *stuckArray; //!< Pointer to data for whether each node is stuck without credits.
+    int *deliveredArray; //!< Pointer to data for each node's number of delivered messages.
+    int *queueArray; //!< Pointer to data for each node's queue size.
+
+    int64_t idle_threshold; //!< Time in ps all monitored nodes must have been idle for, longer than this, for deadlock to be declared.
+    int64_t request_threshold; //!< Time in ps all monitored nodes must have been blocked for, longer than this, for deadlock to be declared.
 
-    int idle_threshold; //!< The number of consecutive cycles idle that all monitored nodes must exceed for deadlock to be declared.
-    int request_threshold; //!< The number of consecutive request that all monitored nodes must exceed for deadlock to be declared.
+    bool csv; //!< Whether per-tick data is written to the CSV file.
+    bool exporting; //!< Whether samples are published to the telemetry exporter.
+    int exportInterval; //!< Logger cycles between published samples.
+
+    SST::Statistics::Statistic<uint64_t> *statBlockedNodes; //!< Statistic for the number of blocked nodes.
+    SST::Statistics::Statistic<uint64_t> *statIdleTime; //!< Statistic for the idle time of every node.
+    SST::Statistics::Statistic<uint64_t> *statStateChanges; //!< Statistic for node state changes.
+    SST::Statistics::Statistic<uint64_t> *statStuckFraction; //!< Statistic for the fraction of stuck nodes.
+    SST::Statistics::Statistic<uint64_t> *statRecoveryTime; //!< Statistic for the time to recover from a deadlock.
 
     bool deadlocked; //!< Declares if system is in deadlock.
+
+    bool reducing; //!< Whether deadlock is decided at the root of the summary tree instead of by every logger for its segment.
+    SST::Link *parentPort; //!< Link to the parent logger. NULL at the root.
+    std::vector<SST::Link*> childPorts; //!< Links to the child loggers.
+    SummaryTree summaries; //!< This logger's segment summary and the latest subtree summaries of its children.
+    SST::SimTime_t reduceDelay; //!< Time in ps for a summary to reach the root from the deepest logger.
+    uint64_t summariesSent; //!< Number of summaries sent to the parent.
+
+    /**
+     * @brief What the predictor does with its verdicts.
+     */
+    enum PredictorMode { PREDICT_OFF, PREDICT_ALARM, PREDICT_END };
+
+    PredictorMode predictorMode; //!< Whether the predictor runs and whether it ends the run.
+    DeadlockPredictor predictor; //!< Trend of the stuck fraction and of the ticks without progress.
+    bool alarmRaised; //!< Whether the alarm is up. Cleared when progress resumes.
+    int alarms; //!< Number of alarms raised.
+    int falseAlarms; //!< Number of alarms cleared by progress resuming.
+    int64_t unavoidableCycle; //!< Cycle deadlock was found unavoidable at. -1 until then.
+
+    /**
+     * @brief How the victim of a deadlock is picked.
+     */
+    enum VictimChoice { VICTIM_FULLEST, VICTIM_ROTATE };
+
+    bool recoveryEnabled; //!< Whether deadlocks are recovered from instead of ending the simulation.
+    Recovery recovery; //!< Request sent to the victim.
+    VictimChoice victimChoice; //!< How the victim is picked.
+    int recoveryHoldoff; //!< Logger cycles between recoveries.
+    int64_t holdoffUntil; //!< Cycle the next recovery may happen at.
+    int lastVictim; //!< Index of the last victim, -1 before the first recovery.
+    int64_t recoveringSince; //!< Cycle of the first recovery of the current deadlock, -1 when no node is stuck.
+    uint64_t recoveries; //!< Number of recovery requests sent.
+    uint64_t deadlocks; //!< Number of deadlocks recovered from.
+    uint64_t recoveredMessages; //!< Messages the victims took out of their queues, as seen in the records.
+    uint64_t recoveryCycles; //!< Sum of the cycles until the ring moved again after each deadlock.
+    int64_t lastCycle; //!< Latest cycle the logger ticked at, continued from a restored snapshot.
+
+    /**
+     * @brief What the steady state monitor does once the metrics converge.
+     */
+    enum SteadyMode { STEADY_OFF, STEADY_REPORT, STEADY_END };
+
+    SteadyMode steadyMode; //!< Whether the steady state monitor runs and whether it ends the run.
+    SteadyState steady; //!< Batch means of the delivered throughput and the mean queue size.
+    int64_t lastDelivered; //!< Messages delivered in the segment as of the last tick.
+    int64_t steadyCycle; //!< Cycle the steady state was reached at. -1 until then.
+
+    SST::TimeConverter *clockTC; //!< Time converter of the logger's clock.
+    SST::Link *snapshotLink; //!< Self link that wakes the logger up to take the snapshot. NULL without snapshot_at.
+    SST::SimTime_t snapshotTime; //!< Time the snapshot is taken at in core time (ps).
+    std::string snapshotDir; //!< Directory snapshots are written to.
+    std::string restoreDir; //!< Directory to restore a snapshot from. Empty when not restoring.
+    SST::SimTime_t timeOffset; //!< Simulated time of the restored snapshot in clock cycles, added to reported times.
 };
 
 #endif
\ No newline at end of file
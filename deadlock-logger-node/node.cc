@@ -6,33 +6,57 @@
 #include <sst/core/sst_config.h> 
 #include <sst/core/simulation.h>
 #include <sst/core/stopAction.h>
+#include <algorithm>
 #include "node.h" 
 
 // Constructor definition
-node::node( SST::ComponentId_t id, SST::Params& params) : SST::Component(id) {
+node::node( SST::ComponentId_t id, SST::Params& params) : SST::Component(id),
+	rng(10, params.find<int64_t>("randseed", 121212)) // Marsaglia RNG with a default value and the node's seed.
+{
 	output.init("deadlocksim-" + getName() + "->", 1, 0, SST::Output::STDOUT); // Formatting output for console.
 
 	// Get parameters
-	queueMaxSize = params.find<int64_t>("queueMaxSize", 50);
-	clock = params.find<std::string>("tickFreq", "10s");
-	randSeed = params.find<int64_t>("randseed", 121212);
+	int queueMaxSize = params.find<int64_t>("queueMaxSize", 50);
+	std::string clock = params.find<std::string>("tickFreq", "10s");
 	node_id = params.find<int64_t>("id", 1);
 	total_nodes = params.find<int64_t>("total_nodes", 5);
-	message_gen = params.find<float>("message_gen", 0.5);
+	float message_gen = params.find<float>("message_gen", 0.5);
 
-	// Initialize Variables
-	queueCurrSize = 0;
-	queueCredits = 0;
-	generated = 0;
-	rndNumber = 0;
+	// Node IDs must fit the packed Message header.
+	if (total_nodes > wire::MAX_NODES) {
+		output.fatal(CALL_INFO, -1, "total_nodes %d exceeds the %" PRId64 " nodes a Message can address\n", total_nodes, wire::MAX_NODES);
+	}
+
+	// Register statistics. Collection is enabled and routed to an output from the Python driver.
+	statIdleDuration = registerStatistic<uint64_t>("idle_duration");
+	statBlockRequests = registerStatistic<uint64_t>("block_requests");
+	statNodeState = registerStatistic<uint64_t>("node_state");
+	statQueueOccupancy = registerStatistic<uint64_t>("queue_occupancy");
+
+	// Handler profiling.
+	if (params.find<bool>("profile", false)) {
+		profiler.enable({ "tick", "messageHandler", "creditHandler", "sendLog" }, { "nextPort", "prevPort", "logPort" });
+		ProfileCollector::instance().expect();
+	}
 
-	// Initialize Random
-	rng = new SST::RNG::MarsagliaRNG(10, randSeed); // Create a Marsaglia RNG with a default value and a random seed.
+	// Initialize the queue and credit logic. It sends through injectMessage, forwardMessage, sendCredits and sendReverseCredits.
+	core.configure(this, &rng, node_id, total_nodes, queueMaxSize, message_gen);
+	std::string routing = params.find<std::string>("routing", "forward");
+	if (routing == "forward") {
+		core.setRouting(ROUTE_FORWARD);
+	} else if (routing == "shortest") {
+		core.setRouting(ROUTE_SHORTEST);
+	} else if (routing == "adaptive") {
+		core.setRouting(ROUTE_ADAPTIVE);
+	} else {
+		output.fatal(CALL_INFO, -1, "Unknown routing '%s', expected 'forward', 'shortest' or 'adaptive'\n", routing.c_str());
+	}
+	core.setTiming(params.find<bool>("latency", false));
 
 	// Set Main Clock
 	// Handler object is created with a reference to this object and a pointer to
 	// a function that is called on every clock tick event (?).
-	registerClock(clock, new SST::Clock::Handler<node>(this, &node::tick));
+	clockPeriod = registerClock(clock, new SST::Clock::Handler<node>(this, &node::tick))->getFactor();
 	
 	// Configure the port for receiving a message from a node.
 	nextPort = configureLink("nextPort", new SST::Event::Handler<node>(this, &node::creditHandler));
@@ -48,9 +72,52 @@ node::node( SST::ComponentId_t id, SST::Params& params) : SST::Component(id) {
 		output.fatal(CALL_INFO, -1, "Failed to configure port 'prevPort'\n");
 	}
 
+	// Log records go to the shared telemetry table if every component is in this process.
+	// Across ranks the logger can't see the table, so LogEvents are used instead.
+	telemetry = NULL;
+	if (params.find<std::string>("log_mode", "events") == "shared" && getNumRanks().rank == 1) {
+		telemetry = &TelemetryTable::instance();
+		if (!telemetry->reserve(total_nodes)) {
+			output.fatal(CALL_INFO, -1, "Telemetry table is sized for a different number of nodes\n");
+		}
+	}
+
+	// Snapshot and restore. Self links use a 1ps time base so delays are in core time.
+	snapshotDir = params.find<std::string>("snapshot_dir", "output/snapshot");
+	restoreDir = params.find<std::string>("restore_from", "");
+	capturing = false;
+	snapshotLink = NULL;
+	snapshotTime = 0;
+	std::string snapshot_at = params.find<std::string>("snapshot_at", "");
+	if (!snapshot_at.empty()) {
+		snapshotTime = registerTimeBase(snapshot_at, false)->getFactor();
+		if (snapshotTime == 0) {
+			output.fatal(CALL_INFO, -1, "snapshot_at must be later than the start of the simulation\n");
+		}
+		snapshotWindow = registerTimeBase(params.find<std::string>("snapshot_window", "1ms"), false)->getFactor();
+		snapshotLink = configureSelfLink("snapshotLink", "1ps", new SST::Event::Handler<node>(this, &node::snapshotHandler));
+		if (snapshotTime % clockPeriod != 0) {
+			output.verbose(CALL_INFO, 1, 0, "snapshot_at is not a multiple of the tick period, a restored run will tick at different times\n");
+		}
+	}
+	replayLink = NULL;
+	if (!restoreDir.empty()) {
+		replayLink = configureSelfLink("replayLink", "1ps", new SST::Event::Handler<node>(this, &node::replayHandler));
+	}
+
+	// Delivery recording, one stream shared by the components of the partition.
+	recorder = NULL;
+	std::string record_dir = params.find<std::string>("record_dir", "");
+	if (!record_dir.empty()) {
+		recorder = RecordStreams::instance().acquire(record_dir, getRank().rank, getRank().thread);
+		if (!recorder) {
+			output.fatal(CALL_INFO, -1, "Failed to create the record in %s\n", record_dir.c_str());
+		}
+	}
+
 	// Configure the port for sending log info to logger node.
 	logPort = configureLink("logPort", new SST::Event::Handler<node>(this, &node::logHandler));
-	if ( !logPort ) {
+	if ( !logPort && !telemetry ) {
 		output.fatal(CALL_INFO, -1, "Failed to configure port 'logPort'\n");
 	}
 }
@@ -64,62 +131,121 @@ node::~node() {
 void node::setup() {
 	output.verbose(CALL_INFO, 1, 0, "id %d initialized\n", node_id);
 
-	struct CreditProbe creds = { queueMaxSize - (int)msgqueue.size() }; // Send initial credits to all nodes during setup.
-	prevPort->send(new CreditEvent(creds));
-}
+	if (snapshotLink) {
+		snapshotLink->send(snapshotTime - 1, new TimerEvent());
+	}
 
-// SST Finish Phase, called for each node when the simulation ends and before all nodes are cleaned up.
-void node::finish() {
-	output.verbose(CALL_INFO, 1, 0, "Final queue size is %ld | Max queue size is %d | Final credit size is %d\n", msgqueue.size(), queueMaxSize, queueCredits);
-	struct Message top = msgqueue.front();
-	output.verbose(CALL_INFO, 1, 0, "Top of queue: Dest_ID-%d\n", top.dest_id);
-}
+	if (restoreDir.empty()) {
+		sendCredits(core.freeCredits()); // Send initial credits to all nodes during setup.
+		if (core.bidirectional()) {
+			sendReverseCredits(core.freeReverseCredits());
+		}
+		return;
+	}
 
-// Runs every clock tick
-bool node::tick( SST::Cycle_t currentCycle ) {
-	// Replace with output
-	if (node_id == 0) {
-		//output.verbose(CALL_INFO, 1, 0, "\n--------------------------Sim-Time: %lu--------------------------\n", getCurrentSimTime());
-		std::cout << "\n Sim-Time: " << getCurrentSimTime() << std::endl;
-	}	
-	output.verbose(CALL_INFO, 1, 0, "Status: %d | Credits: %d | Time Idle: %d | Requests %d\n", node_state, queueCredits, idle_duration, block_requests);
-	output.verbose(CALL_INFO, 2, 0, "Size of queue: %ld\n", msgqueue.size());
-	output.verbose(CALL_INFO, 2, 0, "Amount of credits: %d\n", queueCredits);
-
-	if (node_state == IDLE) {
-		idle_duration++;
-	} else {
-		idle_duration = 0;
-		block_requests = 0;
+	// Restore the saved state instead of starting empty. The credits the previous node
+	// holds are restored on its side, so no initial credits are sent.
+	int saved_max = core.queueMaxSize;
+	if (!snapshot::read(restoreDir, "node-" + std::to_string(node_id) + ".snap", [this](SST::Core::Serialization::serializer &ser) { serializeSnapshot(ser); serializeInflight(ser); })) {
+		output.fatal(CALL_INFO, -1, "Failed to read snapshot from %s\n", restoreDir.c_str());
+	}
+	if (core.node_id != node_id || core.queueMaxSize != saved_max) {
+		output.fatal(CALL_INFO, -1, "Snapshot is of a different node or queue size\n");
 	}
 
-	node_state = IDLE;
+	// Bring the RNG to the state it had when the snapshot was taken. Nothing has been drawn before setup.
+	for (uint64_t i = 0; i < core.rngDraws; ++i) {
+		rng.generateNextUInt32();
+	}
 
-	// Node is blocked from sending.
-	if (queueCredits <= 0) {
-		block_requests++;
+	// The state was taken just before the tick at the snapshot time, which is time 0 here.
+	// Clocks start one period in, so that tick runs now, before the events delivered at time 0.
+	tick(0);
+
+	// Deliver the events that were in flight at the same offsets they had from the snapshot time.
+	for (size_t i = 0; i < inflightOffsets.size(); ++i) {
+		SST::Event *ev;
+		if (inflightKinds[i] == INFLIGHT_MESSAGE) {
+			Message msg = unpackHeader(inflightPayloads[i]);
+			if (wire::flagsOf(inflightPayloads[i]) & wire::TIME_FLAG) {
+				msg.born = inflightBorn[i];
+			}
+			ev = new MessageEvent(msg);
+		} else {
+			struct CreditProbe creds = { (int)(inflightPayloads[i] >> 1), (Directions)(inflightPayloads[i] & 1) };
+			ev = new CreditEvent(creds);
+		}
+		if (inflightOffsets[i] == 0) {
+			replayHandler(ev);
+		} else {
+			replayLink->send(inflightOffsets[i] - 1, ev);
+		}
 	}
+	output.verbose(CALL_INFO, 1, 0, "Restored %d queued messages and %ld events in flight\n", core.queued(), inflightOffsets.size());
+	inflightOffsets.clear();
+	inflightKinds.clear();
+	inflightPayloads.clear();
+	inflightBorn.clear();
+}
 
-	// Rng and generate message to send out.
-	if (queueCredits > 0) {	
-		addMessage();
+// SST Finish Phase, called for each node when the simulation ends and before all nodes are cleaned up.
+void node::finish() {
+	output.verbose(CALL_INFO, 1, 0, "Final queue size is %ld | Max queue size is %d | Final credit size is %d\n", core.msgqueue.size(), core.queueMaxSize, core.queueCredits);
+	if (!core.msgqueue.empty()) {
+		struct Message top = core.msgqueue.front();
+		output.verbose(CALL_INFO, 1, 0, "Top of queue: Dest_ID-%d\n", top.dest_id);
+	}
+	output.verbose(CALL_INFO, 1, 0, "Messages generated %" PRIu64 " | forwarded %" PRIu64 " | consumed %" PRIu64 " | dropped %" PRIu64 "\n", core.injected, core.forwarded, core.consumed, core.dropped);
+	if (core.bidirectional()) {
+		output.verbose(CALL_INFO, 1, 0, "Final reverse queue size is %ld | Final reverse credit size is %d | Generated in reverse %" PRIu64 "\n", core.reverseQueue.size(), core.reverseCredits, core.injectedReverse);
+	}
+	// The latency is only known with the latency parameter.
+	if (core.timedConsumed > 0) {
+		output.verbose(CALL_INFO, 1, 0, "Mean hops %.2f | mean latency %.3f ms\n", (double)core.hopsConsumed / core.consumed, core.latencyConsumed / 1e9 / core.timedConsumed);
+	} else if (core.consumed > 0) {
+		output.verbose(CALL_INFO, 1, 0, "Mean hops %.2f\n", (double)core.hopsConsumed / core.consumed);
+	}
+	if (core.recoveryDropped + core.recoveryRerouted + core.recoveryDrained > 0) {
+		output.verbose(CALL_INFO, 1, 0, "Recovery dropped %" PRIu64 " | rerouted %" PRIu64 " | drained %" PRIu64 " | still in the recovery buffer %ld\n", core.recoveryDropped, core.recoveryRerouted, core.recoveryDrained, core.recoveryBuffer.size());
 	}
 
-	// Send a message out every tick if the next nodes queue is not full,
-	// AND if the node has messages in its queue to send.
-	if ((generated != 1 && (queueCredits > 0 && msgqueue.size() > 0))) {
-		sendMessage();
-		sendCredits();
-	} else if (generated != 1 && !msgqueue.empty()) {
-		// Peek at the top message to see if it needs to be delivered to the next node.
-		struct Message top = msgqueue.front();
-		if (top.dest_id == (node_id + 1) % total_nodes) {
-			sendMessage();
-			sendCredits();
+	// Report handler profile and add it to the merged per-run profile.
+	if (profiler.isEnabled()) {
+		double scale = profiler.nsPerCycle();
+		for (const Profiler::Handler &h : profiler.getHandlers()) {
+			output.verbose(CALL_INFO, 1, 0, "Profile %s: %" PRIu64 " calls | %.3f ms total | %.0f ns max\n", h.name.c_str(), h.calls, h.cycles * scale / 1e6, h.max * scale);
+		}
+		std::string path = getNumRanks().rank > 1 ? "output/profile-" + std::to_string(getRank().rank) + ".json" : "output/profile.json";
+		if (!ProfileCollector::instance().submit(getName(), "node", profiler, path)) {
+			output.verbose(CALL_INFO, 1, 0, "Failed to write %s\n", path.c_str());
 		}
 	}
 
-	generated = 0;
+	// The last component of the partition closes the record.
+	if (recorder && !RecordStreams::instance().release(recorder, getCurrentSimCycle())) {
+		output.verbose(CALL_INFO, 1, 0, "Failed to write the record\n");
+	}
+
+	// Write out the trace buffer. Does nothing unless built with tracing (make trace).
+	if (!tracer.dump("node-" + std::to_string(node_id), node_id)) {
+		output.verbose(CALL_INFO, 1, 0, "Failed to write trace file\n");
+	}
+}
+
+// Runs every clock tick
+bool node::tick( SST::Cycle_t currentCycle ) {
+	ProfileScope scope(profiler, PROFILE_TICK);
+	TRACE(tracer, 1, getCurrentSimCycle(), TRACE_TICK, core.msgqueue.size(), core.queueCredits, core.node_state);
+
+	core.tick();
+
+	SST::SimTime_t now = getCurrentSimCycle();
+	TRACE(tracer, 1, now, TRACE_COUNTERS, core.idleFor(now) / 1000000, core.blockedFor(now) < 0 ? -1 : core.blockedFor(now) / 1000000);
+
+	statIdleDuration->addData(core.idleFor(now));
+	statBlockRequests->addData(std::max<int64_t>(core.blockedFor(now), 0));
+	statNodeState->addData(core.node_state);
+	statQueueOccupancy->addData(core.queued());
 
 	sendLog();
 
@@ -127,80 +253,245 @@ bool node::tick( SST::Cycle_t currentCycle ) {
 }
 
 void node::messageHandler(SST::Event *ev) {
-	MessageEvent *me = dynamic_cast<MessageEvent*>(ev);
-	if ( me != NULL ) {
-		switch (me->msg.type)
-		{
-			case MESSAGE:
-				output.verbose(CALL_INFO, 2, 0, "is receiving a message from node %d.\n", me->msg.source_id);
-				output.verbose(CALL_INFO, 2, 0, "Message Details: SourceID %d | DestID %d\n", me->msg.source_id, me->msg.dest_id);
-
-				// Check if the message is meant for the node and that the node has correct space.	
-				if (me->msg.dest_id != node_id && msgqueue.size() < queueMaxSize) {
-					//output.verbose(CALL_INFO, 2, 0, "Sending a message. Queue size is now %ld\n", msgqueue.size());
-					output.verbose(CALL_INFO, 2, 0, "Message was added to the queue\n");
-					msgqueue.push(me->msg);
-					sendCredits(); 
-				} else if (me->msg.dest_id == node_id) {
-					output.verbose(CALL_INFO, 2, 0, "Consumed a message\n");
-				} else if (msgqueue.size() >= queueMaxSize) {
-					output.verbose(CALL_INFO, 2, 0, "Message was dropped\n");
-				}
-				break;
-		}
+	// In a bidirectional ring prevPort also receives reverse credits.
+	if (static_cast<RingEvent*>(ev)->kind == RingEvent::CREDIT_EVENT) {
+		creditHandler(ev);
+		return;
+	}
+	ProfileScope scope(profiler, PROFILE_MESSAGE);
+	MessageEvent *me = static_cast<MessageEvent*>(ev);
+	if (recorder) {
+		recorder->write(messageRecord(getCurrentSimCycle(), node_id, me->msg));
+	}
+	switch (me->msg.type)
+	{
+		case MESSAGE:
+		case ESCAPE:
+			TRACE(tracer, 2, getCurrentSimCycle(), TRACE_MSG_RECEIVED, me->msg.source_id, me->msg.dest_id);
+			if (capturing) {
+				captureInflight(INFLIGHT_MESSAGE, packHeader(me->msg), me->msg.born != UNTIMED ? me->msg.born - snapshotTime : 0);
+			}
+
+			// Queue or consume the message, credits are returned by the core.
+			switch (core.receiveMessage(me->msg)) {
+				case Core::QUEUED:
+					TRACE(tracer, 2, getCurrentSimCycle(), TRACE_MSG_QUEUED, me->msg.source_id, me->msg.dest_id, core.msgqueue.size());
+					break;
+				case Core::CONSUMED:
+					TRACE(tracer, 2, getCurrentSimCycle(), TRACE_MSG_CONSUMED, me->msg.source_id);
+					break;
+				case Core::DROPPED:
+					TRACE(tracer, 2, getCurrentSimCycle(), TRACE_MSG_DROPPED, me->msg.source_id, me->msg.dest_id);
+					break;
+				case Core::ESCAPED:
+					break;
+			}
+			break;
 	}
 	delete ev; // Clean up event to prevent memory leaks.
 }
 
 void node::logHandler( SST::Event *ev ) {
-	output.fatal(CALL_INFO, -1, "Node should not be receiving logging info from logger node. Error!");
+	RecoveryEvent *re = dynamic_cast<RecoveryEvent*>(ev);
+	if (re == NULL) {
+		output.fatal(CALL_INFO, -1, "Node should not be receiving logging info from logger node. Error!");
+	}
+	if (recorder) {
+		recorder->write(recoveryRecord(getCurrentSimCycle(), node_id, re->recovery));
+	}
+	int taken = core.recover(re->recovery);
+	output.verbose(CALL_INFO, 1, 0, "Deadlock recovery took %d messages out of the queue\n", taken);
 	delete ev;
 }
 
 void node::creditHandler(SST::Event *ev) {
-	CreditEvent *ce = dynamic_cast<CreditEvent*>(ev);
-	if ( ce != NULL ) {
-		queueCredits = ce->probe.credits;
+	// In a bidirectional ring nextPort also receives reverse messages.
+	if (static_cast<RingEvent*>(ev)->kind == RingEvent::MESSAGE_EVENT) {
+		messageHandler(ev);
+		return;
+	}
+	ProfileScope scope(profiler, PROFILE_CREDIT);
+	CreditEvent *ce = static_cast<CreditEvent*>(ev);
+	if (recorder) {
+		recorder->write(creditRecord(getCurrentSimCycle(), node_id, ce->probe.credits, ce->probe.direction));
+	}
+	if (ce->probe.direction == REVERSE) {
+		core.receiveReverseCredits(ce->probe.credits);
+	} else {
+		core.receiveCredits(ce->probe.credits);
+	}
+	if (capturing) {
+		captureInflight(INFLIGHT_CREDIT, (uint64_t)ce->probe.credits << 1 | ce->probe.direction);
+	}
+	delete ev; // Clean up event to prevent memory leaks.
+}
+
+void node::replayHandler(SST::Event *ev) {
+	// Both handlers pass on events of the other kind.
+	messageHandler(ev);
+}
+
+void node::snapshotHandler(SST::Event *ev) {
+	delete ev;
+	if (!capturing) {
+		// Snapshot time. The state is packed now, before anything of the window is applied to it.
+		// Everything delivered from now until the end of the window was sent before this point
+		// and is saved as in flight.
+		snapshotState = snapshot::pack([this](SST::Core::Serialization::serializer &ser) { serializeSnapshot(ser); });
+		capturing = true;
+		snapshotLink->send(snapshotWindow, new TimerEvent());
+		return;
+	}
+
+	capturing = false;
+	std::vector<char> inflight = snapshot::pack([this](SST::Core::Serialization::serializer &ser) { serializeInflight(ser); });
+	snapshotState.insert(snapshotState.end(), inflight.begin(), inflight.end());
+	if (!snapshot::writeFile(snapshotDir, "node-" + std::to_string(node_id) + ".snap", snapshotState)) {
+		output.fatal(CALL_INFO, -1, "Failed to write snapshot to %s\n", snapshotDir.c_str());
 	}
+	output.verbose(CALL_INFO, 1, 0, "Snapshot taken with %ld events in flight\n", inflightOffsets.size());
+	snapshotState.clear();
+	inflightOffsets.clear();
+	inflightKinds.clear();
+	inflightPayloads.clear();
+	inflightBorn.clear();
+}
+
+void node::captureInflight(int kind, uint64_t payload, uint64_t born) {
+	inflightOffsets.push_back(getCurrentSimCycle() - snapshotTime);
+	inflightKinds.push_back(kind);
+	inflightPayloads.push_back(payload);
+	inflightBorn.push_back(born);
+}
+
+void node::serializeSnapshot(SST::Core::Serialization::serializer &ser) {
+	// The queues are saved as packed Message words. A timed message's word is followed by its
+	// generation time relative to the snapshot time, which is time 0 of the restored run. Times
+	// before it wrap around, now - born still gives the right latency.
+	auto pack = [this](Fifo<Message> copy) {
+		std::vector<uint64_t> words;
+		while (!copy.empty()) {
+			words.push_back(packHeader(copy.front()));
+			if (copy.front().born != UNTIMED) {
+				words.push_back(copy.front().born - snapshotTime);
+			}
+			copy.pop();
+		}
+		return words;
+	};
+	auto unpack = [](const std::vector<uint64_t> &words) {
+		Fifo<Message> queue;
+		for (size_t i = 0; i < words.size(); ++i) {
+			Message msg = unpackHeader(words[i]);
+			if (wire::flagsOf(words[i]) & wire::TIME_FLAG) {
+				msg.born = words[++i];
+			}
+			queue.push(msg);
+		}
+		return queue;
+	};
+	std::vector<uint64_t> queueWords;
+	std::vector<uint64_t> recoveryWords;
+	std::vector<uint64_t> reverseWords;
+	if (ser.mode() != SST::Core::Serialization::serializer::UNPACK) {
+		queueWords = pack(core.msgqueue);
+		recoveryWords = pack(core.recoveryBuffer);
+		reverseWords = pack(core.reverseQueue);
+	}
+
+	ser & core.node_id;
+	ser & core.queueMaxSize;
+	ser & queueWords;
+	ser & core.queueCredits;
+	ser & core.generated;
+	ser & core.node_state;
+	// Idle and blocked runs are saved relative to the snapshot time, which is time 0 of the restored run.
+	int64_t idleSince = core.idle_since - (int64_t)snapshotTime;
+	int64_t blockedSince = core.blocked_since == NOT_BLOCKED ? NOT_BLOCKED : core.blocked_since - (int64_t)snapshotTime;
+	ser & idleSince;
+	ser & blockedSince;
+	ser & core.rngDraws;
+	ser & core.injected;
+	ser & core.forwarded;
+	ser & core.consumed;
+	ser & core.dropped;
+	ser & recoveryWords;
+	ser & core.recoveryDropped;
+	ser & core.recoveryRerouted;
+	ser & core.recoveryDrained;
+	ser & reverseWords;
+	ser & core.reverseCredits;
+	ser & core.injectedReverse;
+	ser & core.hopsConsumed;
+	ser & core.latencyConsumed;
+	ser & core.timedConsumed;
+
+	if (ser.mode() == SST::Core::Serialization::serializer::UNPACK) {
+		core.msgqueue = unpack(queueWords);
+		core.recoveryBuffer = unpack(recoveryWords);
+		core.reverseQueue = unpack(reverseWords);
+		core.idle_since = idleSince;
+		core.blocked_since = blockedSince;
+	}
+}
+
+void node::serializeInflight(SST::Core::Serialization::serializer &ser) {
+	ser & inflightOffsets;
+	ser & inflightKinds;
+	ser & inflightPayloads;
+	ser & inflightBorn;
 }
 
 // Simulate sending a single message out to linked component in composition.
-void node::sendMessage() {
-	node_state = EXECUTING;
-	struct Message msg = msgqueue.front();
-	msgqueue.pop();
-	nextPort->send(new MessageEvent(msg));
+void node::forwardMessage(const Message &msg) {
+	TRACE(tracer, 2, getCurrentSimCycle(), TRACE_MSG_SENT, msg.source_id, msg.dest_id);
+	sendMessage(msg);
+}
+
+// Simulation purposes, a message generated randomly by the core is sent to the next node.
+void node::injectMessage(const Message &msg) {
+	TRACE(tracer, 2, getCurrentSimCycle(), TRACE_MSG_GENERATED, msg.dest_id);
+	sendMessage(msg);
+}
+
+// Messages go to the next node, REVERSE ones to the previous node.
+void node::sendMessage(const Message &msg) {
+	if (msg.direction == REVERSE) {
+		prevPort->send(new MessageEvent(msg));
+		profiler.countSend(PROFILE_PREVPORT);
+	} else {
+		nextPort->send(new MessageEvent(msg));
+		profiler.countSend(PROFILE_NEXTPORT);
+	}
 }
 
 // Send number of credits left to the previous node.
-void node::sendCredits() {
+void node::sendCredits(int credits) {
 	// Construct credit message to send.
-	output.verbose(CALL_INFO, 2, 0, "Sending credits\n");
-	struct CreditProbe creds = { queueMaxSize - (int)msgqueue.size() };
+	struct CreditProbe creds = { credits, FORWARD };
+	TRACE(tracer, 2, getCurrentSimCycle(), TRACE_CREDITS_SENT, creds.credits);
 	prevPort->send(new CreditEvent(creds));
+	profiler.countSend(PROFILE_PREVPORT);
 }
 
-void node::sendLog() {
-	output.verbose(CALL_INFO, 2, 0, "Sending log data\n");
-	struct Log log = { idle_duration, node_state, block_requests, node_id };
-	logPort->send(new LogEvent(log));
+// Send number of credits left in the reverse queue to the next node.
+void node::sendReverseCredits(int credits) {
+	struct CreditProbe creds = { credits, REVERSE };
+	TRACE(tracer, 2, getCurrentSimCycle(), TRACE_CREDITS_SENT, creds.credits);
+	nextPort->send(new CreditEvent(creds));
+	profiler.countSend(PROFILE_NEXTPORT);
 }
 
-// Simulation purposes, generate messages randomly and send to next node.
-void node::addMessage() {
-	node_state = EXECUTING;	
-	rndNumber = (rng->nextUniform()); // Generate a random 32-bit integer
-	
-	if (rndNumber <= message_gen) {
-		// Construct and send a message
-		generated = 1;
-
-		// Generate a random destination node that exist in the simulation.
-		int rndNode = (int)(rng->generateNextInt32());
-		rndNode = abs((int)(rndNode % total_nodes)); // Generate a integer 0-(Total Nodes - 1)
-		output.verbose(CALL_INFO, 2, 0, "Generating a message.\n");
-		struct Message newMsg = { node_id, rndNode, SENDING, MESSAGE};
-		nextPort->send(new MessageEvent(newMsg));
+void node::sendLog() {
+	ProfileScope scope(profiler, PROFILE_SENDLOG);
+	SST::SimTime_t now = getCurrentSimCycle();
+	struct Log log = { core.idle_since, core.node_state, core.blocked_since, node_id, core.stuck(), (int)core.consumed, core.queued(), now };
+	TRACE(tracer, 2, now, TRACE_LOG_SENT, core.idleFor(now) / 1000000, log.node_status, core.blockedFor(now) < 0 ? -1 : core.blockedFor(now) / 1000000);
+	if (telemetry) {
+		telemetry->publish(log);
+	} else {
+		logPort->send(new LogEvent(log));
+		profiler.countSend(PROFILE_LOGPORT);
 	}
 }
 
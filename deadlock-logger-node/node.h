@@ -7,9 +7,12 @@
 #include <sst/core/rng/marsaglia.h>
 #include <queue>
 #include "CommunicationEvents.h"
-
-#define IDLE 0
-#define EXECUTING 1
+#include "RingNode.h"
+#include "Telemetry.h"
+#include "Trace.h"
+#include "Profile.h"
+#include "Snapshot.h"
+#include "Record.h"
 
 /**
  * @brief Node Component Class. The Node generates or passes along messages in its queue
@@ -71,12 +74,28 @@ public:
 	void creditHandler(SST::Event *ev);
 	
 	/**
-	 * @brief Handles log information received from a logger. A node should not call this function.
+	 * @brief Handles recovery requests from the logger when it picked this node to resolve a deadlock.
+	 * Any other event from the logger is an error.
 	 * 
-	 * @param ev LogEvent that the component received.
+	 * @param ev RecoveryEvent that the component received.
 	 */
 	void logHandler(SST::Event *ev);
 
+	/**
+	 * @brief Packs the node's state at snapshot_at, and writes it to a file together with
+	 * the events in flight at that time once they have been captured.
+	 * 
+	 * @param ev TimerEvent sent over the snapshot self link.
+	 */
+	void snapshotHandler(SST::Event *ev);
+
+	/**
+	 * @brief Delivers an event that was in flight when the restored snapshot was taken.
+	 * 
+	 * @param ev MessageEvent or CreditEvent sent over the replay self link.
+	 */
+	void replayHandler(SST::Event *ev);
+
 	
 
 	
@@ -106,7 +125,17 @@ public:
 		{"tickFreq", "The frequency the component is called at.", "10s"},
 		{"id", "ID for the node.", "1"},
 		{"total_nodes", "Number of nodes in simulation.", "1"},
-		{"message_gen", "probability that a message is generated by a node instead of it sending one out of its queue."}
+		{"message_gen", "probability that a message is generated by a node instead of it sending one out of its queue."},
+		{"randseed", "Seed of the node's message generator.", "121212"},
+		{"profile", "Record call counts and wall-clock time of every handler and events sent per port. Reported at finish and merged into output/profile.json.", "false"},
+		{"snapshot_at", "Simulated time to snapshot the node's state at, for example 300ms. Should be a multiple of every node's tick period. Empty takes no snapshot.", ""},
+		{"snapshot_window", "Latency of the ring links. Events arriving this long after snapshot_at were in flight and are saved too.", "1ms"},
+		{"snapshot_dir", "Directory the snapshot is written to.", "output/snapshot"},
+		{"restore_from", "Directory of a snapshot to start from instead of an empty ring. Empty starts normally.", ""},
+		{"routing", "How messages travel. 'forward' is the unidirectional ring. 'shortest' and 'adaptive' make it bidirectional, with a reverse queue of queueMaxSize and reverse credits over the same links. 'shortest' sends every message the way with fewer hops, 'adaptive' takes the other way when only that one has credits. Every node must agree.", "forward"},
+		{"latency", "Stamp every generated message with its generation time and report the mean latency at finish. Timed messages take a second word on the wire.", "false"},
+		{"log_mode", "How log records reach the logger. 'events' sends a LogEvent over logPort every tick, 'shared' writes them to an in-process table the logger reads. 'shared' falls back to 'events' on more than one rank.", "events"},
+		{"record_dir", "Directory to record every event delivered to the node in, for standalone/replay. The components of a partition share one append-only stream, rank-<r>-thread-<t>.bin. Empty records nothing.", ""}
 	)
 
 	/**
@@ -114,10 +143,21 @@ public:
 	 * 
 	 */
 	SST_ELI_DOCUMENT_PORTS(
-		{"nextPort", "Port which receives credit probe from the next node.", {"MessageEvent"}},
-		{"prevPort", "Port which receives Message info from previous node.", {"CreditEvent"}},
-		{"logPort", "Port which sends out logging info to logger node", {"LogEvent"}},
+		{"nextPort", "Port which receives credit probe from the next node, and reverse messages in a bidirectional ring.", {"MessageEvent", "CreditEvent"}},
+		{"prevPort", "Port which receives Message info from previous node, and reverse credits in a bidirectional ring.", {"CreditEvent", "MessageEvent"}},
+		{"logPort", "Port which sends out logging info to logger node and receives deadlock recovery requests", {"LogEvent", "RecoveryEvent"}},
 	)	
+
+	/**
+	 * @brief Macro for documenting a component's statistics for SST-Info. Layout is: name, description, units, enable level.
+	 * 
+	 */
+	SST_ELI_DOCUMENT_STATISTICS(
+		{"idle_duration", "Time the node has been idle for, sampled every tick.", "ps", 1},
+		{"block_requests", "Time since the node's first tick without credits since it last sent, sampled every tick.", "ps", 1},
+		{"node_state", "State of the node (0 idle, 1 executing), sampled every tick.", "state", 1},
+		{"queue_occupancy", "Number of messages in the node's queue, sampled every tick.", "messages", 1},
+	)
 	/**
 	 * \endcond  
 	 */
@@ -126,36 +166,90 @@ public:
 
 private:
 	SST::Output output; //!< SST Output object for printing to the console.
+	Tracer tracer; //!< Binary trace of the hot paths. Empty unless built with DEADLOCK_TRACE_LEVEL > 0.
+
+	/**
+	 * @brief Handlers timed by the profiler.
+	 */
+	enum ProfileHandlers { PROFILE_TICK, PROFILE_MESSAGE, PROFILE_CREDIT, PROFILE_SENDLOG };
 
-	std::queue<Message> msgqueue; //!< Queue that stores Message structures.
-	int queueMaxSize; //!< Maximum size of node's queue.
-	int queueCurrSize; //!< Current size of node's queue.
-	int queueCredits; //!< Amount of space left in the connected node's queue. 
+	/**
+	 * @brief Ports whose sent events are counted by the profiler.
+	 */
+	enum ProfilePorts { PROFILE_NEXTPORT, PROFILE_PREVPORT, PROFILE_LOGPORT };
+
+	Profiler profiler; //!< Handler timings and event counts. Only records when the profile parameter is set.
+	RecordWriter *recorder; //!< Delivery record of the node's partition. NULL unless record_dir is set.
 
-	int64_t randSeed; //!< Seed for MarsagliaRNG
-	SST::RNG::MarsagliaRNG *rng; //!< Pointer to MarsagliaRNG object.
-	int generated; //!< Lock so that if a node generates a message it will not also send out a message from its queue as well in one tick.
+	typedef RingNode<node, SST::RNG::MarsagliaRNG> Core; //!< Queue and credit logic shared with the standalone driver.
+	friend Core;
+	Core core; //!< Queue, credits and counters of the node. Sends through the members below.
+
+	SST::RNG::MarsagliaRNG rng; //!< Message generator, seeded with randseed. Held by value to spare a heap block per node.
 
 	int node_id; //!< User's ID for each node. Unrelated to simulator's ID for the component. 
 	int total_nodes; //!< Total number of nodes in simulation.
 
-	void sendMessage(); //!< Sends a single message across a link from one node to a connected node.
-	void sendCredits(); //!< Sends number of credits to previous connected node.
-	void addMessage(); 	//!< Utilize RNG to generate a message and send it out from a node.
+	void injectMessage(const Message &msg); //!< Sends a newly generated message to the next node, or the previous one if it is REVERSE. Called by core.
+	void forwardMessage(const Message &msg); //!< Sends a message taken from a queue on in its direction. Called by core.
+	void sendMessage(const Message &msg); //!< Sends a message to the next or previous node by its direction.
+	void sendCredits(int credits); //!< Sends number of credits to previous connected node. Called by core.
+	void sendReverseCredits(int credits); //!< Sends number of reverse credits to the next node. Called by core.
+	uint64_t now() const { return getCurrentSimCycle(); } //!< Current time in ps, the generation time of new messages. Called by core.
 	inline void sendLog();	//!< Send logging data to global logging node.
 
 	SST::Link *nextPort; //!< Pointer to node's port that messages will be sent to.
 	SST::Link *prevPort; //!< Pointer to node's port that will receive credit information.
 	SST::Link *logPort;  //!< Pointer to node's port that will send log info to logger node.
+	TelemetryTable *telemetry; //!< Table log records are written to instead of logPort. NULL when sending LogEvents.
 
-	std::string clock; //!< Node's clock which accepts unit math as a string. (i.e "1ms").
+	SST::SimTime_t clockPeriod; //!< Tick period in core time (ps).
 
-	bool node_state; //!< Stores what state the node is in. 
-	int idle_duration; //!< Captures the duration of time the node has been idle.
-	int block_requests; //!< Amount of times the node has attempted to send a message to a node connected to it.	
+	/**
+	 * @brief Applies `ser & member` to every member that makes up the node's state.
+	 * 
+	 * @param ser Serializer that is sizing, packing or unpacking a snapshot.
+	 */
+	void serializeSnapshot(SST::Core::Serialization::serializer &ser);
 
-	float message_gen; //!< Probability that a message is generated by a node.
-	double rndNumber; //!< Randomly generated number for message gen.
+	/**
+	 * @brief Applies `ser & member` to the events in flight, saved after the node's state.
+	 * 
+	 * @param ser Serializer that is sizing, packing or unpacking a snapshot.
+	 */
+	void serializeInflight(SST::Core::Serialization::serializer &ser);
+
+	/**
+	 * @brief Kinds of events saved as in flight in a snapshot.
+	 */
+	enum InflightKinds { INFLIGHT_MESSAGE, INFLIGHT_CREDIT };
+
+	/**
+	 * @brief Save an event delivered while the snapshot is capturing events in flight.
+	 * 
+	 * @param kind InflightKinds value.
+	 * @param payload Packed Message, or credit count shifted left by one with the direction in the low bit.
+	 * @param born Generation time of a timed message relative to snapshotTime, 0 otherwise.
+	 */
+	void captureInflight(int kind, uint64_t payload, uint64_t born = 0);
+
+	SST::Link *snapshotLink; //!< Self link that wakes the node up to take the snapshot. NULL without snapshot_at.
+	SST::Link *replayLink; //!< Self link that delivers restored events in flight. NULL unless restoring.
+	SST::SimTime_t snapshotTime; //!< Time the snapshot is taken at in core time (ps).
+	SST::SimTime_t snapshotWindow; //!< How long after snapshotTime events are captured as in flight (ps).
+	std::string snapshotDir; //!< Directory snapshots are written to.
+	std::string restoreDir; //!< Directory to restore a snapshot from. Empty when not restoring.
+	bool capturing; //!< Whether delivered events are being saved as in flight.
+	std::vector<char> snapshotState; //!< State packed at snapshotTime, written once the events in flight are captured.
+	std::vector<uint64_t> inflightOffsets; //!< Delivery time of every in flight event, relative to snapshotTime.
+	std::vector<int> inflightKinds; //!< InflightKinds of every in flight event.
+	std::vector<uint64_t> inflightPayloads; //!< Payload of every in flight event.
+	std::vector<uint64_t> inflightBorn; //!< Generation time of every in flight timed message, relative to snapshotTime.
+
+	SST::Statistics::Statistic<uint64_t> *statIdleDuration; //!< Statistic for idle_duration.
+	SST::Statistics::Statistic<uint64_t> *statBlockRequests; //!< Statistic for block_requests.
+	SST::Statistics::Statistic<uint64_t> *statNodeState; //!< Statistic for node_state.
+	SST::Statistics::Statistic<uint64_t> *statQueueOccupancy; //!< Statistic for the size of msgqueue.
 };
 
 #endif
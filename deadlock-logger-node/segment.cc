@@ -0,0 +1,274 @@
+/// \file
+/**
+   A contiguous stretch of ring nodes simulated by one component.
+ */
+
+#include <sst/core/sst_config.h>
+#include <sst/core/simulation.h>
+#include <algorithm>
+#include "segment.h"
+
+// Constructor definition
+segment::segment( SST::ComponentId_t id, SST::Params& params) : SST::Component(id)
+{
+	// Per-node lines are printed as "deadlocksim-Node <id>->", like the node component's.
+	output.init("deadlocksim-", 1, 0, SST::Output::STDOUT);
+
+	// Get parameters
+	first_node = params.find<int64_t>("first_node", 0);
+	num_nodes = params.find<int64_t>("num_nodes", 1);
+	total_nodes = params.find<int64_t>("total_nodes", first_node + num_nodes);
+	if (num_nodes < 1 || first_node + num_nodes > total_nodes) {
+		output.fatal(CALL_INFO, -1, "Segment of %d nodes from node %d does not fit a ring of %d nodes\n", num_nodes, first_node, total_nodes);
+	}
+	if (total_nodes > wire::MAX_NODES) {
+		output.fatal(CALL_INFO, -1, "total_nodes %d exceeds the %" PRId64 " nodes a Message can address\n", total_nodes, wire::MAX_NODES);
+	}
+
+	// Per node values override the shared ones.
+	std::vector<int> queueSizes(num_nodes, params.find<int64_t>("queueMaxSize", 50));
+	std::vector<std::string> tickFreqs(num_nodes, params.find<std::string>("tickFreq", "10s"));
+	std::vector<float> messageGens(num_nodes, params.find<float>("message_gen", 0.5));
+	std::vector<int64_t> randSeeds(num_nodes, params.find<int64_t>("randseed", 121212));
+	if (params.contains("queue_sizes")) {
+		params.find_array<int>("queue_sizes", queueSizes);
+	}
+	if (params.contains("tick_freqs")) {
+		params.find_array<std::string>("tick_freqs", tickFreqs);
+	}
+	if (params.contains("message_gens")) {
+		params.find_array<float>("message_gens", messageGens);
+	}
+	if (params.contains("randseeds")) {
+		params.find_array<int64_t>("randseeds", randSeeds);
+	}
+	if ((int)queueSizes.size() != num_nodes || (int)tickFreqs.size() != num_nodes || (int)messageGens.size() != num_nodes || (int)randSeeds.size() != num_nodes) {
+		output.fatal(CALL_INFO, -1, "Per node parameters must have num_nodes (%d) values\n", num_nodes);
+	}
+
+	RoutingModes routing = ROUTE_FORWARD;
+	std::string routing_mode = params.find<std::string>("routing", "forward");
+	if (routing_mode == "shortest") {
+		routing = ROUTE_SHORTEST;
+	} else if (routing_mode == "adaptive") {
+		routing = ROUTE_ADAPTIVE;
+	} else if (routing_mode != "forward") {
+		output.fatal(CALL_INFO, -1, "Unknown routing '%s', expected 'forward', 'shortest' or 'adaptive'\n", routing_mode.c_str());
+	}
+
+	bool timed = params.find<bool>("latency", false);
+
+	// Register statistics. Collection is enabled and routed to an output from the Python driver.
+	statIdleDuration = registerStatistic<uint64_t>("idle_duration");
+	statBlockRequests = registerStatistic<uint64_t>("block_requests");
+	statNodeState = registerStatistic<uint64_t>("node_state");
+	statQueueOccupancy = registerStatistic<uint64_t>("queue_occupancy");
+
+	// The cores keep pointers to their port and RNG, so every vector is sized once.
+	ports.resize(num_nodes);
+	rngs.reserve(num_nodes);
+	cores.resize(num_nodes);
+	std::vector<std::string> groupFreqs;
+	for (int i = 0; i < num_nodes; ++i) {
+		ports[i] = { this, i };
+		rngs.emplace_back(10, randSeeds[i]); // Marsaglia RNG with a default value and the node's seed.
+		cores[i].configure(&ports[i], &rngs[i], first_node + i, total_nodes, queueSizes[i], messageGens[i]);
+		cores[i].setRouting(routing);
+		cores[i].setTiming(timed);
+
+		// One clock per tick period, as SST shares them between node components.
+		size_t g = 0;
+		while (g < groupFreqs.size() && groupFreqs[g] != tickFreqs[i]) {
+			g++;
+		}
+		if (g == groupFreqs.size()) {
+			groupFreqs.push_back(tickFreqs[i]);
+			groups.push_back({});
+		}
+		groups[g].push_back(i);
+	}
+	for (int g = 0; g < (int)groups.size(); ++g) {
+		registerClock(groupFreqs[g], new SST::Clock::Handler<segment, int>(this, &segment::tick, g));
+	}
+
+	// Configure the links at the ends of the segment and to the logger.
+	prevPort = configureLink("prevPort", new SST::Event::Handler<segment>(this, &segment::prevHandler));
+	if ( !prevPort ) {
+		output.fatal(CALL_INFO, -1, "Failed to configure port 'prevPort'\n");
+	}
+	nextPort = configureLink("nextPort", new SST::Event::Handler<segment>(this, &segment::nextHandler));
+	if ( !nextPort ) {
+		output.fatal(CALL_INFO, -1, "Failed to configure port 'nextPort'\n");
+	}
+	logPort = configureLink("logPort", new SST::Event::Handler<segment>(this, &segment::logHandler));
+	if ( !logPort ) {
+		output.fatal(CALL_INFO, -1, "Failed to configure port 'logPort'\n");
+	}
+	innerLink = configureSelfLink("innerLink", params.find<std::string>("link_latency", "1ms"), new SST::Event::Handler<segment>(this, &segment::innerHandler));
+
+	// Delivery recording, including the deliveries between nodes of the segment.
+	recorder = NULL;
+	std::string record_dir = params.find<std::string>("record_dir", "");
+	if (!record_dir.empty()) {
+		recorder = RecordStreams::instance().acquire(record_dir, getRank().rank, getRank().thread);
+		if (!recorder) {
+			output.fatal(CALL_INFO, -1, "Failed to create the record in %s\n", record_dir.c_str());
+		}
+	}
+}
+
+// Deconstructor definition
+segment::~segment() {
+
+}
+
+// SST Setup Phase, every node sends its initial credits.
+void segment::setup() {
+	output.verbose(CALL_INFO, 1, 0, "%s->Nodes %d to %d initialized in %zu clock groups\n", getName().c_str(), first_node, first_node + num_nodes - 1, groups.size());
+	for (int i = 0; i < num_nodes; ++i) {
+		sendCredits(i, cores[i].freeCredits(), FORWARD);
+		if (cores[i].bidirectional()) {
+			sendCredits(i, cores[i].freeReverseCredits(), REVERSE);
+		}
+	}
+}
+
+// SST Finish Phase, the same lines every node component prints.
+void segment::finish() {
+	for (int i = 0; i < num_nodes; ++i) {
+		const Core &core = cores[i];
+		int id = first_node + i;
+		output.verbose(CALL_INFO, 1, 0, "Node %d->Final queue size is %ld | Max queue size is %d | Final credit size is %d\n", id, core.msgqueue.size(), core.queueMaxSize, core.queueCredits);
+		if (!core.msgqueue.empty()) {
+			output.verbose(CALL_INFO, 1, 0, "Node %d->Top of queue: Dest_ID-%d\n", id, core.msgqueue.front().dest_id);
+		}
+		output.verbose(CALL_INFO, 1, 0, "Node %d->Messages generated %" PRIu64 " | forwarded %" PRIu64 " | consumed %" PRIu64 " | dropped %" PRIu64 "\n", id, core.injected, core.forwarded, core.consumed, core.dropped);
+		if (core.bidirectional()) {
+			output.verbose(CALL_INFO, 1, 0, "Node %d->Final reverse queue size is %ld | Final reverse credit size is %d | Generated in reverse %" PRIu64 "\n", id, core.reverseQueue.size(), core.reverseCredits, core.injectedReverse);
+		}
+		if (core.timedConsumed > 0) {
+			output.verbose(CALL_INFO, 1, 0, "Node %d->Mean hops %.2f | mean latency %.3f ms\n", id, (double)core.hopsConsumed / core.consumed, core.latencyConsumed / 1e9 / core.timedConsumed);
+		} else if (core.consumed > 0) {
+			output.verbose(CALL_INFO, 1, 0, "Node %d->Mean hops %.2f\n", id, (double)core.hopsConsumed / core.consumed);
+		}
+		if (core.recoveryDropped + core.recoveryRerouted + core.recoveryDrained > 0) {
+			output.verbose(CALL_INFO, 1, 0, "Node %d->Recovery dropped %" PRIu64 " | rerouted %" PRIu64 " | drained %" PRIu64 " | still in the recovery buffer %ld\n", id, core.recoveryDropped, core.recoveryRerouted, core.recoveryDrained, core.recoveryBuffer.size());
+		}
+	}
+	if (recorder && !RecordStreams::instance().release(recorder, getCurrentSimCycle())) {
+		output.verbose(CALL_INFO, 1, 0, "%s->Failed to write the record\n", getName().c_str());
+	}
+}
+
+// Runs every tick of a clock group
+bool segment::tick( SST::Cycle_t currentCycle, int group ) {
+	LogBatchEvent *batch = new LogBatchEvent();
+	batch->logs.reserve(groups[group].size());
+	SST::SimTime_t now = getCurrentSimCycle();
+	for (int i : groups[group]) {
+		Core &core = cores[i];
+		core.tick();
+
+		statIdleDuration->addData(core.idleFor(now));
+		statBlockRequests->addData(std::max<int64_t>(core.blockedFor(now), 0));
+		statNodeState->addData(core.node_state);
+		statQueueOccupancy->addData(core.queued());
+
+		batch->logs.push_back({ core.idle_since, core.node_state, core.blocked_since, first_node + i, core.stuck(), (int)core.consumed, core.queued(), now });
+	}
+	logPort->send(batch);
+	return(false);
+}
+
+void segment::prevHandler(SST::Event *ev) {
+	deliver(0, ev);
+}
+
+void segment::nextHandler(SST::Event *ev) {
+	deliver(num_nodes - 1, ev);
+}
+
+void segment::deliver(int index, SST::Event *ev) {
+	// In a bidirectional ring both ports receive messages and credits.
+	if (static_cast<RingEvent*>(ev)->kind == RingEvent::MESSAGE_EVENT) {
+		MessageEvent *me = static_cast<MessageEvent*>(ev);
+		if (recorder) {
+			recorder->write(messageRecord(getCurrentSimCycle(), first_node + index, me->msg));
+		}
+		cores[index].receiveMessage(me->msg);
+	} else {
+		CreditEvent *ce = static_cast<CreditEvent*>(ev);
+		if (recorder) {
+			recorder->write(creditRecord(getCurrentSimCycle(), first_node + index, ce->probe.credits, ce->probe.direction));
+		}
+		if (ce->probe.direction == REVERSE) {
+			cores[index].receiveReverseCredits(ce->probe.credits);
+		} else {
+			cores[index].receiveCredits(ce->probe.credits);
+		}
+	}
+	delete ev; // Clean up event to prevent memory leaks.
+}
+
+void segment::innerHandler(SST::Event *ev) {
+	SegmentEvent *se = static_cast<SegmentEvent*>(ev);
+	Core &core = cores[se->target];
+	switch (se->kind) {
+		case SegmentEvent::MESSAGE:
+			if (recorder) {
+				recorder->write(messageRecord(getCurrentSimCycle(), first_node + se->target, se->msg));
+			}
+			core.receiveMessage(se->msg);
+			break;
+		case SegmentEvent::CREDIT:
+			if (recorder) {
+				recorder->write(creditRecord(getCurrentSimCycle(), first_node + se->target, se->credits, FORWARD));
+			}
+			core.receiveCredits(se->credits);
+			break;
+		case SegmentEvent::REVERSE_CREDIT:
+			if (recorder) {
+				recorder->write(creditRecord(getCurrentSimCycle(), first_node + se->target, se->credits, REVERSE));
+			}
+			core.receiveReverseCredits(se->credits);
+			break;
+	}
+	delete ev;
+}
+
+void segment::logHandler(SST::Event *ev) {
+	RecoveryEvent *re = dynamic_cast<RecoveryEvent*>(ev);
+	if (re == NULL || re->recovery.node_id < first_node || re->recovery.node_id >= first_node + num_nodes) {
+		output.fatal(CALL_INFO, -1, "%s->Unexpected event from the logger\n", getName().c_str());
+	}
+	if (recorder) {
+		recorder->write(recoveryRecord(getCurrentSimCycle(), re->recovery.node_id, re->recovery));
+	}
+	int taken = cores[re->recovery.node_id - first_node].recover(re->recovery);
+	output.verbose(CALL_INFO, 1, 0, "Node %d->Deadlock recovery took %d messages out of the queue\n", re->recovery.node_id, taken);
+	delete ev;
+}
+
+// Messages go to the next node, REVERSE ones to the previous node, over a link once they leave the segment.
+void segment::sendMessage(int index, const Message &msg) {
+	int target = msg.direction == REVERSE ? index - 1 : index + 1;
+	if (target < 0) {
+		prevPort->send(new MessageEvent(msg));
+	} else if (target >= num_nodes) {
+		nextPort->send(new MessageEvent(msg));
+	} else {
+		innerLink->send(new SegmentEvent(SegmentEvent::MESSAGE, target, msg, 0));
+	}
+}
+
+// Credits go to the previous node, REVERSE ones to the next node.
+void segment::sendCredits(int index, int credits, Directions direction) {
+	int target = direction == REVERSE ? index + 1 : index - 1;
+	if (target < 0) {
+		prevPort->send(new CreditEvent({ credits, direction }));
+	} else if (target >= num_nodes) {
+		nextPort->send(new CreditEvent({ credits, direction }));
+	} else {
+		innerLink->send(new SegmentEvent(direction == REVERSE ? SegmentEvent::REVERSE_CREDIT : SegmentEvent::CREDIT, target, Message(), credits));
+	}
+}
@@ -0,0 +1,267 @@
+/// \file
+#ifndef _segment_H
+#define _segment_H
+
+#include <sst/core/component.h>
+#include <sst/core/link.h>
+#include <sst/core/rng/marsaglia.h>
+#include <vector>
+#include "CommunicationEvents.h"
+#include "RingNode.h"
+#include "Record.h"
+
+/**
+ * @brief Event between two nodes of the same segment, sent over the segment's self link.
+ *
+ */
+class SegmentEvent : public SST::Event {
+
+public:
+	/**
+	 * @brief What the event delivers.
+	 */
+	enum Kinds { MESSAGE, CREDIT, REVERSE_CREDIT };
+
+	/**
+	 * @brief Serialize the members. Self link events stay on their rank, this only
+	 * satisfies SST.
+	 *
+	 * @param ser Wrapper class for objects to declare the order in which their members are serialized/deserialized.
+	 */
+	void serialize_order(SST::Core::Serialization::serializer &ser) override {
+		Event::serialize_order(ser);
+		uint64_t word = 0;
+		if (ser.mode() != SST::Core::Serialization::serializer::UNPACK) {
+			word = packHeader(msg);
+		}
+		ser & kind;
+		ser & target;
+		ser & word;
+		ser & msg.born;
+		ser & credits;
+		if (ser.mode() == SST::Core::Serialization::serializer::UNPACK) {
+			uint64_t born = msg.born;
+			msg = unpackHeader(word);
+			msg.born = born;
+		}
+	}
+
+	SegmentEvent(int kind, int target, const Message &msg, int credits) :
+		Event(),
+		kind(kind),
+		target(target),
+		msg(msg),
+		credits(credits)
+	{}
+
+	SegmentEvent() {} // For serialization
+
+	int kind; //!< Kinds value.
+	int target; //!< Index of the receiving node within the segment.
+	Message msg; //!< Delivered message.
+	int credits; //!< Delivered credits.
+
+	ImplementSerializable(SegmentEvent); // For serialization.
+};
+
+/**
+ * @brief Segment Component Class. Runs a contiguous stretch of ring nodes in one
+ * component, so large rings are built without one component and three links per node.
+ *
+ * Every node is the same RingNode core the node component uses. Messages and credits
+ * between nodes of the segment travel over a self link with the ring link latency, and
+ * only the two ends of the segment use SST links. Nodes with the same tick period share
+ * one clock and tick in ID order. Log records of the nodes that ticked together are sent
+ * to the logger as one LogBatchEvent.
+ */
+class segment : public SST::Component {
+
+public:
+	/**
+	 * @brief Construct a new segment component for the simulation composition.
+	 * Occurs before the simulation starts.
+	 *
+	 * @param id Component ID tracked by the simulator.
+	 * @param params Parameters passed in via the Python driver file.
+	 */
+	segment( SST::ComponentId_t id, SST::Params& params );
+
+	/**
+	 * @brief Deconstruct the segment component. Occurs after the simulation is finished.
+	 *
+	 */
+	~segment();
+
+	/**
+	 * @brief Setup Phase. Every node announces its free queue space.
+	 *
+	 */
+	void setup();
+
+	/**
+	 * @brief Finish Phase. Prints the final state of every node, as the node component does.
+	 *
+	 */
+	void finish();
+
+	/**
+	 * @brief Ticks every node of one clock group and sends their records to the logger.
+	 *
+	 * @param currentCycle Current cycle of the group's clock.
+	 * @param group Index of the clock group.
+	 * @return false Component is not finished running.
+	 */
+	bool tick( SST::Cycle_t currentCycle, int group );
+
+	/**
+	 * @brief Handles events from the previous segment: messages for the first node, and
+	 * reverse credits in a bidirectional ring.
+	 *
+	 * @param ev MessageEvent or CreditEvent that the component received.
+	 */
+	void prevHandler(SST::Event *ev);
+
+	/**
+	 * @brief Handles events from the next segment: credits for the last node, and
+	 * reverse messages in a bidirectional ring.
+	 *
+	 * @param ev CreditEvent or MessageEvent that the component received.
+	 */
+	void nextHandler(SST::Event *ev);
+
+	/**
+	 * @brief Handles messages and credits between nodes of the segment.
+	 *
+	 * @param ev SegmentEvent sent over the inner self link.
+	 */
+	void innerHandler(SST::Event *ev);
+
+	/**
+	 * @brief Handles recovery requests from the logger for one of the segment's nodes.
+	 *
+	 * @param ev RecoveryEvent that the component received.
+	 */
+	void logHandler(SST::Event *ev);
+
+	/**
+	 * Currently ignoring SST_ELI Macros as they break doxygen.
+	 * \cond
+	 */
+	/**
+	 * @brief Macro for registering a component into SST and generate info for SST-Info
+	 *
+	 */
+	SST_ELI_REGISTER_COMPONENT(
+		segment, // class
+		"deadlocklog", // element library
+		"segment", // component
+		SST_ELI_ELEMENT_VERSION( 1, 0, 0 ), // current element version
+		"contiguous stretch of ring nodes in one component, for building large rings quickly.", // description of component.
+		COMPONENT_CATEGORY_UNCATEGORIZED // * Not grouped in a category. (No category to filter with via sst-info).
+	)
+
+	/**
+	 * @brief Macro for documenting a component's parameters for SST-Info. Layout is: parameter name, description, default value.
+	 *
+	 */
+	SST_ELI_DOCUMENT_PARAMS(
+		{"first_node", "ID of the first node of the segment.", "0"},
+		{"num_nodes", "Number of nodes in the segment.", "1"},
+		{"total_nodes", "Number of nodes in the ring.", "first_node + num_nodes"},
+		{"queueMaxSize", "The size of every node's queue.", "50"},
+		{"tickFreq", "The frequency every node ticks at.", "10s"},
+		{"message_gen", "Probability that a node generates a message on a tick.", "0.5"},
+		{"randseed", "Seed of every node's message generator.", "121212"},
+		{"queue_sizes", "Per node queueMaxSize, a list of num_nodes values. Overrides queueMaxSize.", ""},
+		{"tick_freqs", "Per node tickFreq, a list of num_nodes values. Overrides tickFreq.", ""},
+		{"message_gens", "Per node message_gen, a list of num_nodes values. Overrides message_gen.", ""},
+		{"randseeds", "Per node randseed, a list of num_nodes values. Overrides randseed.", ""},
+		{"link_latency", "Latency of the ring links between the segment's nodes. Must match the links to the neighboring segments.", "1ms"},
+		{"routing", "How messages travel, as for the node component.", "forward"},
+		{"latency", "Time the messages, as for the node component.", "false"},
+		{"record_dir", "Directory to record every event delivered to the segment's nodes in, as for the node component.", ""},
+	)
+
+	/**
+	 * @brief Macro for documenting a component's ports for SST-Info. Layout is: port name, description, event.
+	 *
+	 */
+	SST_ELI_DOCUMENT_PORTS(
+		{"prevPort", "Connects the first node to the last node of the previous segment.", {"MessageEvent", "CreditEvent"}},
+		{"nextPort", "Connects the last node to the first node of the next segment.", {"CreditEvent", "MessageEvent"}},
+		{"logPort", "Sends the records of every node to a logger with log_mode 'batch' and receives its recovery requests.", {"LogBatchEvent", "RecoveryEvent"}},
+	)
+
+	/**
+	 * @brief Macro for documenting a component's statistics for SST-Info. Layout is: name, description, units, enable level.
+	 *
+	 */
+	SST_ELI_DOCUMENT_STATISTICS(
+		{"idle_duration", "Time a node has been idle for, one sample per node every tick.", "ps", 1},
+		{"block_requests", "Time since a node's first tick without credits since it last sent, one sample per node every tick.", "ps", 1},
+		{"node_state", "State of a node (0 idle, 1 executing), one sample per node every tick.", "state", 1},
+		{"queue_occupancy", "Number of messages in a node's queue, one sample per node every tick.", "messages", 1},
+	)
+	/**
+	 * \endcond
+	 */
+
+private:
+	/**
+	 * @brief Port policy of one node of the segment. Sends to the neighboring node over
+	 * the inner self link, or over prevPort and nextPort at the ends of the segment.
+	 */
+	class Port {
+
+	public:
+		void injectMessage(const Message &msg) { seg->sendMessage(index, msg); } //!< Called by core.
+		void forwardMessage(const Message &msg) { seg->sendMessage(index, msg); } //!< Called by core.
+		void sendCredits(int credits) { seg->sendCredits(index, credits, FORWARD); } //!< Called by core.
+		void sendReverseCredits(int credits) { seg->sendCredits(index, credits, REVERSE); } //!< Called by core.
+		uint64_t now() const { return seg->getCurrentSimCycle(); } //!< Called by core.
+
+		segment *seg; //!< Segment the node belongs to.
+		int index; //!< Index of the node within the segment.
+	};
+
+	typedef RingNode<Port, SST::RNG::MarsagliaRNG> Core; //!< Queue and credit logic shared with the node component.
+
+	/**
+	 * @brief Send a message from node index to the next node, or the previous one if it is REVERSE.
+	 */
+	void sendMessage(int index, const Message &msg);
+
+	/**
+	 * @brief Send credits from node index to the previous node, or REVERSE credits to the next one.
+	 */
+	void sendCredits(int index, int credits, Directions direction);
+
+	/**
+	 * @brief Hand a message or credit event from a neighboring segment to node index.
+	 */
+	void deliver(int index, SST::Event *ev);
+
+	SST::Output output; //!< SST Output object for printing to the console.
+
+	int first_node; //!< ID of the first node of the segment.
+	int num_nodes; //!< Number of nodes in the segment.
+	int total_nodes; //!< Total number of nodes in simulation.
+
+	std::vector<Port> ports; //!< Port of every node.
+	std::vector<SST::RNG::MarsagliaRNG> rngs; //!< Message generator of every node.
+	std::vector<Core> cores; //!< Every node. Sized once, the cores point into ports and rngs.
+	std::vector<std::vector<int>> groups; //!< Indices of the nodes of every clock group, in ID order.
+
+	SST::Link *prevPort; //!< Link to the previous segment.
+	SST::Link *nextPort; //!< Link to the next segment.
+	SST::Link *logPort; //!< Link to the logger.
+	SST::Link *innerLink; //!< Self link with the ring link latency, between nodes of the segment.
+	RecordWriter *recorder; //!< Delivery record of the segment's partition. NULL unless record_dir is set.
+
+	SST::Statistics::Statistic<uint64_t> *statIdleDuration; //!< Statistic for idle_duration.
+	SST::Statistics::Statistic<uint64_t> *statBlockRequests; //!< Statistic for block_requests.
+	SST::Statistics::Statistic<uint64_t> *statNodeState; //!< Statistic for node_state.
+	SST::Statistics::Statistic<uint64_t> *statQueueOccupancy; //!< Statistic for the size of the queues.
+};
+
+#endif
@@ -0,0 +1,549 @@
+/// \file
+#ifndef ensemble_H
+#define ensemble_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#include "Ring.h"
+
+/**
+ * @brief Lane backends of the ensemble kernels. Each runs W ring instances per operation.
+ *
+ * V holds one int32 per instance and M one flag per instance. Arithmetic wraps like
+ * uint32, as the Marsaglia generator needs. The AVX2 and AVX-512 backends are compiled
+ * in when the build targets them (make ensemble uses -march=native); Scalar always is.
+ */
+namespace lanes {
+
+struct Scalar {
+	static constexpr int W = 1;
+	typedef int32_t V;
+	typedef bool M;
+	static const char *name() { return "scalar"; }
+
+	static V load(const int32_t *p) { return *p; }
+	static void store(int32_t *p, V v) { *p = v; }
+	static V set1(int32_t x) { return x; }
+	static V iota() { return 0; }
+	static V add(V a, V b) { return (int32_t)((uint32_t)a + (uint32_t)b); }
+	static V sub(V a, V b) { return (int32_t)((uint32_t)a - (uint32_t)b); }
+	static V mul(V a, V b) { return (int32_t)((uint32_t)a * (uint32_t)b); }
+	static V andv(V a, V b) { return a & b; }
+	template <int N> static V srl(V a) { return (int32_t)((uint32_t)a >> N); }
+	template <int N> static V sll(V a) { return (int32_t)((uint32_t)a << N); }
+
+	static M eq(V a, V b) { return a == b; }
+	static M gt(V a, V b) { return a > b; }
+	static M ule(V a, uint32_t b) { return (uint32_t)a <= b; }
+	static M mfalse() { return false; }
+	static M mtrue() { return true; }
+	static M mand(M a, M b) { return a && b; }
+	static M mor(M a, M b) { return a || b; }
+	static M mandnot(M a, M b) { return !a && b; }
+	static V select(M m, V a, V b) { return m ? a : b; }
+	static uint32_t bits(M m) { return m; }
+
+	static V gather(const int32_t *base, V idx, M m) { return m ? base[idx] : 0; }
+	static void scatter(int32_t *base, V idx, V v, M m) {
+		if (m) {
+			base[idx] = v;
+		}
+	}
+
+	/**
+	 * @brief abs(x % n), the destination the node draws from a random int32.
+	 */
+	static V absmod(V x, int n) {
+		uint32_t a = x < 0 ? 0u - (uint32_t)x : (uint32_t)x;
+		return a % (uint32_t)n;
+	}
+};
+
+#ifdef __AVX2__
+struct Avx2 {
+	static constexpr int W = 8;
+	typedef __m256i V;
+	typedef __m256i M;
+	static const char *name() { return "avx2"; }
+
+	static V load(const int32_t *p) { return _mm256_loadu_si256((const __m256i *)p); }
+	static void store(int32_t *p, V v) { _mm256_storeu_si256((__m256i *)p, v); }
+	static V set1(int32_t x) { return _mm256_set1_epi32(x); }
+	static V iota() { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+	static V add(V a, V b) { return _mm256_add_epi32(a, b); }
+	static V sub(V a, V b) { return _mm256_sub_epi32(a, b); }
+	static V mul(V a, V b) { return _mm256_mullo_epi32(a, b); }
+	static V andv(V a, V b) { return _mm256_and_si256(a, b); }
+	template <int N> static V srl(V a) { return _mm256_srli_epi32(a, N); }
+	template <int N> static V sll(V a) { return _mm256_slli_epi32(a, N); }
+
+	static M eq(V a, V b) { return _mm256_cmpeq_epi32(a, b); }
+	static M gt(V a, V b) { return _mm256_cmpgt_epi32(a, b); }
+	static M ule(V a, uint32_t b) {
+		// No unsigned compare in AVX2, flip the sign bits and compare signed.
+		V sign = _mm256_set1_epi32(INT32_MIN);
+		return mandnot(gt(_mm256_xor_si256(a, sign), _mm256_xor_si256(set1(b), sign)), mtrue());
+	}
+	static M mfalse() { return _mm256_setzero_si256(); }
+	static M mtrue() { return _mm256_set1_epi32(-1); }
+	static M mand(M a, M b) { return _mm256_and_si256(a, b); }
+	static M mor(M a, M b) { return _mm256_or_si256(a, b); }
+	static M mandnot(M a, M b) { return _mm256_andnot_si256(a, b); }
+	static V select(M m, V a, V b) { return _mm256_blendv_epi8(b, a, m); }
+	static uint32_t bits(M m) { return _mm256_movemask_ps(_mm256_castsi256_ps(m)); }
+
+	static V gather(const int32_t *base, V idx, M m) {
+		return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int *)base, idx, m, 4);
+	}
+	static void scatter(int32_t *base, V idx, V v, M m) {
+		// AVX2 has no scatter.
+		alignas(32) int32_t i[W], x[W];
+		store(i, idx);
+		store(x, v);
+		for (uint32_t b = bits(m); b; b &= b - 1) {
+			int lane = __builtin_ctz(b);
+			base[i[lane]] = x[lane];
+		}
+	}
+
+	static V absmod(V x, int n) {
+		// |x| < 2^32 and q * n are exact in double, the rounding of the quotient is fixed up below.
+		V a = _mm256_xor_si256(_mm256_abs_epi32(x), _mm256_set1_epi32(INT32_MIN));
+		__m256d bias = _mm256_set1_pd(2147483648.0);
+		__m256d nd = _mm256_set1_pd(n);
+		__m128i half[2];
+		for (int h = 0; h < 2; ++h) {
+			__m256d d = _mm256_add_pd(_mm256_cvtepi32_pd(h ? _mm256_extracti128_si256(a, 1) : _mm256_castsi256_si128(a)), bias);
+			__m256d r = _mm256_sub_pd(d, _mm256_mul_pd(_mm256_floor_pd(_mm256_div_pd(d, nd)), nd));
+			r = _mm256_add_pd(r, _mm256_and_pd(_mm256_cmp_pd(r, _mm256_setzero_pd(), _CMP_LT_OQ), nd));
+			r = _mm256_sub_pd(r, _mm256_and_pd(_mm256_cmp_pd(r, nd, _CMP_GE_OQ), nd));
+			half[h] = _mm256_cvttpd_epi32(r);
+		}
+		return _mm256_set_m128i(half[1], half[0]);
+	}
+};
+#endif
+
+#ifdef __AVX512F__
+struct Avx512 {
+	static constexpr int W = 16;
+	typedef __m512i V;
+	typedef __mmask16 M;
+	static const char *name() { return "avx512"; }
+
+	static V load(const int32_t *p) { return _mm512_loadu_si512(p); }
+	static void store(int32_t *p, V v) { _mm512_storeu_si512(p, v); }
+	static V set1(int32_t x) { return _mm512_set1_epi32(x); }
+	static V iota() { return _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15); }
+	static V add(V a, V b) { return _mm512_add_epi32(a, b); }
+	static V sub(V a, V b) { return _mm512_sub_epi32(a, b); }
+	static V mul(V a, V b) { return _mm512_mullo_epi32(a, b); }
+	static V andv(V a, V b) { return _mm512_and_si512(a, b); }
+	template <int N> static V srl(V a) { return _mm512_srli_epi32(a, N); }
+	template <int N> static V sll(V a) { return _mm512_slli_epi32(a, N); }
+
+	static M eq(V a, V b) { return _mm512_cmpeq_epi32_mask(a, b); }
+	static M gt(V a, V b) { return _mm512_cmpgt_epi32_mask(a, b); }
+	static M ule(V a, uint32_t b) { return _mm512_cmple_epu32_mask(a, set1(b)); }
+	static M mfalse() { return 0; }
+	static M mtrue() { return 0xFFFF; }
+	static M mand(M a, M b) { return a & b; }
+	static M mor(M a, M b) { return a | b; }
+	static M mandnot(M a, M b) { return ~a & b; }
+	static V select(M m, V a, V b) { return _mm512_mask_blend_epi32(m, b, a); }
+	static uint32_t bits(M m) { return m; }
+
+	static V gather(const int32_t *base, V idx, M m) {
+		return _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), m, idx, base, 4);
+	}
+	static void scatter(int32_t *base, V idx, V v, M m) { _mm512_mask_i32scatter_epi32(base, m, idx, v, 4); }
+
+	static V absmod(V x, int n) {
+		V a = _mm512_abs_epi32(x); // INT32_MIN stays 0x80000000, which is 2^31 as unsigned.
+		__m512d nd = _mm512_set1_pd(n);
+		__m256i half[2];
+		for (int h = 0; h < 2; ++h) {
+			__m512d d = _mm512_cvtepu32_pd(h ? _mm512_extracti64x4_epi64(a, 1) : _mm512_castsi512_si256(a));
+			__m512d q = _mm512_roundscale_pd(_mm512_div_pd(d, nd), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+			__m512d r = _mm512_sub_pd(d, _mm512_mul_pd(q, nd));
+			r = _mm512_mask_add_pd(r, _mm512_cmp_pd_mask(r, _mm512_setzero_pd(), _CMP_LT_OQ), r, nd);
+			r = _mm512_mask_sub_pd(r, _mm512_cmp_pd_mask(r, nd, _CMP_GE_OQ), r, nd);
+			half[h] = _mm512_cvttpd_epi32(r);
+		}
+		return _mm512_inserti64x4(_mm512_castsi256_si512(half[0]), half[1], 1);
+	}
+};
+#endif
+
+} // namespace lanes
+
+/**
+ * @brief Many independent instances of one ring, advanced in lockstep.
+ *
+ * Every instance has the same node parameters and its own seed, so clock ticks and link
+ * deliveries happen at the same times in all of them and only the state differs. State
+ * is stored as struct-of-arrays, one contiguous array per node and field with one entry
+ * per instance, and the kernels update W instances at a time.
+ *
+ * Time advances on the grid of the gcd of the tick periods and the link latency. A step
+ * runs the ticks of the nodes due at that time, then delivers what was sent one link
+ * latency earlier: the message from the previous node, then the credits from the next
+ * node in the order they were sent (tick first, then the reply to a received message).
+ * This is the order SST and the scalar Ring run them in, and no two of these touch the
+ * same state within a step, so every instance follows its scalar run seed for seed.
+ */
+class Ensemble {
+
+public:
+	/**
+	 * @param params Parameters of every node.
+	 * @param linkLatency Latency of the ring links in ps.
+	 * @param seed randseed of every node of instance 0. Instance i uses seed + i.
+	 * @param instances Number of ring instances.
+	 * @param idleThreshold Time in ps every node must have been idle for longer than for deadlock.
+	 * @param requestThreshold Time in ps every node must have been blocked for longer than for deadlock.
+	 */
+	Ensemble(const std::vector<NodeParams> &params, uint64_t linkLatency, int64_t seed, int instances, int64_t idleThreshold, int64_t requestThreshold) :
+		nodes(params.size()), instances(instances), idleThreshold(idleThreshold), requestThreshold(requestThreshold), linkLatency(linkLatency)
+	{
+		// Padded so every backend runs whole vectors.
+		lanesTotal = (instances + MAX_W - 1) / MAX_W * MAX_W;
+
+		grid = linkLatency;
+		size_t queueTotal = 0;
+		for (const NodeParams &p : params) {
+			grid = gcd(grid, p.tickPeriod);
+			period.push_back(p.tickPeriod);
+			queueMax.push_back(p.queueMaxSize);
+			queueOffset.push_back(queueTotal);
+			queueTotal += (size_t)p.queueMaxSize * lanesTotal;
+			genLimit.push_back(threshold(p.message_gen));
+		}
+		slots = linkLatency / grid + 1;
+
+		size_t n = (size_t)nodes * lanesTotal;
+		state.assign(n, IDLE);
+		idle.assign(n, 0);
+		block.assign(n, 0);
+		credits.assign(n, 0);
+		head.assign(n, 0);
+		size.assign(n, 0);
+		rngZ.assign(n, 10);
+		rngW.assign(n, 0);
+		queue.assign(queueTotal, 0);
+		msgOut.assign(slots * n, -1);
+		tickCreditOut.assign(slots * n, -1);
+		recvCreditOut.assign(slots * n, -1);
+		decided.assign(lanesTotal, 0);
+		deadlockTime.assign(lanesTotal, 0);
+		deadlockSizes.assign(n, 0);
+
+		for (int node = 0; node < nodes; ++node) {
+			for (int i = 0; i < lanesTotal; ++i) {
+				rngW[node * lanesTotal + i] = (int32_t)(uint32_t)(seed + i);
+				// setup(): initial credits, sent at time 0 like a tick's credits.
+				tickCreditOut[node * lanesTotal + i] = queueMax[node];
+			}
+		}
+		for (int i = instances; i < lanesTotal; ++i) {
+			decided[i] = 1;
+		}
+	}
+
+	/**
+	 * @brief Largest ring size the kernels support. Queue indices must fit int32.
+	 */
+	static constexpr int MAX_NODES = 1 << 20;
+
+	/**
+	 * @brief Whether every queue index fits the int32 lanes.
+	 */
+	bool fits() const {
+		for (int q : queueMax) {
+			if ((int64_t)q * lanesTotal > INT32_MAX) {
+				return false;
+			}
+		}
+		return nodes > 0 && nodes <= MAX_NODES && linkLatency > 0;
+	}
+
+	/**
+	 * @brief Run every instance until it deadlocks or the time passes stop (ps).
+	 *
+	 * @tparam L Lane backend from namespace lanes.
+	 */
+	template <class L>
+	void run(uint64_t stop) {
+		int remaining = instances;
+		for (uint64_t t = grid; t <= stop && remaining > 0; t += grid) {
+			int to = (t / grid) % slots;
+			int from = (to + 1) % slots; // Slot of t - linkLatency.
+			size_t slotBase = (size_t)to * nodes * lanesTotal;
+			std::fill(msgOut.begin() + slotBase, msgOut.begin() + slotBase + nodes * lanesTotal, -1);
+			std::fill(tickCreditOut.begin() + slotBase, tickCreditOut.begin() + slotBase + nodes * lanesTotal, -1);
+			std::fill(recvCreditOut.begin() + slotBase, recvCreditOut.begin() + slotBase + nodes * lanesTotal, -1);
+
+			bool ticked = false;
+			for (int n = 0; n < nodes; ++n) {
+				if (t % period[n] == 0) {
+					ticked = true;
+					for (int i = 0; i < lanesTotal; i += L::W) {
+						if (active<L>(i)) {
+							tick<L>(n, i, to);
+							laneTicks += L::W;
+						}
+					}
+				}
+			}
+			if (t >= linkLatency) {
+				for (int n = 0; n < nodes; ++n) {
+					for (int i = 0; i < lanesTotal; i += L::W) {
+						if (active<L>(i)) {
+							deliver<L>(n, i, from, to);
+						}
+					}
+				}
+			}
+			// The deadlock condition only changes when nodes tick.
+			if (ticked) {
+				for (int i = 0; i < lanesTotal; i += L::W) {
+					remaining -= detect<L>(i, t);
+				}
+			}
+		}
+	}
+
+	int getInstances() const { return instances; }
+	int getNodes() const { return nodes; }
+
+	/**
+	 * @brief Time instance i deadlocked at in ps, 0 if it did not.
+	 */
+	uint64_t getDeadlockTime(int i) const { return deadlockTime[i]; }
+
+	/**
+	 * @brief Queue size of a node of instance i when it deadlocked.
+	 */
+	int getDeadlockQueueSize(int i, int node) const { return deadlockSizes[(size_t)node * lanesTotal + i]; }
+
+	/**
+	 * @brief Node ticks run, summed over the lanes that were still running.
+	 */
+	uint64_t getLaneTicks() const { return laneTicks; }
+
+private:
+	static constexpr int MAX_W = 16; //!< Widest backend.
+
+	static uint64_t gcd(uint64_t a, uint64_t b) { return b ? gcd(b, a % b) : a; }
+
+	/**
+	 * @brief Whole periods in time, rounded down, for times down to -period. Capped so
+	 * that one more still fits an int32.
+	 */
+	static int32_t ticksOver(int64_t time, uint64_t period) {
+		if (time < 0) {
+			return -1;
+		}
+		return (int32_t)std::min<uint64_t>(time / period, INT32_MAX - 1);
+	}
+
+	/**
+	 * @brief Largest random uint32 whose nextUniform() is <= gen, -1 if there is none.
+	 * Turns the node's floating point test into an integer compare.
+	 */
+	static int64_t threshold(float gen) {
+		auto generates = [gen](int64_t u) { return (u + 1.0) * 2.328306435454494e-10 <= gen; };
+		if (!generates(0)) {
+			return -1;
+		}
+		int64_t lo = 0, hi = UINT32_MAX;
+		while (lo < hi) {
+			int64_t mid = lo + (hi - lo + 1) / 2;
+			if (generates(mid)) {
+				lo = mid;
+			} else {
+				hi = mid - 1;
+			}
+		}
+		return lo;
+	}
+
+	/**
+	 * @brief Whether any instance in lanes i..i+W-1 is still running.
+	 */
+	template <class L>
+	bool active(int i) const {
+		return L::bits(L::eq(L::load(&decided[i]), L::set1(0))) != 0;
+	}
+
+	/**
+	 * @brief One tick of node n in lanes i..i+W-1. Same steps as RingNode::tick.
+	 */
+	template <class L>
+	void tick(int n, int i, int to) {
+		typedef typename L::V V;
+		typedef typename L::M M;
+		size_t at = (size_t)n * lanesTotal + i;
+		V zero = L::set1(0), one = L::set1(1), none = L::set1(-1), qmax = L::set1(queueMax[n]);
+		V st = L::load(&state[at]), id = L::load(&idle[at]), bl = L::load(&block[at]);
+		V cr = L::load(&credits[at]), hd = L::load(&head[at]), sz = L::load(&size[at]);
+		V z = L::load(&rngZ[at]), w = L::load(&rngW[at]);
+
+		M wasIdle = L::eq(st, zero);
+		id = L::select(wasIdle, L::add(id, one), zero);
+		bl = L::select(wasIdle, bl, zero);
+		M hasCredits = L::gt(cr, zero);
+		bl = L::add(bl, L::select(hasCredits, zero, one));
+
+		// addMessage(): one draw with credits, a second one for the destination.
+		V z1, w1;
+		V u = draw<L>(z, w, z1, w1);
+		z = L::select(hasCredits, z1, z);
+		w = L::select(hasCredits, w1, w);
+		M gen = genLimit[n] < 0 ? L::mfalse() : L::mand(hasCredits, L::ule(u, (uint32_t)genLimit[n]));
+		V u2 = draw<L>(z, w, z1, w1);
+		z = L::select(gen, z1, z);
+		w = L::select(gen, w1, w);
+		V dest = L::absmod(u2, nodes);
+
+		// sendMessage(): with credits, or without when the top message is for the next node.
+		M nonEmpty = L::gt(sz, zero);
+		V lane = L::add(L::iota(), L::set1(i));
+		int32_t *q = &queue[queueOffset[n]];
+		V front = L::gather(q, L::add(L::mul(hd, L::set1(lanesTotal)), lane), nonEmpty);
+		M forward = L::mandnot(gen, L::mand(nonEmpty, L::mor(hasCredits, L::eq(front, L::set1((n + 1) % nodes)))));
+		V next = L::add(hd, one);
+		hd = L::select(forward, L::select(L::eq(next, qmax), zero, next), hd);
+		sz = L::sub(sz, L::select(forward, one, zero));
+		st = L::select(L::mor(hasCredits, forward), one, zero);
+
+		size_t out = (size_t)to * nodes * lanesTotal + at;
+		L::store(&msgOut[out], L::select(gen, dest, L::select(forward, front, none)));
+		L::store(&tickCreditOut[out], L::select(forward, L::sub(qmax, sz), none));
+		L::store(&state[at], st);
+		L::store(&idle[at], id);
+		L::store(&block[at], bl);
+		L::store(&head[at], hd);
+		L::store(&size[at], sz);
+		L::store(&rngZ[at], z);
+		L::store(&rngW[at], w);
+	}
+
+	/**
+	 * @brief One draw of the Marsaglia generator in every lane.
+	 */
+	template <class L>
+	static typename L::V draw(typename L::V z, typename L::V w, typename L::V &z1, typename L::V &w1) {
+		typename L::V low = L::set1(65535);
+		z1 = L::add(L::mul(L::set1(36969), L::andv(z, low)), L::template srl<16>(z));
+		w1 = L::add(L::mul(L::set1(18000), L::andv(w, low)), L::template srl<16>(w));
+		return L::add(L::template sll<16>(z1), w1);
+	}
+
+	/**
+	 * @brief Deliver to node n in lanes i..i+W-1 what was sent to it one link latency ago.
+	 * Same steps as RingNode::receiveMessage and receiveCredits.
+	 */
+	template <class L>
+	void deliver(int n, int i, int from, int to) {
+		typedef typename L::V V;
+		typedef typename L::M M;
+		size_t at = (size_t)n * lanesTotal + i;
+		size_t prev = (size_t)from * nodes * lanesTotal + (size_t)((n + nodes - 1) % nodes) * lanesTotal + i;
+		size_t next = (size_t)from * nodes * lanesTotal + (size_t)((n + 1) % nodes) * lanesTotal + i;
+		V zero = L::set1(0), one = L::set1(1), none = L::set1(-1), qmax = L::set1(queueMax[n]);
+
+		V msg = L::load(&msgOut[prev]);
+		V hd = L::load(&head[at]), sz = L::load(&size[at]);
+		M push = L::mandnot(L::eq(msg, L::set1(n)), L::mand(L::gt(msg, none), L::gt(qmax, sz)));
+		V tail = L::add(hd, sz);
+		tail = L::select(L::gt(qmax, tail), tail, L::sub(tail, qmax));
+		V lane = L::add(L::iota(), L::set1(i));
+		L::scatter(&queue[queueOffset[n]], L::add(L::mul(tail, L::set1(lanesTotal)), lane), msg, push);
+		sz = L::add(sz, L::select(push, one, zero));
+		L::store(&size[at], sz);
+		L::store(&recvCreditOut[(size_t)to * nodes * lanesTotal + at], L::select(push, L::sub(qmax, sz), none));
+
+		V cr = L::load(&credits[at]);
+		V tc = L::load(&tickCreditOut[next]), rc = L::load(&recvCreditOut[next]);
+		cr = L::select(L::gt(tc, none), tc, cr);
+		cr = L::select(L::gt(rc, none), rc, cr);
+		L::store(&credits[at], cr);
+	}
+
+	/**
+	 * @brief Record the instances in lanes i..i+W-1 that deadlocked at time t.
+	 *
+	 * The counters hold ticks up to the node's last tick, and the thresholds are times.
+	 * A node idle for `idle` ticks at its last tick has been idle for idle * period + the
+	 * time since that tick, and one blocked on `block` ticks has been blocked for
+	 * (block - 1) * period + the same, so each threshold turns into a tick count per node.
+	 *
+	 * @return Number of newly deadlocked instances.
+	 */
+	template <class L>
+	int detect(int i, uint64_t t) {
+		typedef typename L::M M;
+		M all = L::eq(L::load(&decided[i]), L::set1(0));
+		for (int n = 0; n < nodes && L::bits(all); ++n) {
+			size_t at = (size_t)n * lanesTotal + i;
+			int64_t since = t % period[n];
+			int32_t idleTicks = ticksOver(idleThreshold - since, period[n]);
+			int32_t blockTicks = ticksOver(requestThreshold - since, period[n]) + 1;
+			all = L::mand(all, L::mand(L::eq(L::load(&state[at]), L::set1(IDLE)),
+				L::mand(L::gt(L::load(&idle[at]), L::set1(idleTicks)), L::gt(L::load(&block[at]), L::set1(blockTicks)))));
+		}
+		int count = 0;
+		for (uint32_t b = L::bits(all); b; b &= b - 1) {
+			int lane = i + __builtin_ctz(b);
+			decided[lane] = 1;
+			deadlockTime[lane] = t;
+			for (int n = 0; n < nodes; ++n) {
+				deadlockSizes[(size_t)n * lanesTotal + lane] = size[(size_t)n * lanesTotal + lane];
+			}
+			count++;
+		}
+		return count;
+	}
+
+	int nodes; //!< Nodes per ring.
+	int instances; //!< Ring instances.
+	int lanesTotal; //!< Instances padded to a multiple of MAX_W.
+	int64_t idleThreshold; //!< Time in ps every node must have been idle for longer than for deadlock.
+	int64_t requestThreshold; //!< Time in ps every node must have been blocked for longer than for deadlock.
+	uint64_t linkLatency; //!< Ring link latency in ps.
+	uint64_t grid; //!< Time step in ps.
+	int slots; //!< Send slots kept, one link latency of steps plus the current one.
+	uint64_t laneTicks = 0; //!< Node ticks run, summed over running lanes.
+
+	std::vector<uint64_t> period; //!< Tick period of every node in ps.
+	std::vector<int> queueMax; //!< Queue size of every node.
+	std::vector<size_t> queueOffset; //!< Start of every node's queue storage in queue.
+	std::vector<int64_t> genLimit; //!< Message generation threshold of every node, see threshold().
+
+	// Per node and instance, indexed node * lanesTotal + instance.
+	std::vector<int32_t> state; //!< node_state.
+	std::vector<int32_t> idle; //!< idle_duration.
+	std::vector<int32_t> block; //!< block_requests.
+	std::vector<int32_t> credits; //!< queueCredits.
+	std::vector<int32_t> head; //!< Index of the queue's front.
+	std::vector<int32_t> size; //!< Queue size.
+	std::vector<int32_t> rngZ; //!< Marsaglia state z.
+	std::vector<int32_t> rngW; //!< Marsaglia state w.
+	std::vector<int32_t> queue; //!< Destinations of queued messages, per node indexed slot * lanesTotal + instance.
+
+	// Per send slot, node and instance. -1 when nothing was sent.
+	std::vector<int32_t> msgOut; //!< Destination of the message sent to the next node.
+	std::vector<int32_t> tickCreditOut; //!< Credits sent to the previous node by a tick.
+	std::vector<int32_t> recvCreditOut; //!< Credits sent to the previous node after queueing a message.
+
+	std::vector<int32_t> decided; //!< 1 once an instance deadlocked, or for padding lanes.
+	std::vector<uint64_t> deadlockTime; //!< Deadlock time of every instance in ps, 0 if none yet.
+	std::vector<int32_t> deadlockSizes; //!< Queue sizes when each instance deadlocked.
+};
+
+#endif
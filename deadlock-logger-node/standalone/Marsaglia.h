@@ -0,0 +1,44 @@
+/// \file
+#ifndef marsaglia_H
+#define marsaglia_H
+
+#include <cstdint>
+
+/**
+ * @brief Marsaglia multiply-with-carry generator with the same sequence as SST::RNG::MarsagliaRNG.
+ *
+ * Lets the standalone driver draw exactly the numbers a node component draws for the same seed.
+ */
+class MarsagliaRNG {
+
+public:
+	/**
+	 * @param initial_z First seed, the SST node uses 10.
+	 * @param initial_w Second seed, the node's randseed parameter.
+	 */
+	MarsagliaRNG(unsigned int initial_z, unsigned int initial_w) : m_z(initial_z), m_w(initial_w) {}
+
+	/**
+	 * @brief Uniform number strictly between 0 and 1.
+	 */
+	double nextUniform() {
+		// The magic number is 1/(2^32 + 2).
+		return (generateNext() + 1.0) * 2.328306435454494e-10;
+	}
+
+	uint32_t generateNextUInt32() { return generateNext(); }
+
+	int32_t generateNextInt32() { return (int32_t)generateNext(); }
+
+private:
+	uint32_t generateNext() {
+		m_z = 36969 * (m_z & 65535) + (m_z >> 16);
+		m_w = 18000 * (m_w & 65535) + (m_w >> 16);
+		return (m_z << 16) + m_w;
+	}
+
+	uint32_t m_z; //!< First half of the state.
+	uint32_t m_w; //!< Second half of the state.
+};
+
+#endif
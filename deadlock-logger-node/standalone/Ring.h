@@ -0,0 +1,455 @@
+/// \file
+#ifndef ring_H
+#define ring_H
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Marsaglia.h"
+#include "../RingNode.h"
+#include "../Record.h"
+
+#define CLOCKPRIORITY 40 // SST's priority of clock ticks.
+#define EVENTPRIORITY 50 // SST's priority of event deliveries.
+
+class Ring;
+
+/**
+ * @brief Sends a node's messages and credits as events of the standalone simulation.
+ */
+struct Port {
+	Ring *ring; //!< Simulation the events are scheduled in.
+	int node; //!< Index of the sending node within the simulated nodes.
+
+	void injectMessage(const Message &msg);
+	void forwardMessage(const Message &msg);
+	void sendCredits(int credits);
+	void sendReverseCredits(int credits);
+	uint64_t now() const;
+};
+
+typedef RingNode<Port, MarsagliaRNG> Core;
+
+/**
+ * @brief Parameters of one node, as in the Python driver files.
+ */
+struct NodeParams {
+	int queueMaxSize; //!< Maximum size of the node's queue.
+	uint64_t tickPeriod; //!< Tick period in ps.
+	float message_gen; //!< Probability that a message is generated on a tick.
+};
+
+/**
+ * @brief Ring of nodes and the queue of scheduled activities.
+ *
+ * Simulates either the whole ring or a window of consecutive nodes. Events a window
+ * sends to nodes outside of it are discarded, and the events those nodes sent into the
+ * window are delivered from a recording with deliver().
+ */
+class Ring {
+
+public:
+	/**
+	 * @param params Parameters of every node of the ring.
+	 * @param seed randseed of every node.
+	 * @param linkLatency Latency of the ring links in ps.
+	 * @param routing How messages travel, see the node's routing parameter.
+	 * @param first ID of the first simulated node.
+	 * @param count Number of simulated nodes, -1 for the rest of the ring.
+	 */
+	Ring(const std::vector<NodeParams> &params, int64_t seed, uint64_t linkLatency, RoutingModes routing = ROUTE_FORWARD, int first = 0, int count = -1) :
+		linkLatency(linkLatency), total(params.size()), first(first)
+	{
+		int simulated = count < 0 ? total - first : count;
+		ports.resize(simulated);
+		cores.resize(simulated);
+		rngs.reserve(simulated);
+		for (int i = 0; i < simulated; ++i) {
+			const NodeParams &p = params[first + i];
+			ports[i] = { this, i };
+			rngs.emplace_back(10, seed);
+			cores[i].configure(&ports[i], &rngs[i], first + i, total, p.queueMaxSize, p.message_gen);
+			cores[i].setRouting(routing);
+
+			// registerClock, one clock per period.
+			size_t c = 0;
+			while (c < clocks.size() && clocks[c].period != p.tickPeriod) {
+				c++;
+			}
+			if (c == clocks.size()) {
+				clocks.push_back({ p.tickPeriod, {} });
+				schedule({ p.tickPeriod, CLOCKPRIORITY, 0, CLOCK, c });
+			}
+			clocks[c].nodes.push_back(i);
+		}
+
+		// setup(), every node announces its free queue space.
+		for (int i = 0; i < simulated; ++i) {
+			ports[i].sendCredits(cores[i].freeCredits());
+			if (cores[i].bidirectional()) {
+				ports[i].sendReverseCredits(cores[i].freeReverseCredits());
+			}
+		}
+	}
+
+	/**
+	 * @brief Run every activity scheduled at or before stop (ps), like sst --stop-at.
+	 *
+	 * With thresholds of 0 ps or more, the run also stops at the first time nodes ticked
+	 * at with every node deadlocked, see deadlocked(). It also stops when the observer
+	 * returns true.
+	 *
+	 * @return Time of the deadlock or of the observer's stop in ps, 0 if there was none.
+	 */
+	uint64_t run(uint64_t stop, int64_t idleThreshold = -1, int64_t requestThreshold = -1) {
+		bool ticked = false;
+		while (!vortex.empty() && vortex.top().time <= stop) {
+			Activity a = vortex.top();
+			vortex.pop();
+			now = a.time;
+			events++;
+			if (unblocks(a)) {
+				unblocking--;
+			}
+			switch (a.kind) {
+				case CLOCK:
+					ticked = true;
+					for (int i : clocks[a.target].nodes) {
+						cores[i].tick();
+						ticks++;
+					}
+					schedule({ now + clocks[a.target].period, CLOCKPRIORITY, 0, CLOCK, a.target });
+					break;
+				case MESSAGE:
+					if (recorder) {
+						recorder(messageRecord(now, first + a.target, a.msg));
+					}
+					cores[a.target].receiveMessage(a.msg);
+					break;
+				case CREDIT:
+					if (recorder) {
+						recorder(creditRecord(now, first + a.target, a.credits, FORWARD));
+					}
+					cores[a.target].receiveCredits(a.credits);
+					break;
+				case REVERSE_CREDIT:
+					if (recorder) {
+						recorder(creditRecord(now, first + a.target, a.credits, REVERSE));
+					}
+					cores[a.target].receiveReverseCredits(a.credits);
+					break;
+				case RECOVERY:
+					if (recorder) {
+						recorder(recoveryRecord(now, first + a.target, recoveries[a.credits]));
+					}
+					cores[a.target].recover(recoveries[a.credits]);
+					break;
+			}
+
+			// Check once every activity at this time has run.
+			bool timeDone = vortex.empty() || vortex.top().time != now;
+			if (idleThreshold >= 0 && timeDone && ticked && deadlocked(idleThreshold, requestThreshold)) {
+				return now;
+			}
+			ticked = ticked && !timeDone;
+			if (observer && timeDone && observer()) {
+				return now;
+			}
+		}
+		return 0;
+	}
+
+	/**
+	 * @brief Whether every node is idle and has been idle and blocked for longer than the
+	 * thresholds (ps) now. The condition the logger declares deadlock on.
+	 */
+	bool deadlocked(int64_t idleThreshold, int64_t requestThreshold) const {
+		for (const Core &c : cores) {
+			if (c.node_state != IDLE || c.idleFor(now) <= idleThreshold || c.blockedFor(now) <= requestThreshold) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Whether the ring is deadlocked for good, from the global state: every node is
+	 * stuck (see RingNode::stuck) and no credits or recovery requests are on their way
+	 * that could change that. A node's credits are only zero once the next node announced
+	 * a full queue, and the next node announces every change, so without positive credits
+	 * in flight every queue a stuck node waits on is full and stays full. Messages in
+	 * flight can then only be consumed or dropped. Only meaningful for the whole ring.
+	 */
+	bool trulyDeadlocked() const {
+		if (unblocking > 0) {
+			return false;
+		}
+		for (const Core &c : cores) {
+			if (!c.stuck()) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Schedule a message to the node after `from`, or before it for REVERSE messages.
+	 */
+	void sendMessage(int from, const Message &msg) {
+		int to = msg.direction == REVERSE ? neighbor(from, -1) : neighbor(from, 1);
+		if (to >= 0) {
+			schedule({ now + linkLatency, EVENTPRIORITY, 0, MESSAGE, (size_t)to, msg });
+		}
+	}
+
+	/**
+	 * @brief Schedule credits to the node before `from`.
+	 */
+	void sendCredits(int from, int credits) {
+		int to = neighbor(from, -1);
+		if (to >= 0) {
+			schedule({ now + linkLatency, EVENTPRIORITY, 0, CREDIT, (size_t)to, {}, credits });
+		}
+	}
+
+	/**
+	 * @brief Schedule reverse credits to the node after `from`.
+	 */
+	void sendReverseCredits(int from, int credits) {
+		int to = neighbor(from, 1);
+		if (to >= 0) {
+			schedule({ now + linkLatency, EVENTPRIORITY, 0, REVERSE_CREDIT, (size_t)to, {}, credits });
+		}
+	}
+
+	/**
+	 * @brief Schedule a recorded delivery to one of the simulated nodes at its recorded time.
+	 * Call before run().
+	 */
+	void deliver(const DeliveryRecord &r) {
+		size_t to = r.node - first;
+		switch (r.kind) {
+			case RECORD_MESSAGE:
+				schedule({ r.time, EVENTPRIORITY, 0, MESSAGE, to, recordedMessage(r) });
+				break;
+			case RECORD_CREDIT:
+				schedule({ r.time, EVENTPRIORITY, 0, r.payload & 1 ? REVERSE_CREDIT : CREDIT, to, {}, (int)(r.payload >> 1) });
+				break;
+			case RECORD_RECOVERY:
+				recoveries.push_back({ (RecoveryPolicies)r.payload, (int)r.extra, r.node });
+				schedule({ r.time, EVENTPRIORITY, 0, RECOVERY, to, {}, (int)recoveries.size() - 1 });
+				break;
+		}
+	}
+
+	/**
+	 * @brief Call a function with every delivery, before it is handled.
+	 */
+	void setRecorder(std::function<void(const DeliveryRecord &)> f) { recorder = f; }
+
+	/**
+	 * @brief Call a function once every activity of a time step has run. The run ends
+	 * when it returns true.
+	 */
+	void setObserver(std::function<bool()> f) { observer = f; }
+
+	/**
+	 * @brief Stamp generated messages with their generation time, as the latency parameter does.
+	 */
+	void setTiming(bool on) {
+		for (Core &core : cores) {
+			core.setTiming(on);
+		}
+	}
+
+	/**
+	 * @brief Time of the next scheduled activity in ps, UINT64_MAX if there is none.
+	 */
+	uint64_t getNextTime() const { return vortex.empty() ? UINT64_MAX : vortex.top().time; }
+
+	const std::vector<Core> &getCores() const { return cores; }
+	int getFirst() const { return first; }
+	uint64_t getTime() const { return now; }
+	uint64_t getTicks() const { return ticks; }
+	uint64_t getEvents() const { return events; }
+
+private:
+	/**
+	 * @brief Kinds of activities.
+	 */
+	enum Kinds { CLOCK, MESSAGE, CREDIT, REVERSE_CREDIT, RECOVERY };
+
+	/**
+	 * @brief A clock tick or event delivery.
+	 */
+	struct Activity {
+		uint64_t time;	/**< Delivery time in ps. */
+		int priority;	/**< CLOCKPRIORITY or EVENTPRIORITY. */
+		uint64_t seq;	/**< Order the activity was scheduled in. */
+		int kind;		/**< Kinds value. */
+		size_t target;	/**< Clock index or receiving node. */
+		Message msg;	/**< Delivered message. */
+		int credits;	/**< Delivered credits, or the index into recoveries of a RECOVERY. */
+	};
+
+	/**
+	 * @brief Orders the activity queue, earliest first.
+	 */
+	struct Later {
+		bool operator()(const Activity &a, const Activity &b) const {
+			if (a.time != b.time) {
+				return a.time > b.time;
+			}
+			if (a.priority != b.priority) {
+				return a.priority > b.priority;
+			}
+			return a.seq > b.seq;
+		}
+	};
+
+	/**
+	 * @brief A group of nodes ticking at the same period.
+	 */
+	struct Clock {
+		uint64_t period;	/**< Tick period in ps. */
+		std::vector<int> nodes;	/**< Nodes in construction order. */
+	};
+
+	/**
+	 * @brief Add an activity to the queue, after everything scheduled before it.
+	 */
+	void schedule(Activity a) {
+		a.seq = seq++;
+		if (unblocks(a)) {
+			unblocking++;
+		}
+		vortex.push(a);
+	}
+
+	/**
+	 * @brief Whether an activity can let a stuck node send: positive credits or a recovery.
+	 */
+	static bool unblocks(const Activity &a) {
+		return a.kind == RECOVERY || ((a.kind == CREDIT || a.kind == REVERSE_CREDIT) && a.credits > 0);
+	}
+
+	/**
+	 * @brief Index of the node `step` places after node index `from`, -1 if it is not simulated.
+	 */
+	int neighbor(int from, int step) const {
+		int index = (first + from + step + total) % total - first;
+		return index >= 0 && index < (int)cores.size() ? index : -1;
+	}
+
+	uint64_t linkLatency; //!< Latency of the ring links in ps.
+	int total; //!< Number of nodes in the ring.
+	int first; //!< ID of the first simulated node.
+	std::vector<Port> ports; //!< Port of every simulated node.
+	std::vector<MarsagliaRNG> rngs; //!< RNG of every simulated node.
+	std::vector<Core> cores; //!< Every simulated node, cores[i] is node first + i.
+	std::vector<Recovery> recoveries; //!< Recovery requests of the RECOVERY activities.
+	std::function<void(const DeliveryRecord &)> recorder; //!< Called with every delivery, if set.
+	std::function<bool()> observer; //!< Called after every time step, if set.
+	std::vector<Clock> clocks; //!< Clocks in the order they were registered.
+	std::priority_queue<Activity, std::vector<Activity>, Later> vortex; //!< Scheduled activities.
+	uint64_t now = 0; //!< Current time in ps.
+	uint64_t seq = 0; //!< Activities scheduled so far.
+	int64_t unblocking = 0; //!< Scheduled activities for which unblocks() holds.
+	uint64_t ticks = 0; //!< Node ticks run.
+	uint64_t events = 0; //!< Activities run.
+};
+
+inline void Port::injectMessage(const Message &msg) {
+	ring->sendMessage(node, msg);
+}
+
+inline void Port::forwardMessage(const Message &msg) {
+	ring->sendMessage(node, msg);
+}
+
+inline void Port::sendCredits(int credits) {
+	ring->sendCredits(node, credits);
+}
+
+inline void Port::sendReverseCredits(int credits) {
+	ring->sendReverseCredits(node, credits);
+}
+
+inline uint64_t Port::now() const {
+	return ring->getTime();
+}
+
+/**
+ * @brief Print the final state of a node with the same lines as node::finish, so the
+ * output can be compared with an SST run.
+ */
+inline void printFinal(int id, const Core &core) {
+	printf("deadlocksim-Node %d->Final queue size is %ld | Max queue size is %d | Final credit size is %d\n", id, core.msgqueue.size(), core.queueMaxSize, core.queueCredits);
+	if (!core.msgqueue.empty()) {
+		printf("deadlocksim-Node %d->Top of queue: Dest_ID-%d\n", id, core.msgqueue.front().dest_id);
+	}
+	printf("deadlocksim-Node %d->Messages generated %" PRIu64 " | forwarded %" PRIu64 " | consumed %" PRIu64 " | dropped %" PRIu64 "\n", id, core.injected, core.forwarded, core.consumed, core.dropped);
+	if (core.bidirectional()) {
+		printf("deadlocksim-Node %d->Final reverse queue size is %ld | Final reverse credit size is %d | Generated in reverse %" PRIu64 "\n", id, core.reverseQueue.size(), core.reverseCredits, core.injectedReverse);
+	}
+	if (core.timedConsumed > 0) {
+		printf("deadlocksim-Node %d->Mean hops %.2f | mean latency %.3f ms\n", id, (double)core.hopsConsumed / core.consumed, core.latencyConsumed / 1e9 / core.timedConsumed);
+	} else if (core.consumed > 0) {
+		printf("deadlocksim-Node %d->Mean hops %.2f\n", id, (double)core.hopsConsumed / core.consumed);
+	}
+	if (core.recoveryDropped + core.recoveryRerouted + core.recoveryDrained > 0) {
+		printf("deadlocksim-Node %d->Recovery dropped %" PRIu64 " | rerouted %" PRIu64 " | drained %" PRIu64 " | still in the recovery buffer %ld\n", id, core.recoveryDropped, core.recoveryRerouted, core.recoveryDrained, core.recoveryBuffer.size());
+	}
+}
+
+/**
+ * @brief Parse a time such as "3ms" into ps. Exits on an unknown unit.
+ */
+inline uint64_t parseTime(const std::string &s) {
+	static const struct { const char *unit; double ps; } units[] = {
+		{ "ps", 1 }, { "ns", 1e3 }, { "us", 1e6 }, { "ms", 1e9 }, { "s", 1e12 },
+	};
+	char *end;
+	double value = strtod(s.c_str(), &end);
+	for (const auto &u : units) {
+		if (strcmp(end, u.unit) == 0) {
+			return (uint64_t)(value * u.ps + 0.5);
+		}
+	}
+	fprintf(stderr, "Unknown time '%s'\n", s.c_str());
+	exit(1);
+}
+
+/**
+ * @brief Read node parameters, one line per node: queueMaxSize tickFreq message_gen,
+ * as written by tests/deadlockring.py --write-params.
+ *
+ * @return false if the file could not be read.
+ */
+inline bool readParams(const std::string &path, std::vector<NodeParams> &params) {
+	std::ifstream in(path);
+	if (!in) {
+		return false;
+	}
+	std::string line;
+	while (std::getline(in, line)) {
+		std::istringstream fields(line);
+		int q;
+		std::string t;
+		float g;
+		if (fields >> q >> t >> g) {
+			params.push_back({ q, parseTime(t), g });
+		}
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,381 @@
+/// \file
+/**
+   Detection latency and false positive / negative rates of the deadlock detectors.
+
+   Runs the ring over many seeds, run r with randseed seed + r, and checks after every
+   time step whether it is deadlocked for good from the global state (the oracle, see
+   Ring::trulyDeadlocked). Next to it the detectors are evaluated on the same run:
+
+   - threshold I:R, the logger's condition of log::tick: every node idle, and idle and
+     blocked for longer than the times I and R. One detector per --thresholds pair.
+   - alarm and unavoidable, the verdicts of Predictor.h, updated every --log-tick.
+   - status probe, the STATUS probe of the deadlock package's node: whenever node 0
+     ticks without credits it sends a probe around the ring, every node forwards it
+     after the link latency only if it can not send, and a probe that gets back to
+     node 0 detects deadlock.
+   - reduced I:R, with --partitions P, the summary tree of the partition loggers
+     (Reduction.h): the ring is split into P segments like tests/ringlib.py does, their
+     summaries change at logger ticks and reach the root after the link latency per
+     level of a tree with --fanin children per logger, and the root applies the
+     thresholds as of the latest time every summary has arrived.
+
+   The detectors see the nodes' state directly, without the latency of the log records,
+   and the probe is emulated on the RingNode model rather than run in the deadlock
+   package. A detection at or after the oracle's onset counts with its latency, one
+   before it (or in a run that never deadlocks) is a false positive, and a deadlock no
+   detector call came for before --stop is a false negative.
+
+   Usage: detectbench [--params FILE | --nodes N --queue Q --tick 3ms --gen 0.9]
+                      [--runs 100] [--seed S] [--link 1ms] [--stop 10s]
+                      [--routing forward|shortest|adaptive]
+                      [--thresholds 0ms:0ms,50ms:50ms] [--log-tick 3ms]
+                      [--alarm-fraction 0.75] [--alarm-run 5] [--confirm-run 10]
+                      [--partitions 0] [--fanin 2] [--csv FILE]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <functional>
+#include <utility>
+#include "Ring.h"
+#include "../Predictor.h"
+#include "../Reduction.h"
+
+/**
+ * @brief Emulation of the deadlock package's STATUS probe on a Ring.
+ */
+class StatusProbe {
+
+public:
+	StatusProbe(const Ring &ring, uint64_t period, uint64_t linkLatency) :
+		ring(ring), period(period), linkLatency(linkLatency) {}
+
+	/**
+	 * @brief Advance the probes to just before the next time step. Call once every
+	 * activity of a time step has run.
+	 *
+	 * @return Time a probe got back to node 0, 0 if none did.
+	 */
+	uint64_t step() {
+		const std::vector<Core> &cores = ring.getCores();
+		uint64_t now = ring.getTime();
+
+		// Node 0 checks its credits before its tick, so before the events of this step.
+		if (now % period == 0 && !credited) {
+			probes.push({ now + linkLatency, 1 % cores.size() });
+		}
+		const Core &initiator = cores[0];
+		credited = initiator.queueCredits > 0 || (initiator.bidirectional() && initiator.reverseCredits > 0);
+
+		// Nothing changes before the next step, every probe until then sees this state.
+		uint64_t next = ring.getNextTime();
+		uint64_t detected = 0;
+		while (!probes.empty() && probes.top().first < next) {
+			std::pair<uint64_t, size_t> p = probes.top();
+			probes.pop();
+			if (p.second == 0) {
+				detected = detected ? detected : p.first;
+			} else if (cores[p.second].stuck()) {
+				probes.push({ p.first + linkLatency, (p.second + 1) % cores.size() });
+			}
+		}
+		return detected;
+	}
+
+private:
+	const Ring &ring; //!< Ring the probes travel in.
+	uint64_t period; //!< Tick period of node 0 in ps.
+	uint64_t linkLatency; //!< Time a probe takes per hop in ps.
+	bool credited = true; //!< Whether node 0 had credits after the last step.
+	std::priority_queue<std::pair<uint64_t, size_t>, std::vector<std::pair<uint64_t, size_t>>, std::greater<std::pair<uint64_t, size_t>>> probes; //!< Arrival time and node of the probes in flight.
+};
+
+/**
+ * @brief Results of one detector over every run.
+ */
+struct Detector {
+	std::string name; //!< Name in the report.
+	std::vector<uint64_t> fired; //!< First detection of every run in ps, 0 if there was none.
+};
+
+int main(int argc, char **argv) {
+	int nodes = 3;
+	int queue = 100;
+	std::string tick = "3ms";
+	float gen = 0.9;
+	int runs = 100;
+	int64_t seed = 121212;
+	std::string link = "1ms";
+	std::string stop = "10s";
+	std::string paramsFile;
+	std::string csvFile;
+	std::string thresholds = "0ms:0ms,25ms:25ms,50ms:50ms,125ms:125ms,250ms:250ms,500ms:500ms";
+	std::string logTick;
+	double alarmFraction = 0.75;
+	int alarmRun = 5;
+	int confirmRun = 10;
+	int partitions = 0;
+	int fanin = 2;
+	RoutingModes routing = ROUTE_FORWARD;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			fprintf(stderr, "Usage: %s [--params FILE | --nodes N --queue Q --tick 3ms --gen 0.9] [--runs 100] [--seed S] [--link 1ms] [--stop 10s] [--routing forward|shortest|adaptive] [--thresholds 0ms:0ms,50ms:50ms] [--log-tick 3ms] [--alarm-fraction 0.75] [--alarm-run 5] [--confirm-run 10] [--partitions 0] [--fanin 2] [--csv FILE]\n", argv[0]);
+			return 1;
+		}
+		std::string value = argv[++i];
+		if (arg == "--nodes") {
+			nodes = atoi(value.c_str());
+		} else if (arg == "--queue") {
+			queue = atoi(value.c_str());
+		} else if (arg == "--tick") {
+			tick = value;
+		} else if (arg == "--gen") {
+			gen = strtof(value.c_str(), NULL);
+		} else if (arg == "--runs") {
+			runs = atoi(value.c_str());
+		} else if (arg == "--seed") {
+			seed = strtoll(value.c_str(), NULL, 10);
+		} else if (arg == "--link") {
+			link = value;
+		} else if (arg == "--stop") {
+			stop = value;
+		} else if (arg == "--params") {
+			paramsFile = value;
+		} else if (arg == "--csv") {
+			csvFile = value;
+		} else if (arg == "--thresholds") {
+			thresholds = value;
+		} else if (arg == "--log-tick") {
+			logTick = value;
+		} else if (arg == "--alarm-fraction") {
+			alarmFraction = strtod(value.c_str(), NULL);
+		} else if (arg == "--alarm-run") {
+			alarmRun = atoi(value.c_str());
+		} else if (arg == "--confirm-run") {
+			confirmRun = atoi(value.c_str());
+		} else if (arg == "--partitions") {
+			partitions = atoi(value.c_str());
+		} else if (arg == "--fanin") {
+			fanin = std::max(atoi(value.c_str()), 1);
+		} else if (arg == "--routing") {
+			if (value == "forward") {
+				routing = ROUTE_FORWARD;
+			} else if (value == "shortest") {
+				routing = ROUTE_SHORTEST;
+			} else if (value == "adaptive") {
+				routing = ROUTE_ADAPTIVE;
+			} else {
+				fprintf(stderr, "Unknown routing %s\n", value.c_str());
+				return 1;
+			}
+		} else {
+			fprintf(stderr, "Unknown option %s\n", arg.c_str());
+			return 1;
+		}
+	}
+
+	std::vector<NodeParams> params;
+	if (!paramsFile.empty()) {
+		if (!readParams(paramsFile, params)) {
+			fprintf(stderr, "Failed to read %s\n", paramsFile.c_str());
+			return 1;
+		}
+	} else {
+		params.assign(nodes, { queue, parseTime(tick), gen });
+	}
+	if (params.empty() || runs <= 0) {
+		fprintf(stderr, "No nodes or no runs\n");
+		return 1;
+	}
+
+	// Threshold pairs I:R of times, comma separated.
+	std::vector<std::pair<int64_t, int64_t>> pairs;
+	std::vector<Detector> detectors;
+	std::istringstream list(thresholds);
+	std::string pair;
+	while (std::getline(list, pair, ',')) {
+		size_t colon = pair.find(':');
+		if (colon == std::string::npos) {
+			fprintf(stderr, "Bad threshold pair '%s', expected idle:blocked\n", pair.c_str());
+			return 1;
+		}
+		pairs.push_back({ parseTime(pair.substr(0, colon)), parseTime(pair.substr(colon + 1)) });
+		detectors.push_back({ "threshold " + pair, {} });
+	}
+	const size_t REDUCED = detectors.size();
+	if (partitions > 1) {
+		for (size_t d = 0; d < pairs.size(); ++d) {
+			detectors.push_back({ "reduced" + detectors[d].name.substr(detectors[d].name.find(' ')), {} });
+		}
+	}
+	const size_t ALARM = detectors.size();
+	detectors.push_back({ "predictor alarm", {} });
+	detectors.push_back({ "predictor unavoidable", {} });
+	detectors.push_back({ "status probe", {} });
+	const size_t UNAVOIDABLE = ALARM + 1;
+	const size_t PROBE = ALARM + 2;
+
+	uint64_t stopTime = parseTime(stop);
+	uint64_t linkLatency = parseTime(link);
+	uint64_t logPeriod = logTick.empty() ? params[0].tickPeriod : parseTime(logTick);
+	int total = params.size();
+
+	// The logger's condition is checked when nodes tick, as Ring::run does.
+	auto ticked = [&params](uint64_t t) {
+		return std::any_of(params.begin(), params.end(), [t](const NodeParams &p) { return t % p.tickPeriod == 0; });
+	};
+	std::vector<uint64_t> onsets(runs);
+	uint64_t summaryHops = 0;
+
+	// Segments of the partition loggers and their levels in the summary tree, as tests/ringlib.py builds them.
+	partitions = std::min(partitions, total);
+	std::vector<int> firstNode, depth;
+	for (int p = 0; p < partitions; ++p) {
+		firstNode.push_back(p * total / partitions);
+		depth.push_back(p ? depth[(p - 1) / fanin] + 1 : 0);
+	}
+	firstNode.push_back(total);
+	int64_t reduceDelay = partitions > 1 ? *std::max_element(depth.begin(), depth.end()) * (int64_t)linkLatency : 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < runs; ++r) {
+		Ring ring(params, seed + r, linkLatency, routing);
+		StatusProbe probe(ring, params[0].tickPeriod, linkLatency);
+		DeadlockPredictor predictor;
+		predictor.configure(total, alarmFraction, alarmRun, confirmRun);
+		std::vector<int> state(total), idle(total), stuck(total);
+		std::vector<int64_t> idleSince(total), blockedSince(total);
+		std::vector<Summary> local(partitions, SummaryTree::moving()), known(partitions, SummaryTree::moving());
+		std::vector<std::queue<std::pair<uint64_t, Summary>>> inFlight(partitions);
+		uint64_t nextLog = logPeriod;
+		uint64_t onset = 0;
+		std::vector<uint64_t> fired(detectors.size(), 0);
+
+		ring.setObserver([&] {
+			uint64_t now = ring.getTime();
+			const std::vector<Core> &cores = ring.getCores();
+			if (!onset && ring.trulyDeadlocked()) {
+				onset = now;
+			}
+			for (size_t d = 0; d < pairs.size(); ++d) {
+				if (!fired[d] && ticked(now) && ring.deadlocked(pairs[d].first, pairs[d].second)) {
+					fired[d] = now;
+				}
+			}
+
+			// Logger ticks until the next step all see the state after this one.
+			uint64_t next = std::min(ring.getNextTime(), stopTime + 1);
+			while (nextLog < next) {
+				if (nextLog >= now) {
+					for (int n = 0; n < total; ++n) {
+						state[n] = cores[n].node_state;
+						idle[n] = cores[n].idleFor(nextLog) / logPeriod;
+						stuck[n] = cores[n].stuck();
+						idleSince[n] = cores[n].idle_since;
+						blockedSince[n] = cores[n].blocked_since;
+					}
+
+					// Changed summaries head for the root, which sees events of its tick's time only after the tick.
+					Summary ring = SummaryTree::moving();
+					for (int p = 0; p < partitions && partitions > 1; ++p) {
+						Summary s = SummaryTree::summarize(&state[firstNode[p]], &idleSince[firstNode[p]], &blockedSince[firstNode[p]], firstNode[p + 1] - firstNode[p]);
+						if (s.idle_since != local[p].idle_since || s.blocked_since != local[p].blocked_since) {
+							local[p] = s;
+							inFlight[p].push({ nextLog + depth[p] * linkLatency, s });
+							summaryHops += depth[p];
+						}
+						while (!inFlight[p].empty() && (inFlight[p].front().first < nextLog || depth[p] == 0)) {
+							known[p] = inFlight[p].front().second;
+							inFlight[p].pop();
+						}
+						ring = p ? SummaryTree::combine(ring, known[p]) : known[p];
+					}
+					for (size_t d = 0; d < pairs.size() && partitions > 1; ++d) {
+						if (!fired[REDUCED + d] && SummaryTree::over(ring, (int64_t)nextLog - reduceDelay - (int64_t)logPeriod, pairs[d].first, pairs[d].second)) {
+							fired[REDUCED + d] = nextLog;
+						}
+					}
+					DeadlockPredictor::Verdict verdict = predictor.update(state.data(), idle.data(), stuck.data());
+					if (verdict != DeadlockPredictor::CLEAR && !fired[ALARM]) {
+						fired[ALARM] = nextLog;
+					}
+					if (verdict == DeadlockPredictor::UNAVOIDABLE && !fired[UNAVOIDABLE]) {
+						fired[UNAVOIDABLE] = nextLog;
+					}
+				}
+				nextLog += logPeriod;
+			}
+
+			uint64_t returned = probe.step();
+			if (returned && !fired[PROBE]) {
+				fired[PROBE] = returned;
+			}
+
+			// Deadlock is for good, so nothing is left to see once every detector fired.
+			return onset && std::all_of(fired.begin(), fired.end(), [](uint64_t t) { return t != 0; });
+		});
+		ring.run(stopTime);
+
+		onsets[r] = onset;
+		for (size_t d = 0; d < detectors.size(); ++d) {
+			detectors[d].fired.push_back(fired[d] <= stopTime ? fired[d] : 0);
+		}
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	int deadlocked = std::count_if(onsets.begin(), onsets.end(), [](uint64_t t) { return t != 0; });
+	printf("%d runs of %d nodes until %s | %.3f s\n", runs, total, stop.c_str(), seconds);
+	printf("Deadlocked for good %d | No deadlock %d\n", deadlocked, runs - deadlocked);
+	if (partitions > 1) {
+		// An upper bound, a logger does not pass on a child's change that leaves its subtree summary as it was.
+		printf("Summary tree of %d partitions, fan-in %d, %" PRId64 " ms to the root | at most %.1f summaries sent per run\n", partitions, fanin, reduceDelay / 1000000000, (double)summaryHops / runs);
+	}
+	printf("%-24s %8s %8s %8s %8s %9s %9s %9s %9s\n", "Detector", "Detected", "False+", "False-", "Missed%", "Mean ms", "p50 ms", "p95 ms", "Max ms");
+	for (const Detector &d : detectors) {
+		std::vector<uint64_t> latencies;
+		int falsePositives = 0;
+		int falseNegatives = 0;
+		for (int r = 0; r < runs; ++r) {
+			if (d.fired[r] && (!onsets[r] || d.fired[r] < onsets[r])) {
+				falsePositives++;
+			} else if (d.fired[r]) {
+				latencies.push_back(d.fired[r] - onsets[r]);
+			} else if (onsets[r]) {
+				falseNegatives++;
+			}
+		}
+		std::sort(latencies.begin(), latencies.end());
+		double mean = 0;
+		for (uint64_t t : latencies) {
+			mean += t / 1e9;
+		}
+		auto quantile = [&latencies](double q) { return latencies.empty() ? 0.0 : latencies[(size_t)(q * (latencies.size() - 1))] / 1e9; };
+		printf("%-24s %8zu %8d %8d %7.1f%% %9.1f %9.1f %9.1f %9.1f\n", d.name.c_str(), latencies.size(), falsePositives, falseNegatives,
+			deadlocked ? 100.0 * falseNegatives / deadlocked : 0.0, latencies.empty() ? 0.0 : mean / latencies.size(), quantile(0.5), quantile(0.95), quantile(1));
+	}
+
+	if (!csvFile.empty()) {
+		FILE *f = fopen(csvFile.c_str(), "w");
+		if (!f) {
+			fprintf(stderr, "Failed to write %s\n", csvFile.c_str());
+			return 1;
+		}
+		fprintf(f, "seed,onset_ps");
+		for (const Detector &d : detectors) {
+			fprintf(f, ",%s", d.name.c_str());
+		}
+		fprintf(f, "\n");
+		for (int r = 0; r < runs; ++r) {
+			fprintf(f, "%" PRId64 ",%" PRIu64, seed + r, onsets[r]);
+			for (const Detector &d : detectors) {
+				fprintf(f, ",%" PRIu64, d.fired[r]);
+			}
+			fprintf(f, "\n");
+		}
+		fclose(f);
+	}
+	return 0;
+}
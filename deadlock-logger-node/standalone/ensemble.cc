@@ -0,0 +1,183 @@
+/// \file
+/**
+   Time-to-deadlock distribution of one ring over many seeds.
+
+   Runs thousands of instances of the same ring, instance i with randseed seed + i, in
+   lockstep with the vectorized kernels of Ensemble.h, and reports when each instance
+   first met the logger's deadlock condition. --verify K also runs the first K seeds
+   through the scalar Ring and fails if any deadlock time or queue size differs.
+
+   Usage: ensemble [--params FILE | --nodes N --queue Q --tick 3ms --gen 0.9]
+                   [--instances 1000] [--seed S] [--link 1ms] [--stop 1000s]
+                   [--idle-threshold 250ms] [--request-threshold 250ms]
+                   [--csv FILE] [--verify K] [--scalar]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include "Ensemble.h"
+
+/**
+ * @brief Run the ensemble with the widest backend compiled in, or the scalar one.
+ *
+ * @return Name of the backend used.
+ */
+static const char *runEnsemble(Ensemble &ensemble, uint64_t stop, bool scalar) {
+	if (!scalar) {
+#if defined(__AVX512F__)
+		ensemble.run<lanes::Avx512>(stop);
+		return lanes::Avx512::name();
+#elif defined(__AVX2__)
+		ensemble.run<lanes::Avx2>(stop);
+		return lanes::Avx2::name();
+#endif
+	}
+	ensemble.run<lanes::Scalar>(stop);
+	return lanes::Scalar::name();
+}
+
+int main(int argc, char **argv) {
+	int nodes = 3;
+	int queue = 100;
+	std::string tick = "3ms";
+	float gen = 0.9;
+	int instances = 1000;
+	int64_t seed = 121212;
+	std::string link = "1ms";
+	std::string stop = "1000s";
+	std::string paramsFile;
+	std::string csvFile;
+	std::string idleThreshold = "250ms";
+	std::string requestThreshold = "250ms";
+	int verify = 0;
+	bool scalar = false;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--scalar") {
+			scalar = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			fprintf(stderr, "Usage: %s [--params FILE | --nodes N --queue Q --tick 3ms --gen 0.9] [--instances 1000] [--seed S] [--link 1ms] [--stop 1000s] [--idle-threshold 250ms] [--request-threshold 250ms] [--csv FILE] [--verify K] [--scalar]\n", argv[0]);
+			return 1;
+		}
+		std::string value = argv[++i];
+		if (arg == "--nodes") {
+			nodes = atoi(value.c_str());
+		} else if (arg == "--queue") {
+			queue = atoi(value.c_str());
+		} else if (arg == "--tick") {
+			tick = value;
+		} else if (arg == "--gen") {
+			gen = strtof(value.c_str(), NULL);
+		} else if (arg == "--instances") {
+			instances = atoi(value.c_str());
+		} else if (arg == "--seed") {
+			seed = strtoll(value.c_str(), NULL, 10);
+		} else if (arg == "--link") {
+			link = value;
+		} else if (arg == "--stop") {
+			stop = value;
+		} else if (arg == "--params") {
+			paramsFile = value;
+		} else if (arg == "--csv") {
+			csvFile = value;
+		} else if (arg == "--idle-threshold") {
+			idleThreshold = value;
+		} else if (arg == "--request-threshold") {
+			requestThreshold = value;
+		} else if (arg == "--verify") {
+			verify = atoi(value.c_str());
+		} else {
+			fprintf(stderr, "Unknown option %s\n", arg.c_str());
+			return 1;
+		}
+	}
+
+	std::vector<NodeParams> params;
+	if (!paramsFile.empty()) {
+		if (!readParams(paramsFile, params)) {
+			fprintf(stderr, "Failed to read %s\n", paramsFile.c_str());
+			return 1;
+		}
+	} else {
+		params.assign(nodes, { queue, parseTime(tick), gen });
+	}
+	if (instances <= 0) {
+		fprintf(stderr, "No instances\n");
+		return 1;
+	}
+
+	uint64_t stopTime = parseTime(stop);
+	uint64_t linkLatency = parseTime(link);
+	int64_t idleTime = parseTime(idleThreshold);
+	int64_t requestTime = parseTime(requestThreshold);
+	Ensemble ensemble(params, linkLatency, seed, instances, idleTime, requestTime);
+	if (!ensemble.fits()) {
+		fprintf(stderr, "Ring of %zu nodes with these queue sizes and %d instances is not supported\n", params.size(), instances);
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	const char *backend = runEnsemble(ensemble, stopTime, scalar);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// Distribution of the deadlock times. Instances without deadlock before --stop are censored.
+	std::vector<uint64_t> times;
+	for (int i = 0; i < instances; ++i) {
+		if (ensemble.getDeadlockTime(i)) {
+			times.push_back(ensemble.getDeadlockTime(i));
+		}
+	}
+	std::sort(times.begin(), times.end());
+	printf("%d instances of %zu nodes | %s | %.3f s | %.2f M node ticks/s\n", instances, params.size(), backend, seconds, ensemble.getLaneTicks() / seconds / 1e6);
+	printf("Deadlocked %zu | No deadlock before %s %zu\n", times.size(), stop.c_str(), instances - times.size());
+	if (!times.empty()) {
+		double mean = 0;
+		for (uint64_t t : times) {
+			mean += t / 1e9;
+		}
+		mean /= times.size();
+		auto quantile = [&times](double q) { return times[(size_t)(q * (times.size() - 1))] / 1e9; };
+		printf("Time to deadlock (ms): mean %.1f | min %.1f | p10 %.1f | p50 %.1f | p90 %.1f | max %.1f\n",
+			mean, quantile(0), quantile(0.1), quantile(0.5), quantile(0.9), quantile(1));
+	}
+
+	if (!csvFile.empty()) {
+		FILE *f = fopen(csvFile.c_str(), "w");
+		if (!f) {
+			fprintf(stderr, "Failed to write %s\n", csvFile.c_str());
+			return 1;
+		}
+		fprintf(f, "seed,deadlock_ps\n");
+		for (int i = 0; i < instances; ++i) {
+			if (ensemble.getDeadlockTime(i)) {
+				fprintf(f, "%" PRId64 ",%" PRIu64 "\n", seed + i, ensemble.getDeadlockTime(i));
+			} else {
+				fprintf(f, "%" PRId64 ",none\n", seed + i);
+			}
+		}
+		fclose(f);
+	}
+
+	// Seed for seed check against the scalar model.
+	int mismatches = 0;
+	for (int i = 0; i < std::min(verify, instances); ++i) {
+		Ring ring(params, seed + i, linkLatency);
+		uint64_t expected = ring.run(stopTime, idleTime, requestTime);
+		bool same = expected == ensemble.getDeadlockTime(i);
+		for (int n = 0; same && expected && n < ensemble.getNodes(); ++n) {
+			same = (int)ring.getCores()[n].msgqueue.size() == ensemble.getDeadlockQueueSize(i, n);
+		}
+		if (!same) {
+			printf("Seed %" PRId64 " differs: scalar %" PRIu64 " ps, ensemble %" PRIu64 " ps\n", seed + i, expected, ensemble.getDeadlockTime(i));
+			mismatches++;
+		}
+	}
+	if (verify > 0) {
+		printf("Verified %d seeds against the scalar model: %d mismatches\n", std::min(verify, instances), mismatches);
+	}
+	return mismatches ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+/// \file
+/**
+   Replays a window of consecutive nodes from a recorded run, without SST.
+
+   Reads the delivery records of every partition in a record directory, written by the
+   components' record_dir parameter or ringsim --record. Only nodes first to last are
+   simulated; the events the rest of the ring sent into the window (and the logger's
+   recovery requests) are delivered from the record at their recorded times, and what
+   the window sends out of it is discarded. Every delivery of the replay is checked
+   against the record, and the final state of the window is printed with the same lines
+   as ringsim and node::finish.
+
+   The ring parameters and seed must be the ones of the recorded run. Whether the
+   messages were timed (the latency parameter) is read from the record. By default the
+   replay stops at the end of the record.
+
+   Usage: replay --record DIR --first A --last B [--nodes N] [--queue Q] [--tick 3ms]
+                 [--gen 0.9] [--seed S] [--link 1ms] [--params FILE]
+                 [--routing forward|shortest|adaptive] [--stop T]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <dirent.h>
+#include "Ring.h"
+
+/**
+ * @brief Read every record stream in a directory.
+ *
+ * @param visit Called with every record, stream by stream.
+ * @return Number of streams read, -1 if the directory or a stream could not be read.
+ */
+template <class F>
+int readRecords(const std::string &dir, F visit) {
+	DIR *d = opendir(dir.c_str());
+	if (!d) {
+		return -1;
+	}
+	std::vector<std::string> files;
+	while (struct dirent *e = readdir(d)) {
+		std::string name = e->d_name;
+		if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0) {
+			files.push_back(dir + "/" + name);
+		}
+	}
+	closedir(d);
+	for (const std::string &path : files) {
+		RecordReader reader;
+		if (!reader.open(path)) {
+			fprintf(stderr, "%s is not a record stream\n", path.c_str());
+			return -1;
+		}
+		DeliveryRecord r;
+		while (reader.next(r)) {
+			visit(r);
+		}
+	}
+	return files.size();
+}
+
+int main(int argc, char **argv) {
+	int nodes = 3;
+	int queue = 50;
+	std::string tick = "10s";
+	float gen = 0.5;
+	int64_t seed = 121212;
+	std::string link = "1ms";
+	std::string stop;
+	std::string paramsFile;
+	std::string recordDir;
+	int first = -1;
+	int last = -1;
+	RoutingModes routing = ROUTE_FORWARD;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			fprintf(stderr, "Usage: %s --record DIR --first A --last B [--nodes N] [--queue Q] [--tick 3ms] [--gen 0.9] [--seed S] [--link 1ms] [--params FILE] [--routing forward|shortest|adaptive] [--stop T]\n", argv[0]);
+			return 1;
+		}
+		std::string value = argv[++i];
+		if (arg == "--record") {
+			recordDir = value;
+		} else if (arg == "--first") {
+			first = atoi(value.c_str());
+		} else if (arg == "--last") {
+			last = atoi(value.c_str());
+		} else if (arg == "--nodes") {
+			nodes = atoi(value.c_str());
+		} else if (arg == "--queue") {
+			queue = atoi(value.c_str());
+		} else if (arg == "--tick") {
+			tick = value;
+		} else if (arg == "--gen") {
+			gen = strtof(value.c_str(), NULL);
+		} else if (arg == "--seed") {
+			seed = strtoll(value.c_str(), NULL, 10);
+		} else if (arg == "--link") {
+			link = value;
+		} else if (arg == "--stop") {
+			stop = value;
+		} else if (arg == "--params") {
+			paramsFile = value;
+		} else if (arg == "--routing") {
+			if (value == "forward") {
+				routing = ROUTE_FORWARD;
+			} else if (value == "shortest") {
+				routing = ROUTE_SHORTEST;
+			} else if (value == "adaptive") {
+				routing = ROUTE_ADAPTIVE;
+			} else {
+				fprintf(stderr, "Unknown routing %s\n", value.c_str());
+				return 1;
+			}
+		} else {
+			fprintf(stderr, "Unknown option %s\n", arg.c_str());
+			return 1;
+		}
+	}
+
+	std::vector<NodeParams> params;
+	if (!paramsFile.empty()) {
+		if (!readParams(paramsFile, params)) {
+			fprintf(stderr, "Failed to read %s\n", paramsFile.c_str());
+			return 1;
+		}
+	} else {
+		params.assign(nodes, { queue, parseTime(tick), gen });
+	}
+	int total = params.size();
+	if (recordDir.empty() || first < 0 || last < first || last >= total) {
+		fprintf(stderr, "Need --record and a window 0 <= --first <= --last < %d\n", total);
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	Ring ring(params, seed, parseTime(link), routing, first, last - first + 1);
+
+	// Deliveries to every port of the window, in recorded order. Each port has a single
+	// sender, so the order within a port is the order the sender sent in.
+	std::vector<std::vector<DeliveryRecord>> recorded((last - first + 1) * 3);
+	uint64_t end = 0;
+	uint64_t boundary = 0;
+	bool timed = false;
+	int streams = readRecords(recordDir, [&](const DeliveryRecord &r) {
+		if (r.kind == RECORD_END) {
+			end = std::max(end, r.time);
+			return;
+		}
+		timed = timed || (r.kind == RECORD_MESSAGE && (wire::flagsOf(r.payload) & wire::TIME_FLAG));
+		if (r.node < first || r.node > last) {
+			return;
+		}
+		recorded[(r.node - first) * 3 + r.port].push_back(r);
+		int sender = r.port == RECORD_PREV ? (r.node + total - 1) % total : (r.node + 1) % total;
+		if (r.port == RECORD_LOG || sender < first || sender > last) {
+			ring.deliver(r);
+			boundary++;
+		}
+	});
+	if (streams <= 0) {
+		fprintf(stderr, "No record streams in %s\n", recordDir.c_str());
+		return 1;
+	}
+	ring.setTiming(timed);
+	uint64_t stopTime = stop.empty() ? end : parseTime(stop);
+
+	// Check the replayed deliveries against the record.
+	std::vector<size_t> replayed(recorded.size());
+	uint64_t deliveries = 0;
+	uint64_t mismatches = 0;
+	ring.setRecorder([&](const DeliveryRecord &r) {
+		size_t port = (r.node - first) * 3 + r.port;
+		size_t i = replayed[port]++;
+		deliveries++;
+		if (i >= recorded[port].size() || recorded[port][i] != r) {
+			if (mismatches++ == 0) {
+				printf("First mismatch at %" PRIu64 " ps: node %d port %d kind %d payload %" PRIu64 " was not recorded\n", r.time, r.node, r.port, r.kind, r.payload);
+			}
+		}
+	});
+	ring.run(stopTime);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// Recorded deliveries up to the stop time that the replay did not make.
+	for (size_t port = 0; port < recorded.size(); ++port) {
+		for (size_t i = replayed[port]; i < recorded[port].size() && recorded[port][i].time <= stopTime; ++i) {
+			mismatches++;
+		}
+	}
+
+	const std::vector<Core> &cores = ring.getCores();
+	for (size_t i = 0; i < cores.size(); ++i) {
+		printFinal(first + i, cores[i]);
+	}
+	printf("Replayed nodes %d to %d from %d streams until %" PRIu64 " ps | %" PRIu64 " boundary events | %" PRIu64 " deliveries | %" PRIu64 " differ from the record | %.3f s\n", first, last, streams, stopTime, boundary, deliveries, mismatches, seconds);
+	return mismatches ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+/// \file
+/**
+   Standalone discrete-event driver of the ring, without SST.
+
+   Runs the same RingNode core as the node component with the same event ordering as
+   SST's time vortex: by delivery time, then priority (clocks before events), then the
+   order activities were scheduled in. Nodes with the same tick period share one clock
+   and tick in construction order, as they do in SST. For the same parameters and seed
+   the final node state matches an SST run stopped at the same time.
+
+   Usage: ringsim [--nodes N] [--queue Q] [--tick 3ms] [--gen 0.9] [--seed S]
+                  [--link 1ms] [--stop 1s] [--params FILE]
+                  [--idle-threshold 250ms --request-threshold 250ms]
+                  [--routing forward|shortest|adaptive] [--record DIR] [--oracle]
+                  [--latency] [--bench]
+
+   With thresholds the run stops at the first time every node is idle and has been
+   idle and blocked for longer than the thresholds, the logger's deadlock condition.
+   --oracle stops the run at the first time the ring is deadlocked for good, judged from
+   the global state (see Ring::trulyDeadlocked), instead.
+   --latency times every message and prints the mean latency.
+   --record writes every delivery to DIR/rank-0-thread-0.bin, as the components' record_dir
+   parameter does, for standalone/replay.
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include "Ring.h"
+
+int main(int argc, char **argv) {
+	int nodes = 3;
+	int queue = 50;
+	std::string tick = "10s";
+	float gen = 0.5;
+	int64_t seed = 121212;
+	std::string link = "1ms";
+	std::string stop = "1s";
+	std::string paramsFile;
+	std::string recordDir;
+	int64_t idleThreshold = -1;
+	int64_t requestThreshold = -1;
+	bool bench = false;
+	bool oracle = false;
+	bool timing = false;
+	RoutingModes routing = ROUTE_FORWARD;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--bench") {
+			bench = true;
+			continue;
+		}
+		if (arg == "--oracle") {
+			oracle = true;
+			continue;
+		}
+		if (arg == "--latency") {
+			timing = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			fprintf(stderr, "Usage: %s [--nodes N] [--queue Q] [--tick 3ms] [--gen 0.9] [--seed S] [--link 1ms] [--stop 1s] [--params FILE] [--idle-threshold 250ms --request-threshold 250ms] [--routing forward|shortest|adaptive] [--record DIR] [--oracle] [--latency] [--bench]\n", argv[0]);
+			return 1;
+		}
+		std::string value = argv[++i];
+		if (arg == "--nodes") {
+			nodes = atoi(value.c_str());
+		} else if (arg == "--queue") {
+			queue = atoi(value.c_str());
+		} else if (arg == "--tick") {
+			tick = value;
+		} else if (arg == "--gen") {
+			gen = strtof(value.c_str(), NULL);
+		} else if (arg == "--seed") {
+			seed = strtoll(value.c_str(), NULL, 10);
+		} else if (arg == "--link") {
+			link = value;
+		} else if (arg == "--stop") {
+			stop = value;
+		} else if (arg == "--params") {
+			paramsFile = value;
+		} else if (arg == "--record") {
+			recordDir = value;
+		} else if (arg == "--idle-threshold") {
+			idleThreshold = parseTime(value);
+		} else if (arg == "--request-threshold") {
+			requestThreshold = parseTime(value);
+		} else if (arg == "--routing") {
+			if (value == "forward") {
+				routing = ROUTE_FORWARD;
+			} else if (value == "shortest") {
+				routing = ROUTE_SHORTEST;
+			} else if (value == "adaptive") {
+				routing = ROUTE_ADAPTIVE;
+			} else {
+				fprintf(stderr, "Unknown routing %s\n", value.c_str());
+				return 1;
+			}
+		} else {
+			fprintf(stderr, "Unknown option %s\n", arg.c_str());
+			return 1;
+		}
+	}
+
+	std::vector<NodeParams> params;
+	if (!paramsFile.empty()) {
+		if (!readParams(paramsFile, params)) {
+			fprintf(stderr, "Failed to read %s\n", paramsFile.c_str());
+			return 1;
+		}
+	} else {
+		params.assign(nodes, { queue, parseTime(tick), gen });
+	}
+	if (params.empty()) {
+		fprintf(stderr, "No nodes\n");
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	Ring ring(params, seed, parseTime(link), routing);
+	ring.setTiming(timing);
+	RecordWriter recorder;
+	if (!recordDir.empty()) {
+		if (!recorder.open(recordDir, 0, 0)) {
+			fprintf(stderr, "Failed to create the record in %s\n", recordDir.c_str());
+			return 1;
+		}
+		ring.setRecorder([&recorder](const DeliveryRecord &r) { recorder.write(r); });
+	}
+	if (oracle) {
+		idleThreshold = -1;
+		ring.setObserver([&ring] { return ring.trulyDeadlocked(); });
+	}
+	uint64_t deadlock = ring.run(parseTime(stop), idleThreshold, requestThreshold);
+	if (!recorder.close(ring.getTime())) {
+		fprintf(stderr, "Failed to write the record in %s\n", recordDir.c_str());
+		return 1;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (bench) {
+		printf("%zu nodes | %" PRIu64 " ticks | %" PRIu64 " events | %.3f s | %.2f M ticks/s\n", params.size(), ring.getTicks(), ring.getEvents(), seconds, ring.getTicks() / seconds / 1e6);
+		return 0;
+	}
+
+	// Same lines as node::finish, so the output can be compared with an SST run.
+	const std::vector<Core> &cores = ring.getCores();
+	for (size_t i = 0; i < cores.size(); ++i) {
+		printFinal(i, cores[i]);
+	}
+
+	// Ring-wide delivery, for comparing routings.
+	uint64_t consumed = 0, hops = 0, latency = 0, timed = 0;
+	for (const Core &c : cores) {
+		consumed += c.consumed;
+		hops += c.hopsConsumed;
+		latency += c.latencyConsumed;
+		timed += c.timedConsumed;
+	}
+	if (timed > 0) {
+		printf("Consumed %" PRIu64 " | mean hops %.2f | mean latency %.3f ms\n", consumed, (double)hops / consumed, latency / 1e9 / timed);
+	} else if (consumed > 0) {
+		printf("Consumed %" PRIu64 " | mean hops %.2f\n", consumed, (double)hops / consumed);
+	}
+	if (deadlock) {
+		printf("%s at %" PRIu64 " ps\n", oracle ? "True deadlock" : "Detected Deadlock", deadlock);
+	}
+	printf("Simulation is complete, simulated time: %" PRIu64 " ps\n", ring.getTime());
+	return 0;
+}
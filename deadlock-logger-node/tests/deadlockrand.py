@@ -12,7 +12,7 @@ QUEUE_MAX_SIZE = 120  # Maximum possible queue size.
 TICK_MIN_FREQ = 2  # Minimum tick frequency of nodes.
 TICK_MAX_FREQ = 5  # Maximum tick frequency of nodes.
 
-random.seed  # Create rng seed.
+random.seed(SEED)  # Seed the parameter rng so runs are reproducible.
 
 nodes = dict()
 
@@ -0,0 +1,217 @@
+# Reference: http://sst-simulator.org/SSTPages/SSTUserPythonFileFormat/
+#
+# Ring of any size built with ringlib. Runs on any number of ranks (mpirun -np) and
+# threads (sst -n); the ring is split into one contiguous segment per partition.
+#
+# Usage: sst tests/deadlockring.py --model-options="--nodes 100 [--serial] [--log-mode shared]"
+
+import argparse
+import os
+import random
+import sys
+from typing import Dict
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(sys.argv[0])))
+
+import ringlib  # Partition-aware ring builder.
+
+parser = argparse.ArgumentParser(description="Deadlock ring of any size.")
+parser.add_argument("--nodes", type=int, default=3, help="Number of nodes in the ring.")
+parser.add_argument("--seed", type=int, default=1234, help="Seed for node parameters.")
+parser.add_argument(
+    "--randseed",
+    type=int,
+    default=None,
+    help="Seed of every node's message generator. Defaults to the node's own default.",
+)
+parser.add_argument(
+    "--message-gen",
+    type=float,
+    default=0.90,
+    help="Probability that a node generates a message on tick.",
+)
+parser.add_argument(
+    "--queue-size",
+    type=int,
+    default=None,
+    help="Queue size of every node. Defaults to a random size per node.",
+)
+parser.add_argument("--link-latency", default="1ms", help="Latency of the ring links.")
+parser.add_argument(
+    "--log-latency",
+    default="1ps",
+    help="Latency of the logger links. Up to the node tick period, the loggers delay their view to match.",
+)
+parser.add_argument(
+    "--predictor",
+    choices=["off", "alarm", "end"],
+    default="alarm",
+    help="Early deadlock prediction in the loggers. 'end' ends the run once deadlock is unavoidable.",
+)
+parser.add_argument(
+    "--steady-state",
+    choices=["off", "report", "end"],
+    default="end",
+    help="End runs that settle without deadlock once throughput and queue sizes converge.",
+)
+parser.add_argument(
+    "--recovery",
+    choices=["stop", "drop", "reroute", "drain"],
+    default="stop",
+    help="Resolve deadlocks and keep running instead of ending the run.",
+)
+parser.add_argument(
+    "--routing",
+    choices=["forward", "shortest", "adaptive"],
+    default="forward",
+    help="Send every message forward, or both ways round the ring along the shorter side.",
+)
+parser.add_argument(
+    "--latency",
+    action="store_true",
+    help="Time every message for the mean latency. Adds a word to every message event.",
+)
+parser.add_argument(
+    "--builder",
+    choices=["nodes", "segments"],
+    default="nodes",
+    help="One component per node, or one segment component running all nodes of a partition.",
+)
+parser.add_argument(
+    "--quiet",
+    action="store_true",
+    help="No per-tick console output and no CSV. Deadlock detection and finish() are still printed.",
+)
+parser.add_argument(
+    "--serial",
+    action="store_true",
+    help="Single global logger and no pinning. Reference layout for determinism checks.",
+)
+parser.add_argument(
+    "--reduce-fanin",
+    type=int,
+    default=0,
+    help="Decide on deadlock for the whole ring over a tree of loggers with this "
+    "fan-in. 0 lets every partition's logger decide for its own segment.",
+)
+parser.add_argument(
+    "--log-mode",
+    choices=["events", "shared"],
+    default="events",
+    help="Send LogEvents or use the in-process telemetry table.",
+)
+parser.add_argument(
+    "--stats",
+    choices=["none"] + list(ringlib.STAT_OUTPUTS),
+    default="none",
+    help="Collect SST statistics in this format. Disables the logger's CSV and per-tick console output.",
+)
+parser.add_argument(
+    "--profile", action="store_true", help="Profile every handler, see output/profile.json."
+)
+parser.add_argument(
+    "--snapshot-at",
+    default="",
+    help="Save the state of every component at this time, for example 300ms.",
+)
+parser.add_argument(
+    "--restore-from",
+    default="",
+    help="Start from the snapshot in this directory instead of an empty ring.",
+)
+parser.add_argument(
+    "--export-socket",
+    default="",
+    help="Publish the loggers' aggregates on this UNIX socket, see tools/telemetrywatch.py.",
+)
+parser.add_argument(
+    "--record-dir",
+    default="",
+    help="Record every delivery into one stream per partition here, for standalone/replay.",
+)
+parser.add_argument(
+    "--write-params",
+    default="",
+    help="Write every node's parameters to this file for standalone/ringsim --params.",
+)
+args = parser.parse_args(sys.argv[1:])
+
+# Node parameters are randomly generated between the two ranges for queue size and tick frequency.
+QUEUE_MIN_SIZE = 80  # Minimum possible queue size
+QUEUE_MAX_SIZE = 120  # Maximum possible queue size.
+TICK_MIN_FREQ = 2  # Minimum tick frequency of nodes.
+TICK_MAX_FREQ = 5  # Maximum tick frequency of nodes.
+
+# Draw every node's parameters up front so they do not depend on the partitioning.
+rng = random.Random(args.seed)
+node_params: Dict[int, Dict[str, str]] = {
+    x: {
+        "queueMaxSize": f"{rng.randint(QUEUE_MIN_SIZE, QUEUE_MAX_SIZE)}",  # Max message queue size.
+        "tickFreq": f"{rng.randint(TICK_MIN_FREQ, TICK_MAX_FREQ)}ms",  # Frequency component ticks at.
+        "message_gen": f"{args.message_gen}",  # Probability that the node will generate a message on tick.
+        "routing": args.routing,  # Direction messages are sent in.
+        "latency": f"{int(args.latency)}",  # Time the messages.
+        "profile": f"{int(args.profile)}",  # Profile the node's handlers.
+        "snapshot_at": args.snapshot_at,  # Time to snapshot the node's state at.
+        "restore_from": args.restore_from,  # Snapshot to start from.
+        "record_dir": args.record_dir,  # Directory of the delivery record.
+    }
+    for x in range(args.nodes)
+}
+if args.queue_size is not None:
+    for params in node_params.values():
+        params["queueMaxSize"] = f"{args.queue_size}"  # Same queue size on every node.
+if args.randseed is not None:
+    for params in node_params.values():
+        params["randseed"] = f"{args.randseed}"  # Seed of the node's message generator.
+
+if args.write_params:
+    with open(args.write_params, "w") as f:
+        for x in range(args.nodes):
+            p = node_params[x]
+            f.write(f"{p['queueMaxSize']} {p['tickFreq']} {p['message_gen']}\n")
+
+logger_params = {
+    "tickFreq": "1ms",  # Frequency component updates at.
+    "idle_threshold": "250ms",  # Time all monitored nodes must have been idle for, longer than this, for deadlock to be declared.
+    "request_threshold": "250ms",  # Time all monitored nodes must have been blocked by missing credits for, longer than this, for deadlock to be declared.
+    "predictor": args.predictor,  # Warn about, or end the run at, unavoidable deadlock.
+    "steady_state": args.steady_state,  # Report, or end the run at, a steady state without deadlock.
+    "recovery": args.recovery,  # End the run on deadlock, or resolve it and continue.
+    "csv_file": "" if args.stats != "none" or args.quiet else "output/log_data.csv",
+    "verbose": "0" if args.stats != "none" or args.quiet else "1",
+    "profile": f"{int(args.profile)}",
+    "snapshot_at": args.snapshot_at,
+    "restore_from": args.restore_from,
+    "export_socket": args.export_socket,
+}
+
+if args.log_mode == "shared" and args.serial and ringlib.partition_count()[1] > 1:
+    parser.error("--log-mode shared with --serial needs a single thread (sst -n 1)")
+
+if args.builder == "segments":
+    if args.profile or args.snapshot_at or args.restore_from or args.log_mode != "events":
+        parser.error("--builder segments supports neither --profile, snapshots nor --log-mode")
+    ringlib.build_segments(
+        args.nodes,
+        lambda x: node_params[x],
+        logger_params,
+        link_latency=args.link_latency,
+        log_latency=args.log_latency,
+        partitioned=not args.serial,
+        reduce_fanin=args.reduce_fanin,
+    )
+else:
+    ringlib.build_ring(
+        args.nodes,
+        lambda x: node_params[x],
+        logger_params,
+        link_latency=args.link_latency,
+        log_latency=args.log_latency,
+        partitioned=not args.serial,
+        log_mode=args.log_mode,
+        reduce_fanin=args.reduce_fanin,
+    )
+
+if args.stats != "none":
+    ringlib.enable_statistics(args.stats)
@@ -0,0 +1,320 @@
+# Reference: http://sst-simulator.org/SSTPages/SSTUserPythonFileFormat/
+#
+# Partition-aware ring builder shared by the python driver files.
+#
+# Nodes are handed to partitions (MPI rank, thread) in contiguous segments of the ring,
+# so only the two ring links at each segment boundary cross a partition. Each partition
+# gets its own logger placed on the same rank and thread, so the per-tick log traffic
+# never leaves the partition and the logger links do not limit SST's lookahead. With
+# reduce_fanin the loggers also form a tree of summary links that decides on deadlock
+# for the whole ring, so the only cross-partition logger traffic is a summary per
+# change.
+
+from typing import Any, Callable, Dict, List, Tuple
+
+import sst  # Use SST Library
+
+
+def partition_count() -> Tuple[int, int]:
+    """Return the number of MPI ranks and threads per rank the simulation runs on."""
+    return sst.getMPIRankCount(), sst.getThreadCount()
+
+
+def pin_partitions() -> None:
+    """Make SST place components where setRank puts them, instead of partitioning."""
+    sst.setProgramOption("partitioner", "sst.self")
+
+
+def segments(num_nodes: int, num_parts: int) -> List[range]:
+    """Split node IDs 0..num_nodes-1 into num_parts contiguous segments of near equal size."""
+    num_parts = max(1, min(num_parts, num_nodes))
+    return [
+        range(p * num_nodes // num_parts, (p + 1) * num_nodes // num_parts)
+        for p in range(num_parts)
+    ]
+
+
+def build_ring(
+    num_nodes: int,
+    node_params: Callable[[int], Dict[str, str]],
+    logger_params: Dict[str, str],
+    link_latency: str = "1ms",
+    log_latency: str = "1ps",
+    partitioned: bool = True,
+    log_mode: str = "events",
+    reduce_fanin: int = 0,
+) -> Tuple[List[Any], List[Any]]:
+    """
+    Build a ring of deadlocklog.node components and their loggers.
+
+    node_params(x) returns the parameters of node x. "id" and "total_nodes" are filled in.
+    logger_params are shared by every logger. "num_nodes" and "first_node" are filled in and
+    with more than one logger the partition number is added to "csv_file" (empty disables it).
+
+    The ring link latency is part of the model (it is the message transfer time), so it
+    is kept for every link. Since the loggers are partition-local, the smallest latency
+    on any link that crosses a partition is link_latency, which is the lookahead SST gets.
+
+    Nodes stamp their records with the time they were taken, and every logger gets
+    "log_delay" set to log_latency, so it evaluates the ring as it was log_latency ago with
+    all records lined up. log_latency can therefore go up to the node tick period, which
+    matters when logger links do cross partitions, as with partitioned=False.
+
+    log_mode "shared" makes nodes write their records to an in-process table the loggers
+    read instead of sending LogEvents. The logger links are still connected, because
+    components fall back to LogEvents when running on more than one rank. A logger reads
+    the table on its own tick, so it must run on the same thread as its nodes, or it
+    would see them at whatever time their thread has reached. That holds for
+    partitioned rings, and a global logger with more than one thread is refused.
+
+    With partitioned=False a single global logger is used and components are not pinned,
+    which is the layout of the original drivers and serves as the serial reference.
+
+    With reduce_fanin > 0 the loggers are connected by build_summary_tree and only the
+    root declares deadlock, once the whole ring meets the thresholds. Otherwise every
+    logger decides for its own segment.
+
+    Returns the list of nodes and the list of loggers.
+    """
+    ranks, threads = partition_count()
+    parts = segments(num_nodes, ranks * threads if partitioned else 1)
+    if log_mode == "shared" and not partitioned and threads > 1:
+        raise ValueError("log_mode shared needs the partitioned layout on many threads")
+    if partitioned:
+        pin_partitions()
+
+    nodes = []
+    for x in range(num_nodes):
+        # Creating a node from element deadlocklog (deadlocklog.node) named "Node {x}".
+        node = sst.Component(f"Node {x}", "deadlocklog.node")
+        params = dict(node_params(x))
+        params.update(
+            {"id": f"{x}", "total_nodes": f"{num_nodes}", "log_mode": log_mode}
+        )
+        node.addParams(params)
+        nodes.append(node)
+
+    # Connect nodes in a ring.
+    for x in range(num_nodes):
+        sst.Link(f"Link_{x}").connect(
+            (nodes[x], "nextPort", link_latency),
+            (nodes[(x + 1) % num_nodes], "prevPort", link_latency),
+        )
+
+    loggers = []
+    for p, segment in enumerate(parts):
+        # Create a log component from element deadlock (deadlocklog.log) for the segment.
+        name = "Logger" if len(parts) == 1 else f"Logger {p}"
+        csv_file = logger_params.get("csv_file", "output/log_data.csv")
+        if csv_file and len(parts) > 1:
+            csv_file = csv_file.replace(".csv", f"_{p}.csv")
+        node_log = sst.Component(name, "deadlocklog.log")
+        params = dict(logger_params)
+        params.update(
+            {
+                "num_nodes": f"{len(segment)}",
+                "first_node": f"{segment.start}",
+                "total_nodes": f"{num_nodes}",
+                "log_mode": log_mode,
+                "log_delay": log_latency,
+                "csv_file": csv_file,
+            }
+        )
+        node_log.addParams(params)
+        loggers.append(node_log)
+
+        for i, x in enumerate(segment):
+            sst.Link(f"Log_Link_{x}").connect(
+                (node_log, f"port{i}", log_latency),
+                (nodes[x], "logPort", log_latency),
+            )
+
+        # Pin the segment and its logger to one rank/thread.
+        if partitioned:
+            rank, thread = divmod(p, threads)
+            node_log.setRank(rank, thread)
+            for x in segment:
+                nodes[x].setRank(rank, thread)
+
+    build_summary_tree(loggers, reduce_fanin, link_latency)
+    return nodes, loggers
+
+
+# Node parameters that a segment takes as one list per segment, and the list's name.
+SEGMENT_ARRAYS = {
+    "queueMaxSize": "queue_sizes",
+    "tickFreq": "tick_freqs",
+    "message_gen": "message_gens",
+    "randseed": "randseeds",
+}
+
+
+def build_segments(
+    num_nodes: int,
+    node_params: Callable[[int], Dict[str, str]],
+    logger_params: Dict[str, str],
+    link_latency: str = "1ms",
+    log_latency: str = "1ps",
+    partitioned: bool = True,
+    reduce_fanin: int = 0,
+) -> Tuple[List[Any], List[Any]]:
+    """
+    Build the same ring as build_ring out of deadlocklog.segment components.
+
+    Each partition gets one segment that runs all of its nodes, so the graph has one
+    segment, one logger and two links per partition instead of a component and up to
+    three links per node. The per-node parameters in SEGMENT_ARRAYS are passed as lists,
+    any other parameter is taken from node 0 and must be the same for every node.
+    Loggers receive their segment's records in batches on a single link ("log_mode"
+    "batch").
+
+    Snapshots, profiling and the shared telemetry table need build_ring.
+    reduce_fanin is as in build_ring.
+
+    Returns the list of segments and the list of loggers.
+    """
+    ranks, threads = partition_count()
+    parts = segments(num_nodes, ranks * threads if partitioned else 1)
+    if partitioned:
+        pin_partitions()
+
+    shared = dict(node_params(0))
+    arrays: Dict[str, List[str]] = {name: [] for name in SEGMENT_ARRAYS}
+    for x in range(num_nodes):
+        params = node_params(x)
+        for name in SEGMENT_ARRAYS:
+            if name in params:
+                arrays[name].append(params[name])
+
+    segs = []
+    loggers = []
+    for p, segment in enumerate(parts):
+        # One segment component from element deadlocklog (deadlocklog.segment).
+        seg = sst.Component(f"Segment {p}", "deadlocklog.segment")
+        params = {k: v for k, v in shared.items() if k not in SEGMENT_ARRAYS}
+        for name, values in arrays.items():
+            if values:
+                chunk = values[segment.start : segment.stop]
+                params[SEGMENT_ARRAYS[name]] = f"[{', '.join(chunk)}]"
+        params.update(
+            {
+                "first_node": f"{segment.start}",
+                "num_nodes": f"{len(segment)}",
+                "total_nodes": f"{num_nodes}",
+                "link_latency": link_latency,
+            }
+        )
+        seg.addParams(params)
+        segs.append(seg)
+
+        name = "Logger" if len(parts) == 1 else f"Logger {p}"
+        csv_file = logger_params.get("csv_file", "output/log_data.csv")
+        if csv_file and len(parts) > 1:
+            csv_file = csv_file.replace(".csv", f"_{p}.csv")
+        node_log = sst.Component(name, "deadlocklog.log")
+        params = dict(logger_params)
+        params.update(
+            {
+                "num_nodes": f"{len(segment)}",
+                "first_node": f"{segment.start}",
+                "total_nodes": f"{num_nodes}",
+                "log_mode": "batch",
+                "log_delay": log_latency,
+                "csv_file": csv_file,
+            }
+        )
+        node_log.addParams(params)
+        loggers.append(node_log)
+
+        sst.Link(f"Log_Link_{p}").connect(
+            (node_log, "port0", log_latency), (seg, "logPort", log_latency)
+        )
+
+        if partitioned:
+            rank, thread = divmod(p, threads)
+            node_log.setRank(rank, thread)
+            seg.setRank(rank, thread)
+
+    # Connect the segments in a ring. A single segment is linked to itself.
+    for p in range(len(segs)):
+        sst.Link(f"Link_{p}").connect(
+            (segs[p], "nextPort", link_latency),
+            (segs[(p + 1) % len(segs)], "prevPort", link_latency),
+        )
+
+    build_summary_tree(loggers, reduce_fanin, link_latency)
+    return segs, loggers
+
+
+def build_summary_tree(loggers: List[Any], fanin: int, latency: str) -> None:
+    """
+    Connect the loggers in a tree of summary links, with up to fanin children each.
+
+    Logger p reports to logger (p - 1) // fanin, so logger 0 is the root and decides on
+    deadlock for the whole ring. A logger sends its parent the summary of its segment
+    and subtree only when it changes, and the root sends its verdict back down. The
+    links get the ring link latency, which they add to the detection latency once per
+    level, so they do not lower SST's lookahead. Does nothing for fewer than two
+    loggers.
+    """
+    if fanin < 1 or len(loggers) < 2:
+        return
+    depth = [0] * len(loggers)
+    children = [0] * len(loggers)
+    for p in range(1, len(loggers)):
+        parent = (p - 1) // fanin
+        depth[p] = depth[parent] + 1
+        sst.Link(f"Summary_Link_{p}").connect(
+            (loggers[parent], f"child{children[parent]}", latency),
+            (loggers[p], "parent", latency),
+        )
+        children[parent] += 1
+    for p, node_log in enumerate(loggers):
+        node_log.addParams(
+            {
+                "reduce_children": f"{children[p]}",
+                "reduce_latency": latency,
+                "reduce_depth": f"{max(depth)}",
+            }
+        )
+
+
+# Statistic output modules for the formats accepted by enable_statistics.
+STAT_OUTPUTS = {
+    "csv": ("sst.statOutputCSV", "output/stats.csv"),
+    "json": ("sst.statOutputJSON", "output/stats.json"),
+    "hdf5": ("sst.statOutputHDF5", "output/stats.h5"),
+}
+
+
+def enable_statistics(fmt: str = "csv", rate: str = "0ns") -> None:
+    """
+    Collect the node and logger statistics and write them through SST's buffered outputs.
+
+    Counters are accumulated (sum, sum of squares, min, max, count), except queue
+    occupancy and idle times, which are binned into histograms instead: a statistic
+    takes one type, so the histogram replaces their accumulator. rate "0ns" reports once
+    at the end of the run, any other time reports periodically.
+    """
+    module, path = STAT_OUTPUTS[fmt]
+    sst.setStatisticLoadLevel(1)
+    sst.setStatisticOutput(module, {"filepath": path})
+
+    accumulator = {"type": "sst.AccumulatorStatistic", "rate": rate}
+    sst.enableAllStatisticsForComponentType("deadlocklog.node", accumulator)
+    sst.enableAllStatisticsForComponentType("deadlocklog.segment", accumulator)
+    sst.enableAllStatisticsForComponentType("deadlocklog.log", accumulator)
+
+    # Enabling a statistic again replaces its accumulator with the histogram.
+    histogram = {
+        "type": "sst.HistogramStatistic",
+        "rate": rate,
+        "minvalue": "0",
+        "binwidth": "10",
+        "numbins": "20",
+    }
+    sst.enableStatisticForComponentType("deadlocklog.node", "queue_occupancy", histogram)
+    sst.enableStatisticForComponentType(
+        "deadlocklog.segment", "queue_occupancy", histogram
+    )
+    sst.enableStatisticForComponentType("deadlocklog.log", "idle_time", histogram)
@@ -0,0 +1,10 @@
+# Reference: http://sst-simulator.org/SSTPages/SSTUserPythonFileFormat/
+#
+# Round trips every event type through SST's serializer, see wirecheck.h. The run ends
+# right away and fails if an event comes back changed.
+#
+# Usage: sst tests/wirecheck.py
+
+import sst  # Use SST Library
+
+sst.Component("Wire Check", "deadlocklog.wirecheck").addParams({"verbose": "1"})
@@ -0,0 +1,57 @@
+# Construction time and memory per node of tests/deadlockring.py.
+#
+# Runs sst in init mode (build the graph, construct every component, run init, no
+# simulation) for both builders of tests/ringlib.py at a few ring sizes and reports the
+# wall time and the peak resident set size of each run. Bytes per node are the growth of
+# the peak over a 3 node ring, divided by the extra nodes.
+#
+# Usage:
+#   python3 tools/buildbench.py --nodes 1000,10000,100000
+#   python3 tools/buildbench.py --nodes 100000 --builders segments
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+from typing import List, Tuple
+
+DRIVER = "tests/deadlockring.py"
+BASE_NODES = 3  # Ring size whose peak memory is taken as the fixed cost.
+
+
+def run(nodes: int, builder: str) -> Tuple[float, int]:
+    """Construct one ring. Returns wall time in seconds and peak RSS in bytes."""
+    options = f"--nodes {nodes} --builder {builder} --quiet"
+    cmd = ["sst", "--run-mode", "init", DRIVER, f"--model-options={options}"]
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    out = proc.stdout.read() if proc.stdout else b""
+    _, status, usage = os.wait4(proc.pid, 0)
+    wall = time.perf_counter() - start
+    if status != 0:
+        sys.exit(f"{' '.join(cmd)} failed:\n{out.decode(errors='replace')}")
+    # ru_maxrss is in KB on Linux.
+    return wall, usage.ru_maxrss * 1024
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--nodes", default="1000,10000,100000", help="Ring sizes to build.")
+    parser.add_argument(
+        "--builders", default="nodes,segments", help="Builders of tests/ringlib.py to compare."
+    )
+    args = parser.parse_args()
+
+    sizes: List[int] = [int(n) for n in args.nodes.split(",")]
+    print(f"{'builder':>9} {'nodes':>8} {'wall (s)':>10} {'peak (MB)':>10} {'bytes/node':>11}")
+    for builder in args.builders.split(","):
+        _, base = run(BASE_NODES, builder)
+        for nodes in sizes:
+            wall, peak = run(nodes, builder)
+            per_node = (peak - base) / (nodes - BASE_NODES)
+            print(f"{builder:>9} {nodes:>8} {wall:>10.3f} {peak / 2**20:>10.1f} {per_node:>11.0f}")
+
+
+if __name__ == "__main__":
+    main()
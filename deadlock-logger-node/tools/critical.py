@@ -0,0 +1,286 @@
+# Critical point search of tests/deadlockring.py.
+#
+# For every configuration of the fixed parameters, bisects one parameter (message_gen by
+# default, or the queue size or the link latency) for the value where the ring starts to
+# deadlock within the --stop-at horizon. Every probe runs replicated simulations with
+# randseed seed + k on a shared pool of sst processes and counts as deadlocking when at
+# least --target of them deadlock. Replicates stop being launched once the Wilson
+# interval of the probe is on one side of --target. The bracket of every configuration
+# goes to a phase boundary table.
+#
+# One of --gen, --queue and --link is a range lo:hi to bisect, the others are comma
+# separated lists of values to sweep. Without --queue every node keeps its random size.
+#
+# Usage:
+#   python3 tools/critical.py --nodes 3 --gen 0.05:1 --link 1ms,2ms,4ms
+#   python3 tools/critical.py --nodes 3 --gen 0.9 --queue 10:200 --csv output/queue.csv
+
+import argparse
+import csv
+import itertools
+import math
+import os
+import re
+import statistics
+import sys
+import threading
+from concurrent.futures import FIRST_COMPLETED, Future, ThreadPoolExecutor, wait
+from typing import Any, Dict, List, NamedTuple, Optional, Set, Tuple
+
+from montecarlo import DRIVER, UNITS, Result, run, wilson
+
+AXES = ["gen", "queue", "link"]
+TIME = re.compile(r"([0-9.eE+-]+) *([munpf]?s)")
+
+
+class Probe(NamedTuple):
+    """Replicated runs at one value of the bisected parameter."""
+
+    value: float
+    runs: int
+    deadlocked: int
+
+    @property
+    def probability(self) -> float:
+        return self.deadlocked / self.runs
+
+
+def parse_time(text: str) -> float:
+    """Time with a unit, for example 1ms, in s."""
+    match = TIME.fullmatch(text.strip())
+    if not match:
+        raise argparse.ArgumentTypeError(f"bad time {text}")
+    return float(match.group(1)) * UNITS[match.group(2)]
+
+
+def parse_axis(axis: str, text: str) -> Tuple[bool, List[float]]:
+    """Whether the axis is a range lo:hi to bisect, and its values."""
+    parse = parse_time if axis == "link" else float
+    if ":" in text:
+        lo, hi = (parse(v) for v in text.split(":"))
+        return True, [min(lo, hi), max(lo, hi)]
+    return False, [parse(v) for v in text.split(",")]
+
+
+def model_value(axis: str, value: float) -> str:
+    """Value of an axis as passed to the driver."""
+    if axis == "queue":
+        return f"{round(value)}"
+    if axis == "link":
+        return f"{round(value * 1e12)}ps"
+    return f"{value:.6g}"
+
+
+def sst_command(
+    args: argparse.Namespace, config: Dict[str, Optional[float]], randseed: int
+) -> List[str]:
+    """Command line of one replicate."""
+    options = f"--nodes {args.nodes} --seed {args.seed} --randseed {randseed} --quiet"
+    flags = {"gen": "--message-gen", "queue": "--queue-size", "link": "--link-latency"}
+    for axis, value in config.items():
+        if value is not None:
+            options += f" {flags[axis]} {model_value(axis, value)}"
+    return ["sst", "--stop-at", args.stop_at, DRIVER, f"--model-options={options}"]
+
+
+class Search:
+    """Bisection of one configuration. Probes run their replicates on a shared pool."""
+
+    def __init__(
+        self,
+        args: argparse.Namespace,
+        pool: ThreadPoolExecutor,
+        axis: str,
+        config: Dict[str, Optional[float]],
+    ) -> None:
+        self.args = args
+        self.pool = pool
+        self.axis = axis
+        self.config = config
+        self.z = statistics.NormalDist().inv_cdf((1 + args.confidence) / 2)
+        self.probes: List[Probe] = []
+
+    def probe(self, value: float) -> Probe:
+        """Run replicates at value until the side of --target is known."""
+        config = dict(self.config, **{self.axis: value})
+        running: Set[Future] = set()
+        for k in range(self.args.replicates):
+            randseed = self.args.randseed + k
+            cmd = sst_command(self.args, config, randseed)
+            running.add(self.pool.submit(run, cmd, randseed))
+        results: List[Result] = []
+        while running:
+            done, running = wait(running, return_when=FIRST_COMPLETED)
+            for future in done:
+                if not future.cancelled():
+                    results.append(future.result())
+            deadlocked = sum(r.deadlocked for r in results)
+            low, high = wilson(deadlocked, len(results), self.z)
+            if len(results) >= self.args.min_runs and (
+                low >= self.args.target or high < self.args.target
+            ):
+                # Decided. Replicates that have not started are dropped, the ones
+                # already running still count.
+                for future in running:
+                    future.cancel()
+                results += [f.result() for f in running if not f.cancelled()]
+                break
+        probe = Probe(value, len(results), sum(r.deadlocked for r in results))
+        self.probes.append(probe)
+        return probe
+
+    def deadlocks(self, probe: Probe) -> bool:
+        return probe.probability >= self.args.target
+
+    def bisect(self, lo: float, hi: float) -> Dict[str, Any]:
+        """Bracket of the point where the probes change side, and the probes made."""
+        resolution = 1 if self.axis == "queue" else (hi - lo) / 2**self.args.steps
+        if self.axis == "queue":
+            lo, hi = round(lo), round(hi)
+        low, high = self.probe(lo), self.probe(hi)
+        if self.deadlocks(low) == self.deadlocks(high):
+            # No boundary in the range, both ends are on the same side.
+            outside = "deadlock" if self.deadlocks(low) else "no deadlock"
+            return self.row(low, high, outside)
+        while high.value - low.value > resolution:
+            mid = (low.value + high.value) / 2
+            if self.axis == "queue":
+                mid = math.floor(mid)
+            probe = self.probe(mid)
+            if self.deadlocks(probe) == self.deadlocks(low):
+                low = probe
+            else:
+                high = probe
+        return self.row(low, high, "")
+
+    def row(self, low: Probe, high: Probe, outside: str) -> Dict[str, Any]:
+        """Table row of the bracket [low, high]."""
+        row: Dict[str, Any] = {
+            axis: "random" if value is None else model_value(axis, value)
+            for axis, value in self.config.items()
+        }
+        row.update(
+            {
+                "bisected": self.axis,
+                "low": model_value(self.axis, low.value),
+                "high": model_value(self.axis, high.value),
+                "p_low": f"{low.probability:.3f}",
+                "p_high": f"{high.probability:.3f}",
+                "critical": ""
+                if outside
+                else model_value(self.axis, (low.value + high.value) / 2),
+                "outside": outside,
+                "probes": len(self.probes),
+                "runs": sum(p.runs for p in self.probes),
+            }
+        )
+        return row
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(
+        description="Bisect for the critical point of the deadlock ring."
+    )
+    parser.add_argument("--nodes", type=int, default=3, help="Ring size.")
+    parser.add_argument(
+        "--gen", default="0.05:1", help="message_gen values, or the range to bisect."
+    )
+    parser.add_argument(
+        "--queue",
+        default="",
+        help="Queue sizes, or the range to bisect. Random per node if not given.",
+    )
+    parser.add_argument(
+        "--link", default="1ms", help="Ring link latencies, or the range to bisect."
+    )
+    parser.add_argument(
+        "--seed", type=int, default=1234, help="Seed for the node parameters."
+    )
+    parser.add_argument(
+        "--randseed", type=int, default=121212, help="Generator seed of replicate 0."
+    )
+    parser.add_argument(
+        "--stop-at",
+        default="10s",
+        help="Simulated time after which a run counts as no deadlock.",
+    )
+    parser.add_argument(
+        "--replicates", type=int, default=20, help="Maximum runs per probe."
+    )
+    parser.add_argument(
+        "--min-runs",
+        type=int,
+        default=5,
+        help="Runs per probe before its side of --target is checked.",
+    )
+    parser.add_argument(
+        "--target",
+        type=float,
+        default=0.5,
+        help="Deadlock probability that marks the critical point.",
+    )
+    parser.add_argument(
+        "--confidence", type=float, default=0.95, help="Confidence level."
+    )
+    parser.add_argument(
+        "--steps",
+        type=int,
+        default=6,
+        help="Bisection steps of message_gen and link ranges. Queue sizes go to 1.",
+    )
+    parser.add_argument(
+        "--workers",
+        type=int,
+        default=os.cpu_count() or 1,
+        help="Simulations run at once.",
+    )
+    parser.add_argument(
+        "--csv", default="output/critical.csv", help="Phase boundary table."
+    )
+    args = parser.parse_args()
+
+    axes: Dict[str, List[Optional[float]]] = {}
+    bisected = []
+    for axis in AXES:
+        text = getattr(args, axis)
+        if not text:
+            axes[axis] = [None]
+            continue
+        is_range, values = parse_axis(axis, text)
+        axes[axis] = list(values)
+        if is_range:
+            bisected.append(axis)
+    if len(bisected) != 1:
+        sys.exit("Exactly one of --gen, --queue and --link must be a range lo:hi")
+    axis = bisected[0]
+    lo, hi = axes.pop(axis)
+
+    configs = [
+        dict(zip(axes, values)) for values in itertools.product(*axes.values())
+    ]
+    rows: List[Dict[str, Any]] = [{} for _ in configs]
+    lock = threading.Lock()
+
+    def search(i: int) -> None:
+        rows[i] = Search(args, pool, axis, configs[i]).bisect(lo, hi)
+        with lock:
+            print(", ".join(f"{k} {v}" for k, v in rows[i].items()), flush=True)
+
+    # Every configuration bisects in its own thread. They share one pool of sst runs,
+    # so the workers stay busy while a search waits on its probe.
+    with ThreadPoolExecutor(max_workers=args.workers) as pool:
+        with ThreadPoolExecutor(max_workers=len(configs)) as searches:
+            for future in [searches.submit(search, i) for i in range(len(configs))]:
+                future.result()
+
+    if args.csv:
+        os.makedirs(os.path.dirname(args.csv) or ".", exist_ok=True)
+        with open(args.csv, "w", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=list(rows[0]))
+            writer.writeheader()
+            writer.writerows(rows)
+    print(f"{len(rows)} configurations, {sum(r['runs'] for r in rows)} runs")
+
+
+if __name__ == "__main__":
+    main()
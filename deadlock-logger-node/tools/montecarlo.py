@@ -0,0 +1,261 @@
+# Monte Carlo ensemble of tests/deadlockring.py runs.
+#
+# Launches seeded simulations on a local worker pool, one sst process per core by
+# default. Run k uses seed + k for the node parameters and the message generators.
+# Each run's deadlock time, detecting logger, whether it settled into a steady state
+# and the message counts printed in the nodes' finish() are collected into one summary
+# with confidence intervals. Runs stop being launched once the estimates are within the
+# requested error.
+#
+# Usage:
+#   python3 tools/montecarlo.py --nodes 3 --runs 1000
+#   python3 tools/montecarlo.py --nodes 30 --rel-error 0.01 --json output/mc.json
+
+import argparse
+import json
+import math
+import os
+import re
+import statistics
+import subprocess
+import sys
+import time
+from concurrent.futures import FIRST_COMPLETED, Future, ThreadPoolExecutor, wait
+from typing import Any, Dict, List, NamedTuple, Set, Tuple
+
+DRIVER = "tests/deadlockring.py"
+
+DEADLOCK = re.compile(r"deadlocksim-(.+?)->.*Detected Deadlock")
+STEADY = re.compile(r"Steady state at")
+END_TIME = re.compile(
+    r"Simulation is complete, simulated time: ([0-9.eE+-]+) *([munpf]?s)"
+)
+COUNTS = re.compile(
+    r"Messages generated (\d+) \| forwarded (\d+) \| consumed (\d+) \| dropped (\d+)"
+)
+COUNT_NAMES = ["generated", "forwarded", "consumed", "dropped"]
+UNITS = {"s": 1.0, "ms": 1e-3, "us": 1e-6, "ns": 1e-9, "ps": 1e-12, "fs": 1e-15}
+
+
+class Result(NamedTuple):
+    """Outcome of one simulation."""
+
+    seed: int
+    deadlocked: bool
+    time: float  # Simulated end time in s. The deadlock time if deadlocked.
+    detector: str  # Logger that declared deadlock, empty if none did.
+    steady: bool  # A logger found the ring in a steady state.
+    counts: Dict[str, int]  # Message counts summed over the nodes.
+
+
+def sst_command(args: argparse.Namespace, seed: int) -> List[str]:
+    """Build the command line of the run with this seed."""
+    options = f"--nodes {args.nodes} --randseed {seed} --quiet"
+    options += f" --seed {args.seed if args.fixed_params else seed}"
+    return ["sst", "--stop-at", args.stop_at, DRIVER, f"--model-options={options}"]
+
+
+def run(cmd: List[str], seed: int) -> Result:
+    """Run one simulation and parse its output."""
+    result = subprocess.run(
+        cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True
+    )
+    if result.returncode != 0:
+        raise RuntimeError(f"{' '.join(cmd)} failed:\n{result.stdout}")
+    detector = DEADLOCK.search(result.stdout)
+    end = END_TIME.search(result.stdout)
+    counts = dict.fromkeys(COUNT_NAMES, 0)
+    for match in COUNTS.finditer(result.stdout):
+        for name, value in zip(COUNT_NAMES, match.groups()):
+            counts[name] += int(value)
+    return Result(
+        seed,
+        detector is not None,
+        float(end.group(1)) * UNITS[end.group(2)] if end else math.nan,
+        detector.group(1) if detector else "",
+        STEADY.search(result.stdout) is not None,
+        counts,
+    )
+
+
+def mean_ci(values: List[float], z: float) -> Tuple[float, float]:
+    """Mean and half width of its normal confidence interval."""
+    mean = statistics.fmean(values)
+    if len(values) < 2:
+        return mean, math.inf
+    return mean, z * statistics.stdev(values) / math.sqrt(len(values))
+
+
+def wilson(k: int, n: int, z: float) -> Tuple[float, float]:
+    """Wilson score interval of a proportion k/n."""
+    p = k / n
+    center = (p + z * z / (2 * n)) / (1 + z * z / n)
+    half = z * math.sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / (1 + z * z / n)
+    return center - half, center + half
+
+
+def converged(results: List[Result], args: argparse.Namespace, z: float) -> bool:
+    """Whether the deadlock probability and mean deadlock time are precise enough."""
+    n = len(results)
+    if n < args.min_runs:
+        return False
+    times = [r.time for r in results if r.deadlocked]
+    low, high = wilson(len(times), n, z)
+    if (high - low) / 2 > args.prob_error:
+        return False
+    if len(times) < 2:
+        return True
+    mean, half = mean_ci(times, z)
+    return half <= args.rel_error * mean
+
+
+def summarize(results: List[Result], z: float) -> Dict[str, Any]:
+    """Summary statistics of the runs."""
+    n = len(results)
+    times = sorted(r.time for r in results if r.deadlocked)
+    low, high = wilson(len(times), n, z)
+    summary: Dict[str, Any] = {
+        "runs": n,
+        "deadlocked": len(times),
+        "steady": sum(r.steady and not r.deadlocked for r in results),
+        "probability": [len(times) / n, low, high],
+        "detectors": {},
+        "messages": {},
+    }
+    for r in results:
+        if r.detector:
+            detectors = summary["detectors"]
+            detectors[r.detector] = detectors.get(r.detector, 0) + 1
+    if times:
+        mean, half = mean_ci(times, z)
+        summary["time"] = {
+            "mean": mean,
+            "ci": half,
+            "median": statistics.median(times),
+            "min": times[0],
+            "max": times[-1],
+        }
+    for name in COUNT_NAMES:
+        mean, half = mean_ci([float(r.counts[name]) for r in results], z)
+        summary["messages"][name] = {"mean": mean, "ci": half}
+    return summary
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(
+        description="Monte Carlo ensemble of deadlock runs."
+    )
+    parser.add_argument("--nodes", type=int, default=3, help="Ring size.")
+    parser.add_argument(
+        "--runs", type=int, default=1000, help="Maximum number of runs."
+    )
+    parser.add_argument("--seed", type=int, default=1234, help="Seed of the first run.")
+    parser.add_argument(
+        "--fixed-params",
+        action="store_true",
+        help="Keep the node parameters of --seed and only vary the message generators.",
+    )
+    parser.add_argument(
+        "--stop-at",
+        default="100s",
+        help="Simulated time after which a run counts as no deadlock.",
+    )
+    parser.add_argument(
+        "--workers",
+        type=int,
+        default=os.cpu_count() or 1,
+        help="Simulations run at once.",
+    )
+    parser.add_argument(
+        "--confidence", type=float, default=0.95, help="Confidence level."
+    )
+    parser.add_argument(
+        "--rel-error",
+        type=float,
+        default=0.02,
+        help="Stop once the CI half width of the mean deadlock time is this fraction"
+        " of the mean.",
+    )
+    parser.add_argument(
+        "--prob-error",
+        type=float,
+        default=0.02,
+        help="Stop once the CI half width of the deadlock probability is below this.",
+    )
+    parser.add_argument(
+        "--min-runs", type=int, default=30, help="Runs before convergence is checked."
+    )
+    parser.add_argument(
+        "--json", default="", help="Write the summary and every run to this file."
+    )
+    args = parser.parse_args()
+
+    z = statistics.NormalDist().inv_cdf((1 + args.confidence) / 2)
+    results: List[Result] = []
+    start = time.perf_counter()
+    launched = 0
+    stopped_early = False
+    with ThreadPoolExecutor(max_workers=args.workers) as pool:
+        running: Set[Future] = set()
+        while launched < args.runs or running:
+            # Keep every worker busy until the estimate converges.
+            while (
+                launched < args.runs
+                and len(running) < args.workers
+                and not stopped_early
+            ):
+                seed = args.seed + launched
+                running.add(pool.submit(run, sst_command(args, seed), seed))
+                launched += 1
+            if not running:
+                break
+            done, running = wait(running, return_when=FIRST_COMPLETED)
+            for future in done:
+                try:
+                    results.append(future.result())
+                except RuntimeError as e:
+                    sys.exit(str(e))
+            if not stopped_early and converged(results, args, z):
+                stopped_early = len(results) < args.runs
+
+    wall = time.perf_counter() - start
+    results.sort(key=lambda r: r.seed)
+    summary = summarize(results, z)
+    level = f"{args.confidence * 100:g}% CI"
+
+    print(
+        f"Runs {summary['runs']}"
+        + (" (stopped early, estimate converged)" if stopped_early else "")
+        + f" | workers {args.workers} | wall {wall:.1f} s"
+    )
+    p, low, high = summary["probability"]
+    print(
+        f"Deadlocked {summary['deadlocked']}/{summary['runs']} before {args.stop_at}"
+        f" | p = {p:.3f} [{low:.3f}, {high:.3f}] ({level})"
+    )
+    if summary["steady"]:
+        print(f"Ended in a steady state without deadlock {summary['steady']}")
+    if "time" in summary:
+        t = summary["time"]
+        print(
+            f"Time to deadlock (s): mean {t['mean']:.4f} +- {t['ci']:.4f} ({level})"
+            f" | median {t['median']:.4f} | min {t['min']:.4f} | max {t['max']:.4f}"
+        )
+    for detector, count in sorted(summary["detectors"].items()):
+        print(f"Detected by {detector}: {count}")
+    print(
+        "Messages per run: "
+        + " | ".join(
+            f"{name} {m['mean']:.1f} +- {m['ci']:.1f}"
+            for name, m in summary["messages"].items()
+        )
+    )
+
+    if args.json:
+        with open(args.json, "w") as f:
+            runs = [r._asdict() for r in results]
+            json.dump({"summary": summary, "runs": runs}, f, indent=1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,43 @@
+# Merge the per-rank profiles of a multi-rank run into output/profile.json.
+#
+# Each rank writes output/profile-<rank>.json when the components run with the profile
+# parameter set. A single rank run writes output/profile.json directly.
+#
+# Usage: python3 tools/profmerge.py output/profile-*.json
+
+import argparse
+import json
+from typing import Any, Dict, List
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Merge per-rank profiles.")
+    parser.add_argument("files", nargs="+", help="Per-rank profile files.")
+    parser.add_argument("--output", default="output/profile.json", help="Merged file.")
+    args = parser.parse_args()
+
+    totals: Dict[str, Dict[str, float]] = {}
+    components: List[Any] = []
+    for path in args.files:
+        with open(path) as f:
+            profile = json.load(f)
+        components.extend(profile["components"])
+        for name, t in profile["totals"].items():
+            merged = totals.setdefault(name, {"calls": 0, "total_ns": 0, "max_ns": 0})
+            merged["calls"] += t["calls"]
+            merged["total_ns"] += t["total_ns"]
+            merged["max_ns"] = max(merged["max_ns"], t["max_ns"])
+
+    with open(args.output, "w") as f:
+        json.dump({"totals": totals, "components": components}, f, indent=1)
+
+    for name, t in sorted(totals.items()):
+        mean = t["total_ns"] / t["calls"] if t["calls"] else 0
+        print(
+            f"{name:<22} {int(t['calls']):>12} calls {t['total_ns'] / 1e6:>12.3f} ms"
+            f" {mean:>10.0f} ns mean {t['max_ns']:>10.0f} ns max"
+        )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,117 @@
+# Decoder for the delivery records written with record_dir or ringsim --record.
+#
+# Every partition writes one stream, rank-<r>-thread-<t>.bin. The records of all given
+# streams are merged and printed in simulated time order, optionally only those of some
+# nodes. See Record.h for the format.
+#
+# Usage: python3 tools/recorddecode.py output/record/*.bin [--nodes 40:60]
+
+import argparse
+import struct
+import sys
+from typing import Iterator, List, Optional, Tuple
+
+# Must match RecordKinds and RecordPorts in Record.h.
+KINDS = ["message", "credit", "recovery", "end"]
+PORTS = ["prev", "next", "log"]
+POLICIES = ["drop", "reroute", "drain"]
+
+# Must match WireFormat.h.
+ID_BITS = 24
+FLAGS_SHIFT = 2 * ID_BITS + 1 + 3
+REVERSE_FLAG = 1
+TIME_FLAG = 2
+
+HEADER = struct.Struct("<4sIII")  # magic, version, rank, thread
+VERSION = 1
+
+Record = Tuple[int, int, int, int, int, int]  # time, node, kind, port, payload, extra
+
+
+def varint(data: bytes, pos: int) -> Tuple[int, int]:
+    """Read a LEB128 varint. Returns the value and the next position."""
+    value = shift = 0
+    while True:
+        if pos >= len(data):
+            raise EOFError
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def read(path: str) -> Iterator[Record]:
+    """Decode every complete record of one stream."""
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, version, _, _ = HEADER.unpack_from(data, 0)
+    if magic != b"DLRC" or version != VERSION:
+        sys.exit(f"{path} is not a record stream")
+    pos = HEADER.size
+    time = node = 0
+    try:
+        while pos < len(data):
+            dt, pos = varint(data, pos)
+            dn, pos = varint(data, pos)
+            tag = data[pos]
+            pos += 1
+            payload, pos = varint(data, pos)
+            kind, port = tag & 3, tag >> 2
+            extra = 0
+            timed = KINDS[kind] == "message" and (payload >> FLAGS_SHIFT) & TIME_FLAG
+            if KINDS[kind] == "recovery" or timed:
+                extra, pos = varint(data, pos)
+            time += dt
+            node += (dn >> 1) ^ -(dn & 1)
+            yield time, node, kind, port, payload, extra
+    except (EOFError, IndexError):
+        return  # Stream cut short, every complete record has been read.
+
+
+def describe(kind: int, payload: int, extra: int) -> str:
+    """Contents of a record."""
+    name = KINDS[kind]
+    if name == "message":
+        mask = (1 << ID_BITS) - 1
+        reverse = " reverse" if (payload >> FLAGS_SHIFT) & REVERSE_FLAG else ""
+        born = f" born={extra}" if (payload >> FLAGS_SHIFT) & TIME_FLAG else ""
+        source, dest = payload & mask, (payload >> ID_BITS) & mask
+        return f"source={source} dest={dest}{reverse}{born}"
+    if name == "credit":
+        return f"credits={payload >> 1}{' reverse' if payload & 1 else ''}"
+    if name == "recovery":
+        return f"policy={POLICIES[payload]} messages={extra}"
+    return ""
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Decode delivery records.")
+    parser.add_argument("files", nargs="+", help="Record streams to merge.")
+    parser.add_argument("--nodes", default="", help="Only nodes first:last.")
+    args = parser.parse_args()
+
+    window: Optional[Tuple[int, int]] = None
+    if args.nodes:
+        first, last = args.nodes.split(":")
+        window = (int(first), int(last))
+
+    records: List[Record] = []
+    for path in args.files:
+        for r in read(path):
+            if KINDS[r[2]] == "end" or window is None or window[0] <= r[1] <= window[1]:
+                records.append(r)
+
+    # Stable sort keeps each stream's records in recorded order within a time step.
+    records.sort(key=lambda r: r[0])
+    for time, node, kind, port, payload, extra in records:
+        if KINDS[kind] == "end":
+            print(f"{time:>16} end of stream")
+            continue
+        text = describe(kind, payload, extra)
+        print(f"{time:>16} node {node:<6} {PORTS[port]:<4} {KINDS[kind]:<8} {text}")
+
+
+if __name__ == "__main__":
+    main()
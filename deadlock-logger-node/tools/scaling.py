@@ -0,0 +1,90 @@
+# Determinism check and strong/weak scaling runs for tests/deadlockring.py.
+#
+# Every partitioned run is compared against a serial reference run of the same ring:
+# the simulated time at which the run ended (deadlock detection) and every node's
+# final state printed in finish() must match exactly.
+#
+# Usage:
+#   python3 tools/scaling.py determinism --nodes 30 --parts 1,2,4
+#   python3 tools/scaling.py strong --nodes 1000 --parts 1,2,4,8
+#   python3 tools/scaling.py weak --nodes 250 --parts 1,2,4,8
+
+import argparse
+import re
+import subprocess
+import sys
+import time
+from typing import List, Tuple
+
+DRIVER = "tests/deadlockring.py"
+
+END_TIME = re.compile(r"Simulation is complete, simulated time: (.*)")
+FINAL_STATE = re.compile(r"(Final queue size|Top of queue|Messages generated)")
+
+
+def sst_command(nodes: int, ranks: int, threads: int, serial: bool) -> List[str]:
+    """Build the command line for one run of the driver."""
+    options = f"--nodes {nodes}" + (" --serial" if serial else "")
+    cmd = ["sst", "-n", f"{threads}", DRIVER, f"--model-options={options}"]
+    if ranks > 1:
+        cmd = ["mpirun", "-np", f"{ranks}"] + cmd
+    return cmd
+
+
+def run(cmd: List[str]) -> Tuple[float, str, List[str]]:
+    """Run a simulation. Returns wall time, simulated end time and the sorted final node states."""
+    start = time.perf_counter()
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    wall = time.perf_counter() - start
+    if result.returncode != 0:
+        sys.exit(f"{' '.join(cmd)} failed:\n{result.stdout}")
+    end = END_TIME.search(result.stdout)
+    states = sorted(l for l in result.stdout.splitlines() if FINAL_STATE.search(l))
+    return wall, end.group(1) if end else "", states
+
+
+def layouts(parts: int, use: str) -> List[Tuple[int, int]]:
+    """(ranks, threads) combinations to try for a partition count."""
+    if use == "ranks":
+        return [(parts, 1)]
+    if use == "threads":
+        return [(1, parts)]
+    return [(parts, 1), (1, parts)]
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("mode", choices=["determinism", "strong", "weak"])
+    parser.add_argument(
+        "--nodes", type=int, default=30, help="Ring size (per partition for weak scaling)."
+    )
+    parser.add_argument("--parts", default="1,2,4", help="Partition counts to run.")
+    parser.add_argument(
+        "--use",
+        choices=["ranks", "threads", "both"],
+        default="both",
+        help="Partition with MPI ranks (mpirun -np), threads (sst -n) or both.",
+    )
+    args = parser.parse_args()
+
+    print(f"{'nodes':>8} {'ranks':>6} {'threads':>8} {'wall (s)':>10} {'speedup':>8}  end time")
+    failed = False
+    for parts in [int(p) for p in args.parts.split(",")]:
+        nodes = args.nodes * parts if args.mode == "weak" else args.nodes
+        ref_wall, ref_end, ref_states = run(sst_command(nodes, 1, 1, True))
+        print(f"{nodes:>8} {'serial':>6} {1:>8} {ref_wall:>10.3f} {1.0:>8.2f}  {ref_end}")
+        for ranks, threads in layouts(parts, args.use):
+            wall, end, states = run(sst_command(nodes, ranks, threads, False))
+            match = end == ref_end and states == ref_states
+            failed |= not match
+            print(
+                f"{nodes:>8} {ranks:>6} {threads:>8} {wall:>10.3f} {ref_wall / wall:>8.2f}  {end}"
+                + ("" if match else "  MISMATCH")
+            )
+
+    if failed:
+        sys.exit("Partitioned runs do not match the serial run.")
+
+
+if __name__ == "__main__":
+    main()
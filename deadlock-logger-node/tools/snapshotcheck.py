@@ -0,0 +1,67 @@
+# Snapshot and restore check for tests/deadlockring.py.
+#
+# Runs the ring uninterrupted up to --stop, runs it again taking a snapshot at
+# --snapshot-at, then restores the snapshot and runs the rest of the way. Every
+# node's final state printed in finish() must match the uninterrupted run, for the
+# run that took the snapshot as well as for the restored one.
+#
+# Usage:
+#   python3 tools/snapshotcheck.py --nodes 10 --snapshot-at 300 --stop 900
+
+import argparse
+import re
+import shutil
+import subprocess
+import sys
+from typing import List
+
+DRIVER = "tests/deadlockring.py"
+SNAPSHOT_DIR = "output/snapshot"
+
+FINAL_STATE = re.compile(r"(Final queue size|Top of queue|Messages generated)")
+
+
+def run(stop_ms: int, options: str) -> List[str]:
+    """Run a simulation up to stop_ms. Returns the sorted final node states."""
+    cmd = ["sst", f"--stop-at={stop_ms}ms", DRIVER, f"--model-options={options}"]
+    result = subprocess.run(
+        cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True
+    )
+    if result.returncode != 0:
+        sys.exit(f"{' '.join(cmd)} failed:\n{result.stdout}")
+    return sorted(l for l in result.stdout.splitlines() if FINAL_STATE.search(l))
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--nodes", type=int, default=10, help="Ring size.")
+    parser.add_argument(
+        "--snapshot-at",
+        type=int,
+        default=300,
+        help="Snapshot time in ms, a multiple of the tick period.",
+    )
+    parser.add_argument("--stop", type=int, default=900, help="End time in ms.")
+    args = parser.parse_args()
+    if not 0 < args.snapshot_at < args.stop:
+        parser.error("--snapshot-at must be between 0 and --stop")
+
+    options = f"--nodes {args.nodes}"
+    shutil.rmtree(SNAPSHOT_DIR, ignore_errors=True)
+    reference = run(args.stop, options)
+    snapshotted = run(args.stop, f"{options} --snapshot-at {args.snapshot_at}ms")
+    restored = run(
+        args.stop - args.snapshot_at, f"{options} --restore-from {SNAPSHOT_DIR}"
+    )
+
+    failed = False
+    for name, states in [("snapshot", snapshotted), ("restored", restored)]:
+        match = states == reference
+        failed |= not match
+        print(f"{name:>9}: {'match' if match else 'MISMATCH'}")
+    if failed:
+        sys.exit("Runs with a snapshot do not match the uninterrupted run.")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,70 @@
+# Live view of a run started with the logger's export_socket parameter.
+#
+# Connects to the socket (waiting for the run to open it), and prints one line per
+# sample: the monitored nodes that are blocked and stuck, the idle distribution and the
+# predictor state. --json passes the raw lines through for other tools. Ends when the
+# run closes the socket.
+#
+# Usage:
+#   sst tests/deadlockring.py \
+#       --model-options="--nodes 1000 --export-socket /tmp/deadlock.sock" &
+#   python3 tools/telemetrywatch.py /tmp/deadlock.sock
+
+import argparse
+import json
+import socket
+import sys
+import time
+
+
+def connect(path: str, wait: float) -> socket.socket:
+    """Connect to the export socket, retrying until it exists or wait seconds passed."""
+    deadline = time.monotonic() + wait
+    while True:
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            sock.connect(path)
+            return sock
+        except (FileNotFoundError, ConnectionRefusedError):
+            sock.close()
+            if time.monotonic() > deadline:
+                sys.exit(f"No export socket at {path}")
+            time.sleep(0.2)
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Watch the logger's live telemetry.")
+    parser.add_argument("socket", help="Path of the export socket.")
+    parser.add_argument("--json", action="store_true", help="Print the raw JSON lines.")
+    parser.add_argument(
+        "--wait", type=float, default=30, help="Seconds to wait for the run."
+    )
+    args = parser.parse_args()
+
+    with connect(args.socket, args.wait) as sock, sock.makefile() as lines:
+        for line in lines:
+            if args.json:
+                print(line, end="", flush=True)
+                continue
+            s = json.loads(line)
+            idle = s["idle"]
+            # Buckets hold 0, 1, 2-3, 4-7, ... cycles. Populated ones print lo+:count.
+            buckets = " ".join(
+                f"{(1 << (b - 1)) if b else 0}+:{n}"
+                for b, n in enumerate(idle["buckets"])
+                if n
+            )
+            state = "DEADLOCK" if s["deadlocked"] else s["predictor"]
+            print(
+                f"{s['time_ps'] / 1e9:>10.1f} ms  nodes {s['first_node']}+{s['nodes']}"
+                f"  blocked {s['blocked']:>5}  stuck {s['stuck']:>5}"
+                f"  queued {s['queued']:>7}"
+                f"  idle mean {idle['mean']:>7.1f} max {idle['max']:>6}"
+                f"  [{buckets}]"
+                f"  {state}  dropped {s['dropped']}",
+                flush=True,
+            )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,64 @@
+# Decoder for the binary trace files written by trace builds (make trace).
+#
+# Every node writes output/trace/node-<id>.bin at the end of the run. The records of all
+# given files are merged and printed in simulated time order.
+#
+# Usage: python3 tools/tracedecode.py output/trace/*.bin
+
+import argparse
+import struct
+import sys
+from typing import List, Tuple
+
+# Must match the TracePoint enum in Trace.h.
+POINTS = [
+    ("tick", "queue={a} credits={b} state={c}"),
+    ("counters", "idle={a}us blocked={b}us"),
+    ("msg_received", "source={a} dest={b}"),
+    ("msg_queued", "source={a} dest={b} queue={c}"),
+    ("msg_consumed", "source={a}"),
+    ("msg_dropped", "source={a} dest={b}"),
+    ("msg_generated", "dest={a}"),
+    ("msg_sent", "source={a} dest={b}"),
+    ("credits_sent", "credits={a}"),
+    ("log_sent", "idle={a}us state={b} blocked={c}us"),
+]
+
+HEADER = struct.Struct("<4sIQ")  # magic, id, record count
+RECORD = struct.Struct("<QHHiii")  # time, point, pad, a, b, c
+
+Record = Tuple[int, int, int, int, int, int]  # time, id, point, a, b, c
+
+
+def read(path: str) -> List[Record]:
+    """Read every record of one trace file."""
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, ident, count = HEADER.unpack_from(data, 0)
+    if magic != b"DLTR":
+        sys.exit(f"{path} is not a trace file")
+    records = []
+    for i in range(count):
+        time, point, _, a, b, c = RECORD.unpack_from(data, HEADER.size + i * RECORD.size)
+        records.append((time, ident, point, a, b, c))
+    return records
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Decode binary trace files.")
+    parser.add_argument("files", nargs="+", help="Trace files to merge.")
+    args = parser.parse_args()
+
+    records: List[Record] = []
+    for path in args.files:
+        records.extend(read(path))
+
+    # Stable sort keeps each node's records in recorded order within a time step.
+    records.sort(key=lambda r: r[0])
+    for time, ident, point, a, b, c in records:
+        name, fmt = POINTS[point] if point < len(POINTS) else (f"point{point}", "")
+        print(f"{time:>16} node {ident:<6} {name:<14} {fmt.format(a=a, b=b, c=c)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,86 @@
+/// \file
+#include <sst/core/sst_config.h>
+#include <algorithm>
+#include "wirecheck.h"
+
+wirecheck::wirecheck( SST::ComponentId_t id, SST::Params& params ) : SST::Component(id)
+{
+	output.init("deadlocksim-" + getName() + "->", params.find<int64_t>("verbose", 0), 0, SST::Output::STDOUT);
+	checked = 0;
+	size_t bytes;
+
+	// Messages at the limits of the header fields, with and without a generation time.
+	// A message generated at time 0 is timed too.
+	Message messages[] = {
+		{ 0, 0, SENDING, MESSAGE, FORWARD, UNTIMED },
+		{ (int)wire::MAX_NODES - 1, (int)wire::MAX_NODES - 1, WAITING, MESSAGE, REVERSE, UNTIMED },
+		{ 0, 1, SENDING, MESSAGE, FORWARD, 0 },
+		{ 12345, 67, SENDING, MESSAGE, REVERSE, 987654321987ULL },
+	};
+	size_t untimedBytes = 0;
+	for (const Message &m : messages) {
+		MessageEvent ev(m);
+		Message out = roundTrip(ev, bytes).msg;
+		check(out.source_id == m.source_id && out.dest_id == m.dest_id && out.status == m.status && out.type == m.type
+			&& out.direction == m.direction && out.born == m.born, "MessageEvent", bytes);
+		// Only timed messages carry the second word.
+		if (m.born == UNTIMED) {
+			untimedBytes = bytes;
+		} else {
+			check(bytes == untimedBytes + sizeof(m.born), "timed MessageEvent size", bytes);
+		}
+	}
+
+	CreditProbe probes[] = { { 0, FORWARD }, { 120, REVERSE }, { INT32_MAX >> 1, FORWARD } };
+	for (const CreditProbe &p : probes) {
+		CreditEvent ev(p);
+		CreditProbe out = roundTrip(ev, bytes).probe;
+		check(out.credits == p.credits && out.direction == p.direction, "CreditEvent", bytes);
+	}
+
+	// Records of a node that is blocked, one that is not, and one far into the run.
+	std::vector<Log> logs = {
+		{ 0, 0, NOT_BLOCKED, 0, 0, 0, 0, 0 },
+		{ 3000000000, 0, 5000000000, 41, 1, 17, 120, 9000000000 },
+		{ 1, 1, NOT_BLOCKED, (int)wire::MAX_NODES - 1, 0, INT32_MAX, INT32_MAX, UINT64_MAX >> 2 },
+	};
+	auto same = [](const Log &a, const Log &b) {
+		return a.idle_since == b.idle_since && a.node_status == b.node_status && a.blocked_since == b.blocked_since && a.node_id == b.node_id
+			&& a.stuck == b.stuck && a.delivered == b.delivered && a.queue_size == b.queue_size && a.time == b.time;
+	};
+	for (const Log &l : logs) {
+		LogEvent ev(l);
+		Log out = roundTrip(ev, bytes).log;
+		check(same(out, l), "LogEvent", bytes);
+	}
+	LogBatchEvent batch;
+	batch.logs = logs;
+	std::vector<Log> outLogs = roundTrip(batch, bytes).logs;
+	check(outLogs.size() == logs.size() && std::equal(logs.begin(), logs.end(), outLogs.begin(), same), "LogBatchEvent", bytes);
+
+	// A record cut short must be refused rather than read as zeros.
+	uint8_t buf[LOG_FIELDS * wire::MAX_VARINT_BYTES];
+	uint8_t len = packLog(logs[1], buf);
+	Log cut;
+	check(!unpackLog(buf, len - 1, cut), "truncated Log", len - 1);
+
+	Recovery recovery = { RECOVER_DRAIN, 5, 77 };
+	RecoveryEvent rev(recovery);
+	Recovery outRecovery = roundTrip(rev, bytes).recovery;
+	check(outRecovery.policy == recovery.policy && outRecovery.messages == recovery.messages && outRecovery.node_id == recovery.node_id, "RecoveryEvent", bytes);
+
+	Summary summary = { 250000000000, NOT_BLOCKED };
+	SummaryEvent sev(summary);
+	Summary outSummary = roundTrip(sev, bytes).summary;
+	check(outSummary.idle_since == summary.idle_since && outSummary.blocked_since == summary.blocked_since, "SummaryEvent", bytes);
+
+	output.output(CALL_INFO, "Wire format: %d round trips passed\n", checked);
+}
+
+void wirecheck::check( bool same, const char *what, size_t bytes ) {
+	checked++;
+	if (!same) {
+		output.fatal(CALL_INFO, -1, "%s changed in a round trip of %zu bytes\n", what, bytes);
+	}
+	output.verbose(CALL_INFO, 1, 0, "%s: %zu bytes\n", what, bytes);
+}
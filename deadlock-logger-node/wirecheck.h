@@ -0,0 +1,77 @@
+/// \file
+#ifndef _wirecheck_H
+#define _wirecheck_H
+
+#include <sst/core/component.h>
+#include <vector>
+#include "CommunicationEvents.h"
+
+/**
+ * @brief Wire format check. Runs every event type through its serialize_order with SST's
+ * serializer (sizing, packing, unpacking) and compares the result with the original, so
+ * the packed encodings of WireFormat.h are tested as they go over MPI. Has no ports and
+ * no clock; the run ends right after construction, or fails with a fatal error.
+ */
+class wirecheck : public SST::Component {
+
+public:
+	/**
+	 * @brief Construct the component and run the checks.
+	 * 
+	 * @param id Component ID tracked by the simulator.
+	 * @param params Parameters passed in via the Python driver file.
+	 */
+	wirecheck( SST::ComponentId_t id, SST::Params& params );
+
+	/**
+	 * Currently ignoring SST_ELI Macros as they break doxygen.
+	 * \cond
+	 */
+	SST_ELI_REGISTER_COMPONENT(
+		wirecheck, // class
+		"deadlocklog", // element library
+		"wirecheck", // component
+		SST_ELI_ELEMENT_VERSION( 1, 0, 0 ), // current element version
+		"round trips every event type of the model through SST's serializer.", // description of component.
+		COMPONENT_CATEGORY_UNCATEGORIZED // * Not grouped in a category. (No category to filter with via sst-info).
+	)
+
+	SST_ELI_DOCUMENT_PARAMS(
+		{"verbose", "Print every checked event.", "0"},
+	)
+	/**
+	 * \endcond
+	 */
+
+private:
+	/**
+	 * @brief Serialize an event and read it back into a new one, as a rank boundary does.
+	 * 
+	 * @param ev Event to send.
+	 * @param bytes Set to the serialized size.
+	 */
+	template <class E>
+	E roundTrip(E &ev, size_t &bytes) {
+		SST::Core::Serialization::serializer ser;
+		ser.start_sizing();
+		ev.serialize_order(ser);
+		std::vector<char> buf(ser.size());
+		ser.start_packing(buf.data(), buf.size());
+		ev.serialize_order(ser);
+		E out;
+		ser.start_unpacking(buf.data(), buf.size());
+		out.serialize_order(ser);
+		bytes = buf.size();
+		return out;
+	}
+
+	/**
+	 * @brief Fail the run if a round trip changed an event.
+	 */
+	void check(bool same, const char *what, size_t bytes);
+
+	SST::Output output; //!< SST Output object for printing to the console.
+	int checked; //!< Number of events checked.
+};
+
+#endif
@@ -2,6 +2,7 @@
 #ifndef communication_H
 #define communication_H
 #include <sst/core/event.h>
+#include "WireFormat.h"
 
 /**
  * @brief Enum for the type of messages in the simulation. 
@@ -10,6 +11,9 @@
 enum MessageTypes {
 	MESSAGE,	/**< Type for messages which are stored in a node's queue or consumed. */
 	STATUS,		/**< Type for messages which node's instantly pass along to determine if a system-deadlock has occured. */
+	ACK,		/**< Type for acknowledgements of reliable messages. Passed along instantly like STATUS, from the destination back to the source. */
+	RECOVER,	/**< Type for the initiator's order to the victim of a deadlock to free its queue. Passed along instantly like STATUS. */
+	ESCAPE,		/**< Type for a message rerouted by deadlock recovery. Passed along instantly like STATUS, outside the queues and credits, until its destination consumes it. */
 };
 
 /**
@@ -27,9 +31,12 @@ enum StatusTypes {
  */
 struct Message {
 	int source_id;	/**< ID for node that the message originates from. */
-	int dest_id;	/**< ID for node that the message is destined to. */
+	int dest_id;	/**< ID for node that the message is destined to. For a STATUS probe, the node with the oldest blocked message it passed. */
 	StatusTypes status;		/**< Status of node that passes the message along. Only used when the message type is STATUS.*/
 	MessageTypes type;		/**< Type of message. */
+	uint32_t seq;	/**< Sequence number per source of a reliable message, or of the message an ACK acknowledges. 0 if unreliable. */
+	int cls;		/**< Traffic class of a MESSAGE. */
+	uint64_t born;	/**< Simulation time the message was generated at, for its latency. For a STATUS probe, that of the oldest blocked message it passed. */
 };
 
 /**
@@ -38,6 +45,7 @@ struct Message {
  */
 struct CreditProbe {
 	int credits;	/**< Amount of free space in the node's queue. */
+	int cls;		/**< Traffic class of the queue. */
 };
 
 
@@ -51,15 +59,37 @@ public:
 		
 	/**
 	 * @brief Serialize members of the Message struct. 
+	 * All members are packed into one 64-bit word (see WireFormat.h), with the traffic
+	 * class among the flags, followed by the sequence number of reliable messages and the
+	 * creation time of timed ones.
 	 * 
 	 * @param ser Wrapper class for objects to declare the order in which their members are serialized/deserialized.
 	 */
 	void serialize_order(SST::Core::Serialization::serializer &ser) override {
 		Event::serialize_order(ser);
-		ser & msg.source_id;  
-		ser & msg.dest_id;
-		ser & msg.status;
-		ser & msg.type;
+		uint64_t word = 0;
+		uint32_t flags = 0;
+		if (ser.mode() != SST::Core::Serialization::serializer::UNPACK) {
+			flags = (msg.seq ? wire::SEQ_FLAG : 0) | (msg.born ? wire::TIME_FLAG : 0) | uint32_t(msg.cls) << wire::CLASS_SHIFT;
+			word = wire::packMessage(msg.source_id, msg.dest_id, msg.status, msg.type, flags);
+		}
+		ser & word;
+		if (ser.mode() == SST::Core::Serialization::serializer::UNPACK) {
+			msg.source_id = wire::sourceOf(word);
+			msg.dest_id = wire::destOf(word);
+			msg.status = (StatusTypes)wire::statusOf(word);
+			msg.type = (MessageTypes)wire::typeOf(word);
+			msg.seq = 0;
+			msg.born = 0;
+			flags = wire::flagsOf(word);
+			msg.cls = wire::classOf(flags);
+		}
+		if (flags & wire::SEQ_FLAG) {
+			ser & msg.seq;
+		}
+		if (flags & wire::TIME_FLAG) {
+			ser & msg.born;
+		}
 	}
 
 	
@@ -92,6 +122,7 @@ public:
 	void serialize_order(SST::Core::Serialization::serializer &ser) override {
 		Event::serialize_order(ser);
 		ser & probe.credits;
+		ser & probe.cls;
 	}
 
 	CreditEvent(CreditProbe probe) :
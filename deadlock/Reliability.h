@@ -0,0 +1,155 @@
+/// \file
+#ifndef reliability_H
+#define reliability_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Source side of the reliability layer. Holds the messages a node sent until
+ * their destination acknowledges them, and hands out the ones whose timeout expired.
+ *
+ * Sequence numbers start at 1 and increase by one per message, so the unacknowledged
+ * messages always span at most window consecutive numbers. The slots are allocated once
+ * by configure and reused by sequence number modulo the window. SST-free.
+ *
+ * @tparam Entry Message type, with a uint32_t member seq.
+ */
+template <class Entry>
+class RetransmitBuffer {
+
+public:
+	/**
+	 * @brief Allocate the slots. Must be called before any other member.
+	 *
+	 * @param window Most messages unacknowledged at once.
+	 */
+	void configure(int window) {
+		slots.assign(window, Slot());
+		base = 1;
+		next = 1;
+	}
+
+	/**
+	 * @brief Whether every slot holds an unacknowledged message.
+	 */
+	bool full() const { return next - base >= slots.size(); }
+
+	/**
+	 * @brief Number of messages waiting for their acknowledgement.
+	 */
+	int outstanding() const {
+		int n = 0;
+		for (uint32_t seq = base; seq != next; ++seq) {
+			n += at(seq).acked ? 0 : 1;
+		}
+		return n;
+	}
+
+	/**
+	 * @brief Give a message the next sequence number and keep it until acknowledged.
+	 * The buffer must not be full.
+	 *
+	 * @param msg Message to send. Its seq is set.
+	 * @param now Tick the message is sent at.
+	 */
+	void push(Entry &msg, uint64_t now) {
+		msg.seq = next++;
+		Slot &slot = at(msg.seq);
+		slot.msg = msg;
+		slot.sent = now;
+		slot.acked = false;
+	}
+
+	/**
+	 * @brief Release a message on its acknowledgement.
+	 *
+	 * @return false if seq is not waiting for one, e.g. the acknowledgement of a
+	 * retransmitted copy.
+	 */
+	bool ack(uint32_t seq) {
+		if (seq - base >= next - base || at(seq).acked) {
+			return false;
+		}
+		at(seq).acked = true;
+		while (base != next && at(base).acked) {
+			base++;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief The oldest unacknowledged message sent at least timeout ticks ago.
+	 *
+	 * @return nullptr if no timeout expired.
+	 */
+	const Entry *due(uint64_t now, uint64_t timeout) const {
+		for (uint32_t seq = base; seq != next; ++seq) {
+			const Slot &slot = at(seq);
+			if (!slot.acked && now - slot.sent >= timeout) {
+				return &slot.msg;
+			}
+		}
+		return nullptr;
+	}
+
+	/**
+	 * @brief Restart the timer of a message that was sent again.
+	 */
+	void resent(uint32_t seq, uint64_t now) { at(seq).sent = now; }
+
+private:
+	/**
+	 * @brief A sent message and when it was last sent.
+	 */
+	struct Slot {
+		Entry msg;		/**< Copy of the message. */
+		uint64_t sent;	/**< Tick of the last transmission. */
+		bool acked;		/**< Whether the acknowledgement arrived. */
+	};
+
+	Slot &at(uint32_t seq) { return slots[seq % slots.size()]; }
+	const Slot &at(uint32_t seq) const { return slots[seq % slots.size()]; }
+
+	std::vector<Slot> slots; //!< One slot per sequence number in the window.
+	uint32_t base = 1; //!< Oldest sequence number not acknowledged.
+	uint32_t next = 1; //!< Sequence number of the next message.
+};
+
+/**
+ * @brief Destination side of the reliability layer, per source. Tells first copies of a
+ * message from retransmitted duplicates.
+ *
+ * Keeps the lowest sequence number not received yet and a bitmap of the ones received
+ * above it. Since a source never has more than its window unacknowledged, nothing beyond
+ * 64 numbers above the lowest can arrive as long as the window is at most 64. SST-free.
+ */
+class ReceiveWindow {
+
+public:
+	static constexpr int MAX_WINDOW = 64; //!< Largest retransmit window the bitmap covers.
+
+	/**
+	 * @brief Record a received sequence number.
+	 *
+	 * @return true for the first copy, false for a duplicate.
+	 */
+	bool accept(uint32_t seq) {
+		uint32_t offset = seq - expected;
+		if (seq < expected || offset >= MAX_WINDOW || (received >> offset) & 1) {
+			return false;
+		}
+		received |= uint64_t(1) << offset;
+		while (received & 1) {
+			received >>= 1;
+			expected++;
+		}
+		return true;
+	}
+
+private:
+	uint32_t expected = 1; //!< Lowest sequence number not received yet.
+	uint64_t received = 0; //!< Bit k is set if expected + k was received.
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include <sst/core/sst_config.h>
 #include <sst/core/simulation.h>
 #include <sst/core/stopAction.h>
+#include <algorithm>
 #include "node.h"
 
 // Constructor definition
@@ -21,11 +22,161 @@ node::node(SST::ComponentId_t id, SST::Params &params) : SST::Component(id)
 	total_nodes = params.find<int64_t>("total_nodes", 5);
 	message_gen = params.find<float>("message_gen", 0.5);
 
+	// Steady state detection, so runs that never deadlock still end.
+	std::string steady_mode = params.find<std::string>("steady_state", "off");
+	if (steady_mode == "off")
+	{
+		steadyMode = STEADY_OFF;
+	}
+	else if (steady_mode == "report")
+	{
+		steadyMode = STEADY_REPORT;
+	}
+	else if (steady_mode == "end")
+	{
+		steadyMode = STEADY_END;
+	}
+	else
+	{
+		output.fatal(CALL_INFO, -1, "Unknown steady_state '%s', expected 'off', 'report' or 'end'\n", steady_mode.c_str());
+	}
+	steady.configure({0, params.find<double>("steady_queue_floor", 5)}, {true, false}, params.find<int64_t>("steady_batch", 500), params.find<int64_t>("steady_batches", 20), params.find<double>("steady_tolerance", 0.1));
+
+	// Deadlock recovery at the initiator instead of ending the simulation.
+	std::string recovery_mode = params.find<std::string>("recovery", "stop");
+	if (recovery_mode == "stop")
+	{
+		recoveryMode = RECOVER_STOP;
+	}
+	else if (recovery_mode == "drop")
+	{
+		recoveryMode = RECOVER_DROP;
+	}
+	else if (recovery_mode == "reroute")
+	{
+		recoveryMode = RECOVER_REROUTE;
+	}
+	else if (recovery_mode == "drain")
+	{
+		recoveryMode = RECOVER_DRAIN;
+	}
+	else
+	{
+		output.fatal(CALL_INFO, -1, "Unknown recovery '%s', expected 'stop', 'drop', 'reroute' or 'drain'\n", recovery_mode.c_str());
+	}
+	std::string recovery_victim = params.find<std::string>("recovery_victim", "oldest");
+	if (recovery_victim == "oldest")
+	{
+		recoveryVictim = VICTIM_OLDEST;
+	}
+	else if (recovery_victim == "initiator")
+	{
+		recoveryVictim = VICTIM_INITIATOR;
+	}
+	else
+	{
+		output.fatal(CALL_INFO, -1, "Unknown recovery_victim '%s', expected 'oldest' or 'initiator'\n", recovery_victim.c_str());
+	}
+	recoveryDrain = params.find<int64_t>("recovery_drain", 0);
+	recoveryHoldoff = params.find<int64_t>("recovery_holdoff", 10);
+
+	// Reliability layer: sequence numbers, acknowledgements and retransmission.
+	reliable = params.find<bool>("reliable", false);
+	retransmitWindow = params.find<int64_t>("retransmit_window", 16);
+	retransmitTimeout = params.find<int64_t>("retransmit_timeout", 200);
+	if (reliable && (retransmitWindow < 1 || retransmitWindow > ReceiveWindow::MAX_WINDOW))
+	{
+		output.fatal(CALL_INFO, -1, "retransmit_window %d must be between 1 and %d\n", retransmitWindow, ReceiveWindow::MAX_WINDOW);
+	}
+
+	// Traffic classes, each with its own queue and credits.
+	classes = params.find<int64_t>("classes", 1);
+	if (classes < 1 || classes > wire::MAX_CLASSES)
+	{
+		output.fatal(CALL_INFO, -1, "classes %d must be between 1 and %d\n", classes, wire::MAX_CLASSES);
+	}
+	classQueueSize.assign(classes, queueMaxSize);
+	classMix.assign(classes, 1);
+	classWeight.assign(classes, 1);
+	if (params.contains("class_queue_sizes"))
+	{
+		params.find_array<int>("class_queue_sizes", classQueueSize);
+	}
+	if (params.contains("class_mix"))
+	{
+		params.find_array<double>("class_mix", classMix);
+	}
+	if (params.contains("class_weights"))
+	{
+		params.find_array<int>("class_weights", classWeight);
+	}
+	if ((int)classQueueSize.size() != classes || (int)classMix.size() != classes || (int)classWeight.size() != classes)
+	{
+		output.fatal(CALL_INFO, -1, "class_queue_sizes, class_mix and class_weights need one value per class\n");
+	}
+	// Cumulative shares of the generated messages.
+	double mixTotal = 0;
+	for (double &share : classMix)
+	{
+		mixTotal += share;
+		share = mixTotal;
+	}
+	for (double &share : classMix)
+	{
+		share /= mixTotal;
+	}
+	std::string arbitration_mode = params.find<std::string>("arbitration", "priority");
+	if (arbitration_mode == "priority")
+	{
+		arbitration = ARBITRATE_PRIORITY;
+	}
+	else if (arbitration_mode == "wrr")
+	{
+		arbitration = ARBITRATE_WRR;
+	}
+	else
+	{
+		output.fatal(CALL_INFO, -1, "Unknown arbitration '%s', expected 'priority' or 'wrr'\n", arbitration_mode.c_str());
+	}
+
+	// Node IDs must fit the packed Message header.
+	if (total_nodes > wire::MAX_NODES)
+	{
+		output.fatal(CALL_INFO, -1, "total_nodes %d exceeds the %" PRId64 " nodes a Message can address\n", total_nodes, wire::MAX_NODES);
+	}
+
 	// Initialize Variables
 	queueCurrSize = 0;
-	queueCredits = 0;
+	msgqueue.resize(classes);
+	queueCredits.assign(classes, 0);
+	wrrClass = 0;
+	wrrLeft = 0;
+	classDelivered.assign(classes, 0);
+	classLatencySum.assign(classes, 0);
+	classLatencyMax.assign(classes, 0);
+	classSourceDropped.assign(classes, 0);
 	generated = 0;
 	rndNumber = 0;
+	delivered = 0;
+	lastDelivered = 0;
+	steadyReached = false;
+	currentTick = 0;
+	holdoffUntil = 0;
+	recoveringSince = -1;
+	deadlocks = 0;
+	recoveryCycles = 0;
+	recoveryDropped = 0;
+	recoveryRerouted = 0;
+	recoveryDrained = 0;
+	dropped = 0;
+	retransmits = 0;
+	duplicates = 0;
+	windowStalls = 0;
+	if (reliable)
+	{
+		retransmitBuffer.configure(retransmitWindow);
+		receiveWindows.resize(total_nodes);
+	}
 
 	// Initialize Random
 	rng = new SST::RNG::MarsagliaRNG(10, randSeed); // Create a Marsaglia RNG with a default value and a random seed.
@@ -72,8 +223,10 @@ void node::setup()
 {
 	output.verbose(CALL_INFO, 1, 0, "id %d initialized\n", node_id);
 
-	struct CreditProbe creds = {queueMaxSize - (int)msgqueue.size()};
-	prevPort->send(new CreditEvent(creds));
+	for (int c = 0; c < classes; ++c)
+	{
+		sendCredits(c);
+	}
 }
 
 // SST Finish Phase, called for each node when the simulation ends and before all nodes are cleaned up.
@@ -83,9 +236,42 @@ void node::setup()
  */
 void node::finish()
 {
-	output.verbose(CALL_INFO, 1, 0, "Final queue size is %ld | Max queue size is %d | Final credit size is %d\n", msgqueue.size(), queueMaxSize, queueCredits);
-	struct Message top = msgqueue.front();
-	output.verbose(CALL_INFO, 1, 0, "Top of queue: Dest_ID-%d\n", top.dest_id);
+	for (int c = 0; c < classes; ++c)
+	{
+		output.verbose(CALL_INFO, 1, 0, "Class %d final queue size is %ld | Max queue size is %d | Final credit size is %d\n", c, msgqueue[c].size(), classQueueSize[c], queueCredits[c]);
+		if (!msgqueue[c].empty())
+		{
+			output.verbose(CALL_INFO, 1, 0, "Top of queue: Dest_ID-%d\n", msgqueue[c].front().dest_id);
+		}
+	}
+	// Latencies are in simulation time units.
+	for (int c = 0; c < classes; ++c)
+	{
+		output.output(CALL_INFO, "Class %d delivered %" PRIu64 " | %.4f messages per tick | mean latency %.1f | max latency %" PRIu64 " | dropped at the source for credits %" PRIu64 "\n",
+			c, classDelivered[c], currentTick ? (double)classDelivered[c] / currentTick : 0.0, classDelivered[c] ? (double)classLatencySum[c] / classDelivered[c] : 0.0, classLatencyMax[c], classSourceDropped[c]);
+	}
+	if (recoveryMode != RECOVER_STOP)
+	{
+		output.output(CALL_INFO, "Delivered %.4f messages per tick\n", currentTick ? (double)delivered / currentTick : 0.0);
+	}
+	if (dropped > 0 || reliable)
+	{
+		output.output(CALL_INFO, "Dropped %" PRIu64 " messages to a full queue\n", dropped);
+	}
+	if (reliable)
+	{
+		output.output(CALL_INFO, "Retransmitted %" PRIu64 " | duplicates %" PRIu64 " | ticks with a full window %" PRIu64 " | unacknowledged %d\n", retransmits, duplicates, windowStalls, retransmitBuffer.outstanding());
+	}
+	if (deadlocks > 0)
+	{
+		output.output(CALL_INFO, "Deadlocks %" PRIu64 " | mean recovery time %.1f ticks | mean time between deadlocks %.1f ticks\n",
+			deadlocks, (double)recoveryCycles / deadlocks, (double)currentTick / deadlocks);
+	}
+	if (recoveryDropped + recoveryRerouted + recoveryDrained > 0)
+	{
+		output.output(CALL_INFO, "Recovered as the victim: dropped %" PRIu64 " | rerouted %" PRIu64 " | drained %" PRIu64 "\n",
+			recoveryDropped, recoveryRerouted, recoveryDrained);
+	}
 }
 
 // Runs every clock tick
@@ -97,45 +283,84 @@ bool node::tick(SST::Cycle_t currentCycle)
 		// output.verbose(CALL_INFO, 1, 0, "\n--------------------------Sim-Time: %lu--------------------------\n", getCurrentSimTime());
 		std::cout << "\n Sim-Time: " << getCurrentSimTime() << std::endl;
 	}
-	output.verbose(CALL_INFO, 2, 0, "Size of queue: %ld\n", msgqueue.size());
-	output.verbose(CALL_INFO, 2, 0, "Amount of credits: %d\n", queueCredits);
+	output.verbose(CALL_INFO, 2, 0, "Size of queue: %d\n", queuedMessages());
+	output.verbose(CALL_INFO, 2, 0, "Amount of credits: %d\n", queueCredits[0]);
+	currentTick = currentCycle;
+	bool credited = std::any_of(queueCredits.begin(), queueCredits.end(), [](int credits) { return credits > 0; });
+
+	// The initiator has credits again, the last deadlock is resolved.
+	if (recoveringSince >= 0 && credited)
+	{
+		recoveryCycles += currentCycle - recoveringSince;
+		recoveringSince = -1;
+	}
 
 	// Checking if no credits are available and if the node is the initiator.
-	if ( queueCredits <= 0 && node_id == 0) {
+	if ( !credited && node_id == 0) {
 		// If the node has no credits, it is idling. Send out a status message to check for deadlock.
 		output.verbose(CALL_INFO, 2, 0, "Status Check\n");
 
-		// Construct Status message.
+		// Construct Status message. It collects the node with the oldest blocked message on its way.
 		struct Message statusMsg = { node_id, node_id, WAITING, STATUS };
+		if (recoveryVictim == VICTIM_OLDEST)
+		{
+			int cls = oldestClass();
+			statusMsg.born = cls >= 0 ? msgqueue[cls].front().born : UINT64_MAX;
+		}
 		nextPort->send(new MessageEvent(statusMsg));
 	}
 
-	// Rng and generate message to send out.
-	if (queueCredits > 0)
+	// Messages drained by a deadlock recovery go out first and hold back new messages.
+	if (!recoveryBuffer.empty())
 	{
-		addMessage();
+		const Message &front = recoveryBuffer.front();
+		if (queueCredits[front.cls] > 0 || front.dest_id == (node_id + 1) % total_nodes)
+		{
+			nextPort->send(new MessageEvent(recoveryBuffer.front()));
+			recoveryBuffer.pop();
+		}
+		generated = 1;
 	}
 
-	// Send a message out every tick if the next nodes queue is not full,
-	// AND if the node has messages in its queue to send.
-	if ((generated != 1 && (queueCredits > 0 && msgqueue.size() > 0)))
+	// A message whose acknowledgement timed out is sent again before new messages.
+	if (reliable && credited && generated != 1)
 	{
-		sendMessage();
-		sendCredits();
+		const Message *due = retransmitBuffer.due(currentCycle, retransmitTimeout);
+		if (due && queueCredits[due->cls] > 0)
+		{
+			output.verbose(CALL_INFO, 2, 0, "Retransmitting message %u to node %d\n", due->seq, due->dest_id);
+			nextPort->send(new MessageEvent(*due));
+			retransmitBuffer.resent(due->seq, currentCycle);
+			retransmits++;
+			generated = 1;
+		}
 	}
-	else if (generated != 1 && !msgqueue.empty())
+
+	// Rng and generate message to send out.
+	if (credited && generated != 1)
+	{
+		addMessage();
+	}
+
+	// Send a message out every tick from the class picked by the arbitration, if the
+	// next node's queue of that class is not full or the message is for the next node.
+	if (generated != 1)
 	{
-		// Peek at the top message to see if it needs to be delivered to the next node.
-		struct Message top = msgqueue.front();
-		if (top.dest_id == (node_id + 1) % total_nodes)
+		int cls = arbitrate();
+		if (cls >= 0)
 		{
-			sendMessage();
-			sendCredits();
+			sendMessage(cls);
+			sendCredits(cls);
 		}
 	}
 
 	generated = 0;
 
+	if (steadyMode != STEADY_OFF && !steadyReached)
+	{
+		checkSteadyState();
+	}
+
 	// Send credits back to previous node.
 	return (false);
 }
@@ -148,24 +373,54 @@ void node::messageHandler(SST::Event *ev)
 		switch (me->msg.type)
 		{
 		case MESSAGE:
+		{
 			output.verbose(CALL_INFO, 2, 0, "is receiving a message from node %d.\n", me->msg.source_id);
 			output.verbose(CALL_INFO, 2, 0, "Message Details: SourceID %d | DestID %d\n", me->msg.source_id, me->msg.dest_id);
+			int cls = me->msg.cls;
+			if (cls >= classes)
+			{
+				output.fatal(CALL_INFO, -1, "Message of class %d, but the node has %d classes\n", cls, classes);
+			}
 
 			// Check if the message is meant for the node and that the node has correct space.
-			if (me->msg.dest_id != node_id && msgqueue.size() < queueMaxSize)
+			if (me->msg.dest_id != node_id && (int)msgqueue[cls].size() < classQueueSize[cls])
 			{
-				// output.verbose(CALL_INFO, 2, 0, "Sending a message. Queue size is now %ld\n", msgqueue.size());
 				output.verbose(CALL_INFO, 2, 0, "Message was added to the queue\n");
-				msgqueue.push(me->msg);
-				sendCredits();
+				msgqueue[cls].push(me->msg);
+				sendCredits(cls);
 			}
 			else if (me->msg.dest_id == node_id)
 			{
-				output.verbose(CALL_INFO, 2, 0, "Consumed a message\n");
+				consume(me->msg);
 			}
-			else if (msgqueue.size() >= queueMaxSize)
+			else
 			{
 				output.verbose(CALL_INFO, 2, 0, "Message was dropped\n");
+				dropped++;
+			}
+			break;
+		}
+		case ACK:
+			sendAck(me->msg);
+			break;
+		case ESCAPE:
+			if (me->msg.dest_id == node_id)
+			{
+				consume(me->msg);
+			}
+			else
+			{
+				nextPort->send(new MessageEvent(me->msg));
+			}
+			break;
+		case RECOVER:
+			if (me->msg.dest_id == node_id)
+			{
+				recover();
+			}
+			else
+			{
+				nextPort->send(new MessageEvent(me->msg));
 			}
 			break;
 		case STATUS:
@@ -178,24 +433,55 @@ void node::messageHandler(SST::Event *ev)
 				// All nodes in the ring have status WAITING, and the initiator node is still in a waiting state. A deadlock has occured.
 				if (me->msg.status == WAITING)
 				{
-					std::cout << getName() << " detected a deadlock. Ending simulation." << std::endl;
-					SST::StopAction exit;
-					exit.execute();
+					if (recoveryMode == RECOVER_STOP)
+					{
+						std::cout << getName() << " detected a deadlock. Ending simulation." << std::endl;
+						SST::StopAction exit;
+						exit.execute();
+					}
+					else if (currentTick >= holdoffUntil)
+					{
+						// The probe's dest_id is the victim, the initiator itself unless another node holds an older message.
+						int victim = me->msg.dest_id;
+						std::cout << getName() << " detected a deadlock. Node " << victim << " recovers." << std::endl;
+						if (victim == node_id)
+						{
+							recover();
+						}
+						else
+						{
+							struct Message recoverMsg = {node_id, victim, WAITING, RECOVER};
+							nextPort->send(new MessageEvent(recoverMsg));
+						}
+						if (recoveringSince < 0)
+						{
+							recoveringSince = currentTick;
+							deadlocks++;
+						}
+						holdoffUntil = currentTick + recoveryHoldoff;
+					}
 				}
 			}
 			else
 			{
 				// 2. The node receives the status WAITING. In this case the previous node(s) is waiting.
 				//	  The current node determines if it can send or if its waiting as well and updates the status before passing the message along.
-				if (me->msg.status == WAITING && queueCredits <= 0)
+				if (me->msg.status == WAITING && !canSend())
 				{
-					struct Message top = msgqueue.front();
-					if (queueCredits <= 0 && top.dest_id != ((node_id + 1) % total_nodes))
+					// The node cannot send out any messages so it passes the WAITING status forward.
+					struct Message statusMsg = {me->msg.source_id, me->msg.dest_id, WAITING, STATUS};
+					if (recoveryVictim == VICTIM_OLDEST)
 					{
-						// The node cannot send out any messages so it passes the WAITING status forward.
-						struct Message statusMsg = {me->msg.source_id, me->msg.dest_id, WAITING, STATUS};
-						nextPort->send(new MessageEvent(statusMsg));
+						// Take over as the victim if the node holds an older message than the nodes before it.
+						statusMsg.born = me->msg.born;
+						int cls = oldestClass();
+						if (cls >= 0 && msgqueue[cls].front().born < statusMsg.born)
+						{
+							statusMsg.dest_id = node_id;
+							statusMsg.born = msgqueue[cls].front().born;
+						}
 					}
+					nextPort->send(new MessageEvent(statusMsg));
 				}
 				else
 				{
@@ -213,24 +499,216 @@ void node::creditHandler(SST::Event *ev)
 	CreditEvent *ce = dynamic_cast<CreditEvent *>(ev);
 	if (ce != NULL)
 	{
-		queueCredits = ce->probe.credits;
+		if (ce->probe.cls >= classes)
+		{
+			output.fatal(CALL_INFO, -1, "Credits for class %d, but the node has %d classes\n", ce->probe.cls, classes);
+		}
+		queueCredits[ce->probe.cls] = ce->probe.credits;
+	}
+	delete ev;
+}
+
+// Count a message that reached its destination, over the ring or the escape channel.
+void node::consume(const Message &msg)
+{
+	output.verbose(CALL_INFO, 2, 0, "Consumed a message\n");
+	int cls = msg.cls;
+	bool first = true;
+	if (msg.seq != 0 && reliable)
+	{
+		// Acknowledge every copy, in case the earlier acknowledgement is still on its way.
+		first = receiveWindows[msg.source_id].accept(msg.seq);
+		if (!first)
+		{
+			duplicates++;
+		}
+		struct Message ack = {node_id, msg.source_id, SENDING, ACK, msg.seq};
+		sendAck(ack);
+	}
+	if (first)
+	{
+		delivered++;
+		classDelivered[cls]++;
+		uint64_t latency = getCurrentSimTime() - msg.born;
+		classLatencySum[cls] += latency;
+		classLatencyMax[cls] = std::max(classLatencyMax[cls], latency);
+	}
+}
+
+// Class whose top message was generated first, -1 if every queue is empty.
+int node::oldestClass() const
+{
+	int oldest = -1;
+	for (int c = 0; c < classes; ++c)
+	{
+		if (!msgqueue[c].empty() && (oldest < 0 || msgqueue[c].front().born < msgqueue[oldest].front().born))
+		{
+			oldest = c;
+		}
+	}
+	return oldest;
+}
+
+// Resolve a deadlock as its victim by taking messages out of the queue with the oldest
+// message, or of the fullest queue when the initiator recovers by itself.
+void node::recover()
+{
+	int cls = recoveryVictim == VICTIM_OLDEST ? std::max(oldestClass(), 0) : 0;
+	if (recoveryVictim == VICTIM_INITIATOR)
+	{
+		for (int c = 1; c < classes; ++c)
+		{
+			if (msgqueue[c].size() > msgqueue[cls].size())
+			{
+				cls = c;
+			}
+		}
+	}
+	std::queue<Message> &queue = msgqueue[cls];
+	if (recoveryMode == RECOVER_DRAIN)
+	{
+		int limit = recoveryDrain > 0 ? recoveryDrain : (int)queue.size();
+		for (int i = 0; i < limit && !queue.empty(); ++i)
+		{
+			recoveryBuffer.push(queue.front());
+			queue.pop();
+			recoveryDrained++;
+		}
+	}
+	else if (!queue.empty())
+	{
+		// A rerouted message goes on to its destination over the escape channel.
+		Message msg = queue.front();
+		queue.pop();
+		if (recoveryMode == RECOVER_DROP)
+		{
+			recoveryDropped++;
+		}
+		else
+		{
+			recoveryRerouted++;
+			msg.type = ESCAPE;
+			nextPort->send(new MessageEvent(msg));
+		}
+	}
+	sendCredits(cls);
+}
+
+// Deliver an acknowledgement to its source, or pass it along without queueing. ACKs use
+// neither the queues nor the credits, like STATUS probes, so they still reach their source
+// when the ring is deadlocked. A full ring would otherwise block the acknowledgements that
+// free its retransmit windows.
+void node::sendAck(const Message &ack)
+{
+	if (ack.dest_id != node_id)
+	{
+		nextPort->send(new MessageEvent(ack));
+	}
+	else if (!retransmitBuffer.ack(ack.seq))
+	{
+		output.verbose(CALL_INFO, 2, 0, "Acknowledgement of message %u was a duplicate\n", ack.seq);
+	}
+}
+
+// Report the steady state once the node's throughput and queue size have converged.
+void node::checkSteadyState()
+{
+	double samples[2] = {(double)(delivered - lastDelivered), (double)queuedMessages()};
+	lastDelivered = delivered;
+	if (!steady.add(samples))
+	{
+		return;
+	}
+	steadyReached = true;
+	SteadyState::Estimate throughput = steady.estimate(0);
+	SteadyState::Estimate queue = steady.estimate(1);
+	output.output(CALL_INFO, "Steady state at %" PRIu64 ": delivered %.4f +- %.4f messages per tick | queue size %.2f +- %.2f\n", getCurrentSimTime(), throughput.mean, throughput.half, queue.mean, queue.half);
+	if (steadyMode == STEADY_END)
+	{
+		primaryComponentOKToEndSim();
+	}
+}
+
+// Whether the top of a class's queue can go out: the next node has room in that class, or
+// the message is for the next node and is consumed there.
+bool node::canSend(int cls) const
+{
+	return !msgqueue[cls].empty() && (queueCredits[cls] > 0 || msgqueue[cls].front().dest_id == (node_id + 1) % total_nodes);
+}
+
+// Whether the node can send anything, a new message in a class with credits or a queued one.
+bool node::canSend() const
+{
+	for (int c = 0; c < classes; ++c)
+	{
+		if (queueCredits[c] > 0 || canSend(c))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Pick the class that sends from its queue this tick, -1 if none can.
+int node::arbitrate()
+{
+	if (arbitration == ARBITRATE_PRIORITY)
+	{
+		// Class 0 first.
+		for (int c = 0; c < classes; ++c)
+		{
+			if (canSend(c))
+			{
+				return c;
+			}
+		}
+		return -1;
+	}
+	// Weighted round-robin: a class keeps its turn for class_weights sends while it can send.
+	int start = wrrLeft > 0 ? wrrClass : (wrrClass + 1) % classes;
+	for (int k = 0; k < classes; ++k)
+	{
+		int c = (start + k) % classes;
+		if (!canSend(c))
+		{
+			continue;
+		}
+		if (c != wrrClass || wrrLeft <= 0)
+		{
+			wrrClass = c;
+			wrrLeft = classWeight[c];
+		}
+		wrrLeft--;
+		return c;
+	}
+	return -1;
+}
+
+// Messages queued over all classes.
+int node::queuedMessages() const
+{
+	int queued = 0;
+	for (const std::queue<Message> &queue : msgqueue)
+	{
+		queued += queue.size();
 	}
+	return queued;
 }
 
 // Simulate sending a single message out to linked component in composition.
-void node::sendMessage()
+void node::sendMessage(int cls)
 {
-	struct Message msg = msgqueue.front();
-	msgqueue.pop();
+	struct Message msg = msgqueue[cls].front();
+	msgqueue[cls].pop();
 	nextPort->send(new MessageEvent(msg));
 }
 
-// Send number of credits left to the previous node.
-void node::sendCredits()
+// Send number of credits left in a class's queue to the previous node.
+void node::sendCredits(int cls)
 {
 	// Construct credit message to send.
 	output.verbose(CALL_INFO, 2, 0, "Sending credits\n");
-	struct CreditProbe creds = {queueMaxSize - (int)msgqueue.size()};
+	struct CreditProbe creds = {classQueueSize[cls] - (int)msgqueue[cls].size(), cls};
 	prevPort->send(new CreditEvent(creds));
 }
 
@@ -239,6 +717,13 @@ void node::addMessage()
 {
 	rndNumber = (rng->nextUniform());
 
+	// A reliable source holds back new messages while its whole window is unacknowledged.
+	if (reliable && retransmitBuffer.full())
+	{
+		windowStalls++;
+		return;
+	}
+
 	// Force a deadlock to occur quicker by increasing the chance of more messages entering the ring topology.
 	if (rndNumber <= message_gen)
 	{
@@ -250,6 +735,25 @@ void node::addMessage()
 		rndNode = abs((int)(rndNode % total_nodes)); // Generate a integer 0-(Total Nodes - 1)
 		output.verbose(CALL_INFO, 2, 0, "Generating a message.\n");
 		struct Message newMsg = {node_id, rndNode, SENDING, MESSAGE};
+
+		newMsg.born = getCurrentSimTime();
+
+		// Pick the class by class_mix. A message whose class has no credits is dropped at the source.
+		if (classes > 1)
+		{
+			double rndClass = rng->nextUniform();
+			newMsg.cls = std::upper_bound(classMix.begin(), classMix.end() - 1, rndClass) - classMix.begin();
+		}
+		if (queueCredits[newMsg.cls] <= 0)
+		{
+			classSourceDropped[newMsg.cls]++;
+			generated = 0;
+			return;
+		}
+		if (reliable)
+		{
+			retransmitBuffer.push(newMsg, currentTick);
+		}
 		nextPort->send(new MessageEvent(newMsg));
 	}
 }
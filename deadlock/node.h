@@ -6,7 +6,10 @@
 #include <sst/core/link.h>
 #include <sst/core/rng/marsaglia.h>
 #include <queue>
+#include <vector>
 #include "CommunicationEvents.h"
+#include "SteadyState.h"
+#include "Reliability.h"
 
 /**
  * @brief Node Component Class. The Node generates or passes along messages in its queue
@@ -93,7 +96,24 @@ public:
 		{"tickFreq", "The frequency the component is called at.", "10s"},
 		{"id", "ID for the node.", "1"},
 		{"total_nodes", "Number of nodes in simulation.", "1"},
-		{"message_gen", "1/message_gen chance that a message is generated by a node instead of it sending one out of its queue."}
+		{"message_gen", "1/message_gen chance that a message is generated by a node instead of it sending one out of its queue."},
+		{"steady_state", "Steady state detection from the node's delivered throughput and queue size. 'off', 'report' prints the metrics once they converge, 'end' also lets the simulation end. The simulation ends once every node agrees.", "off"},
+		{"steady_batch", "Ticks averaged into one batch of the steady state monitor.", "500"},
+		{"steady_batches", "Batches in the steady state monitor's sliding window.", "20"},
+		{"steady_tolerance", "Relative half width of the confidence intervals, and drift across the window, at which the metrics have converged.", "0.1"},
+		{"steady_queue_floor", "Queue size in messages below which the queue size tolerance is absolute, steady_tolerance times this.", "5"},
+		{"recovery", "What happens once the initiator detects a deadlock. 'stop' ends the simulation, 'drop' drops the message at the top of the victim's queue, 'reroute' passes it on to its destination over an escape channel that bypasses the queues and credits, where it counts as delivered, 'drain' moves the victim's queue to a recovery buffer that is sent out first. The simulation continues after a recovery.", "stop"},
+		{"recovery_drain", "Messages moved to the recovery buffer with 'drain'. 0 drains the whole queue.", "0"},
+		{"recovery_holdoff", "Ticks after a recovery before another one, so the STATUS probes already in flight do not trigger it again.", "10"},
+		{"recovery_victim", "Which node in the deadlock recovers. 'oldest' the node with the oldest message at the top of a queue, found by the STATUS probe, 'initiator' the initiator itself. Every node must agree.", "oldest"},
+		{"reliable", "Give the node's messages sequence numbers, acknowledge them at their destination and retransmit the ones lost to a full queue. Every node must agree.", "0"},
+		{"retransmit_window", "Messages a reliable node may have unacknowledged at once, at most 64. It generates nothing while the window is full.", "16"},
+		{"retransmit_timeout", "Ticks without an acknowledgement after which a message is retransmitted.", "200"},
+		{"classes", "Number of traffic classes, at most 16. Each has its own queue and credits. Every node must agree.", "1"},
+		{"class_queue_sizes", "Queue size of every class, e.g. [10, 100].", "queueMaxSize for every class"},
+		{"class_mix", "Relative share of every class in the generated messages, e.g. [1, 9].", "Equal shares"},
+		{"arbitration", "Which class sends from its queue on a tick. 'priority' takes the lowest class that can send, 'wrr' takes turns of class_weights sends per class.", "priority"},
+		{"class_weights", "Sends per turn of every class with 'wrr'.", "1 for every class"}
 	)
 
 	/**
@@ -111,10 +131,10 @@ public:
 private:
 	SST::Output output; //!< SST Output object for printing to the console.
 
-	std::queue<Message> msgqueue; //!< Queue that stores Message structures.
+	std::vector<std::queue<Message>> msgqueue; //!< Queue that stores Message structures, one per traffic class.
 	int queueMaxSize; //!< Maximum size of node's queue.
 	int queueCurrSize; //!< Current size of node's queue.
-	int queueCredits; //!< Amount of space left in the connected node's queue. 
+	std::vector<int> queueCredits; //!< Amount of space left in the connected node's queue of every class.
 
 	float message_gen; //!< Probability that a message is generated by a node.
 	float rndNumber; //!< Randomly generated number for message gen.
@@ -125,14 +145,89 @@ private:
 	int node_id; //!< User's ID for each node. Unrelated to simulator's ID for the component. 
 	int total_nodes; //!< Total number of nodes in simulation.
 
-	void sendMessage(); //!< Sends a single message across a link from one node to a connected node.
-	void sendCredits(); //!< Sends number of credits to previous connected node.
+	void sendMessage(int cls); //!< Sends a single message of a class across a link from one node to a connected node.
+	void sendCredits(int cls); //!< Sends number of credits of a class to previous connected node.
 	void addMessage(); 	//!< Utilize RNG to generate a message and send it out from a node.
 
 	SST::Link *nextPort; //!< Pointer to node's port that messages will be sent to.
 	SST::Link *prevPort; //!< Pointer to node's port that will receive credit information.
 
 	std::string clock; //!< Node's clock which accepts unit math as a string. (i.e "1ms").
+
+	uint64_t delivered; //!< Number of messages consumed by the node.
+	uint64_t lastDelivered; //!< Value of delivered at the last tick.
+	/**
+	 * @brief What the steady state monitor does once the metrics converge.
+	 */
+	enum SteadyMode { STEADY_OFF, STEADY_REPORT, STEADY_END };
+
+	SteadyMode steadyMode; //!< Whether the steady state monitor runs and whether it lets the simulation end.
+	SteadyState steady; //!< Batch means of the delivered throughput and the queue size.
+	bool steadyReached; //!< Whether the steady state was reported.
+
+	void checkSteadyState(); //!< Feed the steady state monitor this tick's throughput and queue size.
+
+	/**
+	 * @brief What the initiator does once a STATUS probe comes back WAITING.
+	 */
+	enum RecoveryMode { RECOVER_STOP, RECOVER_DROP, RECOVER_REROUTE, RECOVER_DRAIN };
+
+	/**
+	 * @brief Which node in the deadlock frees its queue.
+	 */
+	enum RecoveryVictim { VICTIM_OLDEST, VICTIM_INITIATOR };
+
+	RecoveryMode recoveryMode; //!< Whether a deadlock ends the simulation or how it is resolved.
+	RecoveryVictim recoveryVictim; //!< How the victim of a deadlock is picked.
+	int recoveryDrain; //!< Messages moved to the recovery buffer by 'drain', 0 for the whole queue.
+	int recoveryHoldoff; //!< Ticks between recoveries.
+	std::queue<Message> recoveryBuffer; //!< Messages drained from the queue by a deadlock recovery, outside the queue's capacity.
+	SST::Cycle_t currentTick; //!< Cycle of the node's latest tick.
+	SST::Cycle_t holdoffUntil; //!< Tick the next recovery may happen at.
+	int64_t recoveringSince; //!< Tick of the first recovery of the current deadlock, -1 when not deadlocked.
+	uint64_t deadlocks; //!< Number of deadlocks the node detected and had recovered.
+	uint64_t recoveryCycles; //!< Sum of the ticks until the initiator had credits again after each deadlock.
+	uint64_t recoveryDropped; //!< Messages the node dropped as the victim of a deadlock.
+	uint64_t recoveryRerouted; //!< Messages the node sent to their destination over the escape channel as the victim of a deadlock.
+	uint64_t recoveryDrained; //!< Messages the node moved to the recovery buffer as the victim of a deadlock.
+
+	int oldestClass() const; //!< Class whose top message is the oldest, -1 if every queue is empty.
+	void recover(); //!< Resolve a deadlock as its victim by taking messages out of a queue.
+	void consume(const Message &msg); //!< Count a message that reached its destination, over the ring or the escape channel.
+
+	bool reliable; //!< Whether the reliability layer is on.
+	int retransmitWindow; //!< Most messages unacknowledged at once.
+	SST::Cycle_t retransmitTimeout; //!< Ticks before an unacknowledged message is sent again.
+	RetransmitBuffer<Message> retransmitBuffer; //!< Sent messages waiting for their acknowledgement.
+	std::vector<ReceiveWindow> receiveWindows; //!< Sequence numbers received from every source.
+	uint64_t dropped; //!< Messages dropped because the queue was full.
+	uint64_t retransmits; //!< Messages sent again after a timeout.
+	uint64_t duplicates; //!< Copies of messages that were already delivered.
+	uint64_t windowStalls; //!< Ticks in which no message could be generated because the window was full.
+
+	void sendAck(const Message &ack); //!< Deliver an acknowledgement to its source, or pass it along.
+
+	/**
+	 * @brief How the class that sends from its queue is picked.
+	 */
+	enum Arbitration { ARBITRATE_PRIORITY, ARBITRATE_WRR };
+
+	int classes; //!< Number of traffic classes.
+	std::vector<int> classQueueSize; //!< Maximum queue size of every class.
+	std::vector<double> classMix; //!< Cumulative share of every class in the generated messages.
+	std::vector<int> classWeight; //!< Sends per weighted round-robin turn of every class.
+	Arbitration arbitration; //!< Arbitration policy between the classes.
+	int wrrClass; //!< Class holding the weighted round-robin turn.
+	int wrrLeft; //!< Sends left in the current turn.
+	std::vector<uint64_t> classDelivered; //!< Messages of every class consumed by the node.
+	std::vector<uint64_t> classLatencySum; //!< Sum of the latencies of the consumed messages of every class, in simulation time units.
+	std::vector<uint64_t> classLatencyMax; //!< Largest latency of every class.
+	std::vector<uint64_t> classSourceDropped; //!< Generated messages of every class dropped at the source because the class had no credits.
+
+	bool canSend(int cls) const; //!< Whether the top of a class's queue can be sent this tick.
+	bool canSend() const; //!< Whether the node can send anything this tick.
+	int arbitrate(); //!< Class that sends from its queue this tick, -1 if none can.
+	int queuedMessages() const; //!< Messages queued over all classes.
 };
 
 #endif
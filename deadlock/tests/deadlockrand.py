@@ -4,14 +4,17 @@ import sst
 import random
 
 NUM_NODES = 5  # Number of nodes
+SEED = 1234  # Seed for randomized parameters.
 
 # Node parameters are randomly generated between the two ranges for queue size and tick frequency.
 QUEUE_MIN_SIZE = 80  # Minimum possible queue size
 QUEUE_MAX_SIZE = 120  # Maximum possible queue size.
 TICK_MIN_FREQ = 2  # Minimum tick frequency of nodes.
 TICK_MAX_FREQ = 5  # Maximum tick frequency of nodes.
+RELIABLE = 0  # 1 retransmits the messages lost to full queues, to compare the throughput.
+STEADY_STATE = "end"  # End runs that settle without deadlock, "report" or "off" to run on.
 
-random.seed  # Create rng seed.
+random.seed(SEED)  # Seed the parameter rng so runs are reproducible.
 
 nodes = dict()  # Create a dictionary of nodes for
 
@@ -24,6 +27,8 @@ for x in range(NUM_NODES):
             "tickFreq": f"{random.randint(TICK_MIN_FREQ, TICK_MAX_FREQ)}ms",
             "id": f"{x}",
             "total_nodes": f"{NUM_NODES}",
+            "reliable": f"{RELIABLE}",
+            "steady_state": STEADY_STATE,
         }
     )
 